@@ -0,0 +1,14 @@
+{
+  "targets": [
+    {
+      "target_name": "keystone",
+      "sources": [ "src/keystone.cc" ],
+      "include_dirs": [ "../../include" ],
+      "libraries": [ "-lkeystone" ],
+      "cflags_cc": [ "-std=c++11" ],
+      "xcode_settings": {
+        "OTHER_CPLUSPLUSFLAGS": [ "-std=c++11" ]
+      }
+    }
+  ]
+}
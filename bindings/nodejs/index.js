@@ -1,52 +1,32 @@
-var ref = require('ref'),
-    ffi = require('ffi'),
+var binding = require('./build/Release/keystone.node'),
     consts = require('./consts'),
     extend = require('util')._extend
 
-var ks_engine = 'void',
-    ks_enginePtr = ref.refType(ks_engine),
-    ks_enginePtrPtr = ref.refType(ks_enginePtr),
-    ks_arch = 'int',
-    ks_err = 'int',
-    ks_opt_type = 'int',
-    uintPtr = ref.refType('uint'),
-    ucharPtr = ref.refType('uchar'),
-    ucharPtrPtr = ref.refType(ucharPtr),
-    size_tPtr = ref.refType('size_t'),
-    stringPtr = ref.refType('string')
-
-var Keystone = ffi.Library('libkeystone', {
-  'ks_version': [ 'uint', [ uintPtr, uintPtr ] ],
-  'ks_arch_supported': [ 'bool', [ ks_arch ] ],
-  'ks_open': [ ks_err, [ ks_arch, 'int', ks_enginePtrPtr ] ],
-  'ks_close': [ ks_err, [ ks_enginePtr ] ],
-  'ks_errno': [ 'int', [ ks_enginePtr ] ],
-  'ks_strerror': [ 'string', [ ks_err ] ],
-  'ks_option': [ ks_err, [ ks_enginePtr, ks_opt_type, 'size_t' ] ],
-  'ks_asm': [ 'int', [ ks_enginePtr, 'string', 'uint64', ucharPtrPtr, size_tPtr, size_tPtr ] ],
-  'ks_free': [ 'void', [ 'pointer' ] ]
-})
-
 function KsError(message, errno, count) {
   this.message = message
   this.errno = errno
   this.count = count
 }
 
-function Ks(arch, mode) {
-  var _ks = ref.alloc(ks_enginePtr),
-      err = Keystone.ks_open(arch, mode, _ks)
+function toKsError(e) {
+  return new KsError(e.message, e.errno, e.count)
+}
 
-  if (err !== consts.ERR_OK) {
+function Ks(arch, mode) {
+  try {
+    this._ks = binding.open(arch, mode)
+  } catch (e) {
     this._ks = null
     throw new KsError('Error: failed on ks_open()')
   }
 
-  this._ks = _ks.deref()
-  
+  this.arch = arch
+  this.mode = mode
+  // replayed on the engines of the threadpool by assembleAsync()
+  this._options = []
 
   this.__defineGetter__('errno', function() {
-    return Keystone.ks_errno(this._ks)
+    return binding.errno(this._ks)
   })
 
   this.__defineSetter__('syntax', function(value) {
@@ -54,44 +34,46 @@ function Ks(arch, mode) {
   })
 }
 
+// Assemble code at addr (a Number or a BigInt). Returns the encoding in a
+// Buffer over Keystone's own memory, and the number of statements.
 Ks.prototype.asm = function(code, addr) {
-  var encoding = ref.alloc('uchar *'),
-      size = ref.alloc('size_t'),
-      count = ref.alloc('size_t'),
-      err, msg 
-
-  if (Keystone.ks_asm(this._ks, code, addr || 0, encoding, size, count) !== consts.ERR_OK) {
-    err = this.errno
-    msg = Keystone.ks_strerror(err)
-    throw new KsError(msg, err, count.deref())
+  try {
+    return binding.asm(this._ks, code, addr || 0)
+  } catch (e) {
+    throw toKsError(e)
   }
+}
 
-  return {
-    encoding: ref.reinterpret(encoding.deref(), size.deref(), 0),
-    count: count.deref()
-  }
+// Same as asm(), but assemble on the libuv threadpool so that the event
+// loop keeps running. Each worker thread has its own engine with the same
+// arch, mode and options. Returns a Promise of { encoding, count }.
+Ks.prototype.assembleAsync = function(code, addr) {
+  return binding.asmAsync(this.arch, this.mode, this._options, code, addr || 0)
+    .catch(function(e) { throw toKsError(e) })
 }
 
 Ks.prototype.close = function() {
-  Keystone.ks_close(this._ks)
+  binding.close(this._ks)
   this._ks = null
 }
 
 Ks.prototype.set_option = function(type, value) {
-  var err = Keystone.ks_option(this._ks, type, value)
-  if (err != consts.ERR_OK) {
-    throw new KsError(Keystone.ks_strerror(err), err)
+  try {
+    binding.option(this._ks, type, value)
+  } catch (e) {
+    throw new KsError(e.message, e.errno)
   }
+  this._options.push([type, value])
 }
 
 module.exports.Ks = Ks
 
 module.exports.is_arch_supported = function(arch) {
-  return Keystone.ks_arch_supported(arch)
+  return binding.archSupported(arch)
 }
 
 module.exports.__defineGetter__('version', function() {
-  var version = Keystone.ks_version(null, null)
+  var version = binding.version()
   return {
     major: version >> 8,
     minor: version & 255
@@ -23,5 +23,12 @@ ks.syntax = keystone.OPT_SYNTAX_NASM
 result = ks.asm(assembly)
 console.log('"' + assembly.replace(/\n/g, '; ') + '"', ':', result.encoding)
 
-// Close Keystone instance to free resources
-ks.close()
+// Assemble on the libuv threadpool without blocking the event loop
+// (still in NASM syntax, where ; starts a comment)
+assembly = 'mov rax, 1\nret'
+ks.assembleAsync(assembly).then(function(result) {
+  console.log('"' + assembly.replace(/\n/g, '; ') + '"', ':', result.encoding)
+
+  // Close Keystone instance to free resources
+  ks.close()
+})
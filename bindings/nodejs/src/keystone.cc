@@ -0,0 +1,363 @@
+// Node.js binding for Keystone engine, on N-API.
+//
+// Results of the synchronous asm() are Buffers over the memory returned by
+// ks_asm(), released with ks_free() when the Buffer is collected. The async
+// variant assembles on the libuv threadpool with engines private to each
+// worker thread, opened on first use with the same arch, mode & options
+// and closed again once they fall out of a small per-thread cache.
+
+#include <list>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <node_api.h>
+
+#include <keystone/keystone.h>
+
+#define CHECK(call)                                                        \
+  do {                                                                     \
+    if ((call) != napi_ok)                                                 \
+      return nullptr;                                                      \
+  } while (0)
+
+namespace {
+
+typedef std::vector<std::pair<int64_t, int64_t>> OptionList;
+
+// Engines of one worker thread, by arch, mode & options. Only the few most
+// recently used ones are kept open.
+class ThreadEngines {
+ public:
+  ~ThreadEngines() {
+    for (auto &E : Engines)
+      ks_close(E.second);
+  }
+
+  ks_engine *get(int arch, int mode, const OptionList &options, ks_err &err) {
+    std::string key = std::to_string(arch) + ":" + std::to_string(mode);
+    for (auto &O : options)
+      key += ":" + std::to_string(O.first) + "=" + std::to_string(O.second);
+
+    for (auto I = Engines.begin(); I != Engines.end(); ++I)
+      if (I->first == key) {
+        Engines.splice(Engines.begin(), Engines, I);
+        return I->second;
+      }
+
+    ks_engine *ks;
+    err = ks_open((ks_arch)arch, mode, &ks);
+    if (err != KS_ERR_OK)
+      return nullptr;
+    for (auto &O : options) {
+      err = ks_option(ks, (ks_opt_type)O.first, (size_t)O.second);
+      if (err != KS_ERR_OK) {
+        ks_close(ks);
+        return nullptr;
+      }
+    }
+
+    if (Engines.size() == MaxEngines) {
+      ks_close(Engines.back().second);
+      Engines.pop_back();
+    }
+    Engines.emplace_front(key, ks);
+    return ks;
+  }
+
+ private:
+  static const size_t MaxEngines = 4;
+
+  // most recently used first
+  std::list<std::pair<std::string, ks_engine *>> Engines;
+};
+
+thread_local ThreadEngines Workers;
+
+struct AsmWork {
+  napi_async_work work = nullptr;
+  napi_deferred deferred = nullptr;
+  int arch = 0, mode = 0;
+  OptionList options;
+  std::string code;
+  uint64_t address = 0;
+  // results
+  unsigned int err = KS_ERR_OK;
+  unsigned char *encoding = nullptr;
+  size_t size = 0, count = 0;
+};
+
+ks_engine *getEngine(napi_env env, napi_value value) {
+  void *ks = nullptr;
+  if (napi_get_value_external(env, value, &ks) != napi_ok || !ks)
+    napi_throw_type_error(env, nullptr, "Keystone engine is closed");
+  return (ks_engine *)ks;
+}
+
+std::string getString(napi_env env, napi_value value) {
+  size_t length = 0;
+  std::string s;
+  if (napi_get_value_string_utf8(env, value, nullptr, 0, &length) != napi_ok)
+    return s;
+  s.resize(length + 1);
+  napi_get_value_string_utf8(env, value, &s[0], length + 1, &length);
+  s.resize(length);
+  return s;
+}
+
+uint64_t getAddress(napi_env env, napi_value value) {
+  napi_valuetype type;
+  napi_typeof(env, value, &type);
+  if (type == napi_bigint) {
+    uint64_t address = 0;
+    bool lossless;
+    napi_get_value_bigint_uint64(env, value, &address, &lossless);
+    return address;
+  }
+  int64_t address = 0;
+  napi_get_value_int64(env, value, &address);
+  return (uint64_t)address;
+}
+
+// { encoding: Buffer, count: Number }, taking ownership of encoding.
+// On failure, throws and returns nullptr, with encoding released.
+napi_value makeResult(napi_env env, unsigned char *encoding, size_t size,
+                      size_t count) {
+  napi_value result, buffer, n;
+  napi_status status;
+  if (size == 0) {
+    ks_free(encoding);
+    status = napi_create_buffer(env, 0, nullptr, &buffer);
+  } else {
+    status = napi_create_external_buffer(
+        env, size, encoding,
+        [](napi_env, void *data, void *) { ks_free((unsigned char *)data); },
+        nullptr, &buffer);
+    if (status != napi_ok)
+      ks_free(encoding);
+  }
+
+  // from here on, the Buffer owns encoding
+  if (status != napi_ok || napi_create_object(env, &result) != napi_ok ||
+      napi_set_named_property(env, result, "encoding", buffer) != napi_ok ||
+      napi_create_double(env, (double)count, &n) != napi_ok ||
+      napi_set_named_property(env, result, "count", n) != napi_ok) {
+    napi_throw_error(env, nullptr, "cannot create assembly result");
+    return nullptr;
+  }
+  return result;
+}
+
+napi_value makeError(napi_env env, unsigned int err, size_t count) {
+  napi_value error, message, n;
+  CHECK(napi_create_string_utf8(env, ks_strerror((ks_err)err),
+                                NAPI_AUTO_LENGTH, &message));
+  CHECK(napi_create_error(env, nullptr, message, &error));
+  CHECK(napi_create_uint32(env, err, &n));
+  CHECK(napi_set_named_property(env, error, "errno", n));
+  CHECK(napi_create_double(env, (double)count, &n));
+  CHECK(napi_set_named_property(env, error, "count", n));
+  return error;
+}
+
+// open(arch, mode) -> engine
+napi_value Open(napi_env env, napi_callback_info info) {
+  size_t argc = 2;
+  napi_value argv[2], engine;
+  int32_t arch = 0, mode = 0;
+  CHECK(napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr));
+  napi_get_value_int32(env, argv[0], &arch);
+  napi_get_value_int32(env, argv[1], &mode);
+
+  ks_engine *ks;
+  ks_err err = ks_open((ks_arch)arch, mode, &ks);
+  if (err != KS_ERR_OK) {
+    napi_throw(env, makeError(env, err, 0));
+    return nullptr;
+  }
+
+  CHECK(napi_create_external(env, ks, nullptr, nullptr, &engine));
+  return engine;
+}
+
+// close(engine)
+napi_value Close(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1];
+  CHECK(napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr));
+  ks_engine *ks = getEngine(env, argv[0]);
+  if (ks)
+    ks_close(ks);
+  return nullptr;
+}
+
+// option(engine, type, value)
+napi_value Option(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value argv[3];
+  int64_t type = 0, value = 0;
+  CHECK(napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr));
+  ks_engine *ks = getEngine(env, argv[0]);
+  if (!ks)
+    return nullptr;
+  napi_get_value_int64(env, argv[1], &type);
+  napi_get_value_int64(env, argv[2], &value);
+
+  ks_err err = ks_option(ks, (ks_opt_type)type, (size_t)value);
+  if (err != KS_ERR_OK)
+    napi_throw(env, makeError(env, err, 0));
+  return nullptr;
+}
+
+// errno(engine) -> Number
+napi_value Errno(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1], result;
+  CHECK(napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr));
+  ks_engine *ks = getEngine(env, argv[0]);
+  if (!ks)
+    return nullptr;
+  CHECK(napi_create_uint32(env, ks_errno(ks), &result));
+  return result;
+}
+
+// asm(engine, code, address) -> { encoding, count }
+napi_value Asm(napi_env env, napi_callback_info info) {
+  size_t argc = 3;
+  napi_value argv[3];
+  CHECK(napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr));
+  ks_engine *ks = getEngine(env, argv[0]);
+  if (!ks)
+    return nullptr;
+  std::string code = getString(env, argv[1]);
+  uint64_t address = argc > 2 ? getAddress(env, argv[2]) : 0;
+
+  unsigned char *encoding;
+  size_t size = 0, count = 0;
+  if (ks_asm(ks, code.c_str(), address, &encoding, &size, &count) != 0) {
+    napi_throw(env, makeError(env, ks_errno(ks), count));
+    return nullptr;
+  }
+
+  return makeResult(env, encoding, size, count);
+}
+
+void ExecuteAsm(napi_env, void *data) {
+  AsmWork *w = (AsmWork *)data;
+  ks_err err = KS_ERR_OK;
+  ks_engine *ks = Workers.get(w->arch, w->mode, w->options, err);
+  if (!ks) {
+    w->err = err;
+    return;
+  }
+  if (ks_asm(ks, w->code.c_str(), w->address, &w->encoding, &w->size,
+             &w->count) != 0)
+    w->err = ks_errno(ks);
+}
+
+void CompleteAsm(napi_env env, napi_status, void *data) {
+  AsmWork *w = (AsmWork *)data;
+  if (w->err != KS_ERR_OK) {
+    napi_reject_deferred(env, w->deferred, makeError(env, w->err, w->count));
+  } else {
+    napi_value result = makeResult(env, w->encoding, w->size, w->count);
+    if (result) {
+      napi_resolve_deferred(env, w->deferred, result);
+    } else {
+      napi_value error;
+      napi_get_and_clear_last_exception(env, &error);
+      napi_reject_deferred(env, w->deferred, error);
+    }
+  }
+  napi_delete_async_work(env, w->work);
+  delete w;
+}
+
+// asmAsync(arch, mode, [[type, value]...], code, address) -> Promise
+napi_value AsmAsync(napi_env env, napi_callback_info info) {
+  size_t argc = 5;
+  napi_value argv[5], promise, name;
+  CHECK(napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr));
+
+  AsmWork *w = new AsmWork;
+  napi_get_value_int32(env, argv[0], &w->arch);
+  napi_get_value_int32(env, argv[1], &w->mode);
+  uint32_t n = 0;
+  napi_get_array_length(env, argv[2], &n);
+  for (uint32_t i = 0; i < n; i++) {
+    napi_value pair, v;
+    int64_t type = 0, value = 0;
+    napi_get_element(env, argv[2], i, &pair);
+    napi_get_element(env, pair, 0, &v);
+    napi_get_value_int64(env, v, &type);
+    napi_get_element(env, pair, 1, &v);
+    napi_get_value_int64(env, v, &value);
+    w->options.push_back(std::make_pair(type, value));
+  }
+  w->code = getString(env, argv[3]);
+  w->address = argc > 4 ? getAddress(env, argv[4]) : 0;
+
+  if (napi_create_promise(env, &w->deferred, &promise) != napi_ok ||
+      napi_create_string_utf8(env, "keystone:asm", NAPI_AUTO_LENGTH,
+                              &name) != napi_ok ||
+      napi_create_async_work(env, nullptr, name, ExecuteAsm, CompleteAsm, w,
+                             &w->work) != napi_ok ||
+      napi_queue_async_work(env, w->work) != napi_ok) {
+    delete w;
+    napi_throw_error(env, nullptr, "cannot queue assembly work");
+    return nullptr;
+  }
+
+  return promise;
+}
+
+// version() -> Number, as ks_version()
+napi_value Version(napi_env env, napi_callback_info) {
+  napi_value result;
+  CHECK(napi_create_uint32(env, ks_version(nullptr, nullptr), &result));
+  return result;
+}
+
+// archSupported(arch) -> Boolean
+napi_value ArchSupported(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1], result;
+  int32_t arch = 0;
+  CHECK(napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr));
+  napi_get_value_int32(env, argv[0], &arch);
+  CHECK(napi_get_boolean(env, ks_arch_supported((ks_arch)arch), &result));
+  return result;
+}
+
+// strerror(code) -> String
+napi_value StrError(napi_env env, napi_callback_info info) {
+  size_t argc = 1;
+  napi_value argv[1], result;
+  uint32_t code = 0;
+  CHECK(napi_get_cb_info(env, info, &argc, argv, nullptr, nullptr));
+  napi_get_value_uint32(env, argv[0], &code);
+  CHECK(napi_create_string_utf8(env, ks_strerror((ks_err)code),
+                                NAPI_AUTO_LENGTH, &result));
+  return result;
+}
+
+napi_value Init(napi_env env, napi_value exports) {
+  napi_property_descriptor props[] = {
+      {"open", nullptr, Open, nullptr, nullptr, nullptr, napi_default, nullptr},
+      {"close", nullptr, Close, nullptr, nullptr, nullptr, napi_default, nullptr},
+      {"option", nullptr, Option, nullptr, nullptr, nullptr, napi_default, nullptr},
+      {"errno", nullptr, Errno, nullptr, nullptr, nullptr, napi_default, nullptr},
+      {"asm", nullptr, Asm, nullptr, nullptr, nullptr, napi_default, nullptr},
+      {"asmAsync", nullptr, AsmAsync, nullptr, nullptr, nullptr, napi_default, nullptr},
+      {"version", nullptr, Version, nullptr, nullptr, nullptr, napi_default, nullptr},
+      {"archSupported", nullptr, ArchSupported, nullptr, nullptr, nullptr, napi_default, nullptr},
+      {"strerror", nullptr, StrError, nullptr, nullptr, nullptr, napi_default, nullptr},
+  };
+  CHECK(napi_define_properties(env, exports, sizeof(props) / sizeof(props[0]),
+                               props));
+  return exports;
+}
+
+} // end anonymous namespace
+
+NAPI_MODULE(NODE_GYP_MODULE_NAME, Init)
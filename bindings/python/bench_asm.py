@@ -0,0 +1,68 @@
+#!/usr/bin/env python
+# Keystone Python bindings: throughput of Ks.asm() & Ks.asm_many(),
+# single-threaded and with one engine per thread.
+
+from __future__ import print_function
+import threading
+import time
+
+from keystone import *
+from keystone.keystone import _ks
+from ctypes import POINTER, byref, c_size_t, c_ubyte
+
+CODE = b"push rbp; mov rbp, rsp; sub rsp, 0x20; mov qword ptr [rbp - 8], rdi; " \
+       b"lea rax, [rip + 0x1000]; add rax, rcx; pop rbp; ret"
+TOTAL = 20000
+
+
+# what asm() used to do: one Python call per byte of the result
+def asm_byte_loop(ks, string, addr=0):
+    encode = POINTER(c_ubyte)()
+    encode_size = c_size_t()
+    stat_count = c_size_t()
+    if _ks.ks_asm(ks._ksh, string, addr, byref(encode), byref(encode_size), byref(stat_count)) != 0:
+        raise KsError(_ks.ks_errno(ks._ksh))
+    encoding = []
+    for i in range(encode_size.value):
+        encoding.append(encode[i])
+    _ks.ks_free(encode)
+    return (encoding, stat_count.value)
+
+
+def run(name, threads, work):
+    def worker():
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+        work(ks, TOTAL // threads)
+
+    pool = [threading.Thread(target=worker) for _ in range(threads)]
+    start = time.time()
+    for t in pool:
+        t.start()
+    for t in pool:
+        t.join()
+    elapsed = time.time() - start
+    print("%-28s %d thread(s): %8.0f calls/s" % (name, threads, TOTAL / elapsed))
+
+
+def byte_loop(ks, n):
+    for i in range(n):
+        asm_byte_loop(ks, CODE, 0x1000)
+
+def asm_list(ks, n):
+    for i in range(n):
+        ks.asm(CODE, 0x1000)
+
+def asm_bytes(ks, n):
+    for i in range(n):
+        ks.asm(CODE, 0x1000, as_bytes=True)
+
+def asm_many_bytes(ks, n):
+    ks.asm_many([(CODE, 0x1000)] * n, as_bytes=True)
+
+
+if __name__ == '__main__':
+    for threads in (1, 4):
+        run("per-byte list (old asm)", threads, byte_loop)
+        run("asm()", threads, asm_list)
+        run("asm(as_bytes=True)", threads, asm_bytes)
+        run("asm_many(as_bytes=True)", threads, asm_many_bytes)
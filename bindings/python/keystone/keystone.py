@@ -76,6 +76,82 @@ if _found == False:
 
 __version__ = "%u.%u.%u" %(KS_VERSION_MAJOR, KS_VERSION_MINOR, KS_VERSION_EXTRA)
 
+# result of ks_analyze()
+KS_ANALYSIS_MAX_RESOURCES = 16
+
+class _ks_insn_timing(Structure):
+    _fields_ = [
+        ("uops", c_uint),
+        ("latency", c_uint),
+        ("ready", c_uint),
+        ("pressure", c_double * KS_ANALYSIS_MAX_RESOURCES),
+    ]
+
+class _ks_analysis(Structure):
+    _fields_ = [
+        ("throughput", c_double),
+        ("latency", c_uint),
+        ("uops", c_uint),
+        ("num_resources", c_size_t),
+        ("resources", c_char_p * KS_ANALYSIS_MAX_RESOURCES),
+        ("pressure", c_double * KS_ANALYSIS_MAX_RESOURCES),
+        ("count", c_size_t),
+        ("insns", POINTER(_ks_insn_timing)),
+    ]
+
+# result of ks_evm_gas()
+class _ks_evm_insn_cost(Structure):
+    _fields_ = [
+        ("offset", c_size_t),
+        ("opcode", c_ubyte),
+        ("gas", c_uint),
+        ("dynamic", c_bool),
+    ]
+
+class _ks_evm_block_cost(Structure):
+    _fields_ = [
+        ("first", c_size_t),
+        ("count", c_size_t),
+        ("size", c_size_t),
+        ("gas", c_uint64),
+        ("dynamic", c_bool),
+    ]
+
+class _ks_evm_cost(Structure):
+    _fields_ = [
+        ("size", c_size_t),
+        ("gas", c_uint64),
+        ("dynamic", c_bool),
+        ("count", c_size_t),
+        ("insns", POINTER(_ks_evm_insn_cost)),
+        ("num_blocks", c_size_t),
+        ("blocks", POINTER(_ks_evm_block_cost)),
+    ]
+
+class _ks_op_mem(Structure):
+    _fields_ = [
+        ("segment", c_uint),
+        ("base", c_uint),
+        ("index", c_uint),
+        ("scale", c_uint),
+        ("disp", c_int64),
+        ("size", c_uint),
+    ]
+
+class _ks_op_value(Union):
+    _fields_ = [
+        ("reg", c_uint),
+        ("imm", c_int64),
+        ("mem", _ks_op_mem),
+    ]
+
+class _ks_operand(Structure):
+    _anonymous_ = ("value",)
+    _fields_ = [
+        ("type", c_int),
+        ("value", _ks_op_value),
+    ]
+
 # setup all the function prototype
 def _setup_prototype(lib, fname, restype, *argtypes):
     getattr(lib, fname).restype = restype
@@ -94,6 +170,24 @@ _setup_prototype(_ks, "ks_errno", kserr, ks_engine)
 _setup_prototype(_ks, "ks_option", kserr, ks_engine, c_int, c_void_p)
 _setup_prototype(_ks, "ks_asm", c_int, ks_engine, c_char_p, c_uint64, POINTER(POINTER(c_ubyte)), POINTER(c_size_t), POINTER(c_size_t))
 _setup_prototype(_ks, "ks_free", None, POINTER(c_ubyte))
+_setup_prototype(_ks, "ks_bytes_saved", c_size_t, ks_engine)
+_setup_prototype(_ks, "ks_block_counters", c_size_t, ks_engine, POINTER(POINTER(c_size_t)))
+_setup_prototype(_ks, "ks_analyze", c_int, ks_engine, c_char_p, c_uint64, POINTER(POINTER(_ks_analysis)))
+_setup_prototype(_ks, "ks_analysis_free", None, POINTER(_ks_analysis))
+_setup_prototype(_ks, "ks_evm_gas", c_int, ks_engine, c_char_p, c_uint64, POINTER(POINTER(_ks_evm_cost)))
+_setup_prototype(_ks, "ks_evm_cost_free", None, POINTER(_ks_evm_cost))
+_setup_prototype(_ks, "ks_reg_id", c_uint, ks_engine, c_char_p)
+_setup_prototype(_ks, "ks_encode", c_int, ks_engine, c_char_p, POINTER(_ks_operand), c_size_t, c_uint64, POINTER(POINTER(c_ubyte)), POINTER(c_size_t))
+
+# convert the encoding returned by ks_asm() or ks_encode() to bytes, or to a
+# list of ints, and free it
+def _take_encoding(encode, size, as_bytes):
+    if as_bytes:
+        encoding = string_at(encode, size)
+    else:
+        encoding = encode[:size]
+    _ks.ks_free(encode)
+    return encoding
 
 # callback for OPT_SYM_RESOLVER option
 KS_SYM_RESOLVER = CFUNCTYPE(c_bool, c_char_p, POINTER(c_uint64))
@@ -200,6 +294,178 @@ class Ks(object):
         self._sym_resolver = callback
 
 
+    # return True if Hexagon instructions are packetized automatically.
+    @property
+    def packetize(self):
+        return getattr(self, '_packetize', False)
+
+
+    # packetize setter: group unbundled Hexagon instructions into packets.
+    @packetize.setter
+    def packetize(self, enable):
+        status = _ks.ks_option(self._ksh, KS_OPT_PACKETIZE, 1 if enable else 0)
+        if status != KS_ERR_OK:
+            raise KsError(status)
+        self._packetize = bool(enable)
+
+
+    # return the boundary X86 branches are kept within (0 if disabled).
+    @property
+    def align_branch_boundary(self):
+        return getattr(self, '_align_branch_boundary', 0)
+
+
+    # align_branch_boundary setter: keep X86 branches from crossing or ending
+    # at a boundary of this many bytes.
+    @align_branch_boundary.setter
+    def align_branch_boundary(self, boundary):
+        status = _ks.ks_option(self._ksh, KS_OPT_ALIGN_BRANCH_BOUNDARY, boundary)
+        if status != KS_ERR_OK:
+            raise KsError(status)
+        self._align_branch_boundary = boundary
+
+
+    # return the mask of X86 branch classes being aligned.
+    @property
+    def align_branch_type(self):
+        return getattr(self, '_align_branch_type', KS_OPT_ALIGN_BRANCH_FUSED | KS_OPT_ALIGN_BRANCH_JCC | KS_OPT_ALIGN_BRANCH_JMP)
+
+
+    # align_branch_type setter: choose which X86 branches are aligned,
+    # as a mask of KS_OPT_ALIGN_BRANCH_*.
+    @align_branch_type.setter
+    def align_branch_type(self, kinds):
+        status = _ks.ks_option(self._ksh, KS_OPT_ALIGN_BRANCH_TYPE, kinds)
+        if status != KS_ERR_OK:
+            raise KsError(status)
+        self._align_branch_type = kinds
+
+
+    # return the CPU being assembled for (None for the arch default).
+    @property
+    def cpu(self):
+        return getattr(self, '_cpu', None)
+
+
+    # cpu setter: select the CPU by its LLVM name, "native" for the host,
+    # or None to go back to the default.
+    @cpu.setter
+    def cpu(self, name):
+        value = name.encode('ascii') if isinstance(name, str) and not isinstance(name, bytes) else name
+        status = _ks.ks_option(self._ksh, KS_OPT_CPU, value)
+        if status != KS_ERR_OK:
+            raise KsError(status)
+        self._cpu = name
+
+
+    # return the extra CPU features ("+feat1,-feat2,...", None if unset).
+    @property
+    def features(self):
+        return getattr(self, '_features', None)
+
+
+    # features setter: enable (+) or disable (-) CPU features on top of the CPU.
+    @features.setter
+    def features(self, names):
+        value = names.encode('ascii') if isinstance(names, str) and not isinstance(names, bytes) else names
+        status = _ks.ks_option(self._ksh, KS_OPT_FEATURES, value)
+        if status != KS_ERR_OK:
+            raise KsError(status)
+        self._features = names
+
+
+    # return True if X86/SystemZ instructions get their shortest encoding.
+    @property
+    def optimize_size(self):
+        return getattr(self, '_optimize_size', False)
+
+
+    # optimize_size setter: pick the shortest equivalent X86/SystemZ encoding.
+    @optimize_size.setter
+    def optimize_size(self, enable):
+        status = _ks.ks_option(self._ksh, KS_OPT_OPTIMIZE_SIZE, 1 if enable else 0)
+        if status != KS_ERR_OK:
+            raise KsError(status)
+        self._optimize_size = bool(enable)
+
+
+    # return True if instruction sizes do not depend on operand values.
+    @property
+    def fixed_width(self):
+        return getattr(self, '_fixed_width', False)
+
+
+    # fixed_width setter: always pick the long encoding, for later patching.
+    @fixed_width.setter
+    def fixed_width(self, enable):
+        status = _ks.ks_option(self._ksh, KS_OPT_FIXED_WIDTH, 1 if enable else 0)
+        if status != KS_ERR_OK:
+            raise KsError(status)
+        self._fixed_width = bool(enable)
+
+
+    # return True if X86-64 symbols are addressed RIP-relative when in reach.
+    @property
+    def rip_relative(self):
+        return getattr(self, '_rip_relative', False)
+
+
+    # rip_relative setter: pick RIP-relative or absolute addressing per symbol.
+    @rip_relative.setter
+    def rip_relative(self, enable):
+        status = _ks.ks_option(self._ksh, KS_OPT_RIP_RELATIVE, 1 if enable else 0)
+        if status != KS_ERR_OK:
+            raise KsError(status)
+        self._rip_relative = bool(enable)
+
+
+    # return True if Mips branch delay slots get filled automatically.
+    @property
+    def fill_delay_slots(self):
+        return getattr(self, '_fill_delay_slots', False)
+
+
+    # fill_delay_slots setter: move an earlier instruction into the delay slot.
+    @fill_delay_slots.setter
+    def fill_delay_slots(self, enable):
+        status = _ks.ks_option(self._ksh, KS_OPT_FILL_DELAY_SLOTS, 1 if enable else 0)
+        if status != KS_ERR_OK:
+            raise KsError(status)
+        self._fill_delay_slots = bool(enable)
+
+
+    # return the address of the X86 basic-block counter table (0 if off).
+    @property
+    def block_counters(self):
+        return getattr(self, '_block_counters', 0)
+
+
+    # block_counters setter: count the executions of each basic block in a
+    # table of 64-bit counters at this address, or 0 to stop.
+    @block_counters.setter
+    def block_counters(self, address):
+        status = _ks.ks_option(self._ksh, KS_OPT_BLOCK_COUNTERS, address)
+        if status != KS_ERR_OK:
+            raise KsError(status)
+        self._block_counters = address
+
+
+    # return the source line of each block counted by the last asm(),
+    # in the order of their counters.
+    @property
+    def block_lines(self):
+        lines = POINTER(c_size_t)()
+        count = _ks.ks_block_counters(self._ksh, byref(lines))
+        return [lines[i] for i in range(count)]
+
+
+    # return how many bytes the last asm() saved thanks to optimize_size
+    # or fill_delay_slots.
+    @property
+    def bytes_saved(self):
+        return _ks.ks_bytes_saved(self._ksh)
+
+
     # assemble a string of assembly
     def asm(self, string, addr=0, as_bytes=False):
         encode = POINTER(c_ubyte)()
@@ -213,19 +479,168 @@ class Ks(object):
             errno = _ks.ks_errno(self._ksh)
             raise KsError(errno, stat_count.value)
         else:
+            encoding = _take_encoding(encode, encode_size.value, as_bytes)
             if stat_count.value == 0:
                 return (None, 0)
             else:
-                if as_bytes:
-                    encoding = string_at(encode, encode_size.value)
-                else:
-                    encoding = []
-                    for i in range(encode_size.value):
-                        encoding.append(encode[i])
-
-                _ks.ks_free(encode)
                 return (encoding, stat_count.value)
 
+    # assemble a sequence of (string, addr) pairs, returning the list of their
+    # (encoding, stat_count) as asm() would. This saves most of the per-call
+    # overhead of the binding; like any ks_asm() call, it runs without the
+    # GIL, so engines in other threads keep assembling meanwhile.
+    # Raise KsError at the first statement that fails.
+    def asm_many(self, pairs, as_bytes=False):
+        encode = POINTER(c_ubyte)()
+        encode_size = c_size_t()
+        stat_count = c_size_t()
+        p_encode, p_size, p_count = byref(encode), byref(encode_size), byref(stat_count)
+        ks_asm, ksh = _ks.ks_asm, self._ksh
+
+        results = []
+        for string, addr in pairs:
+            if not isinstance(string, bytes) and isinstance(string, str):
+                string = string.encode('ascii')
+
+            if ks_asm(ksh, string, addr, p_encode, p_size, p_count) != 0:
+                raise KsError(_ks.ks_errno(ksh), stat_count.value)
+
+            encoding = _take_encoding(encode, encode_size.value, as_bytes)
+            if stat_count.value == 0:
+                encoding = None
+            results.append((encoding, stat_count.value))
+
+        return results
+
+    # return the id of a register for encode(), or 0 if name is unknown.
+    def reg_id(self, name):
+        if not isinstance(name, bytes) and isinstance(name, str):
+            name = name.encode('ascii')
+        return _ks.ks_reg_id(self._ksh, name)
+
+    # encode one instruction without parsing text. Each operand is an int
+    # (immediate), a register name, or a dict for memory with optional keys
+    # "segment", "base", "index" (register names), "scale", "disp" & "size"
+    # (in bytes).
+    def encode(self, mnemonic, operands=(), addr=0, as_bytes=False):
+        if not isinstance(mnemonic, bytes) and isinstance(mnemonic, str):
+            mnemonic = mnemonic.encode('ascii')
+
+        def reg(name):
+            if name is None:
+                return 0
+            r = self.reg_id(name)
+            if r == 0:
+                raise KsError(KS_ERR_ASM_INVALIDOPERAND)
+            return r
+
+        ops = (_ks_operand * max(len(operands), 1))()
+        for i, o in enumerate(operands):
+            if isinstance(o, dict):
+                ops[i].type = KS_OP_MEM
+                ops[i].mem.segment = reg(o.get("segment"))
+                ops[i].mem.base = reg(o.get("base"))
+                ops[i].mem.index = reg(o.get("index"))
+                ops[i].mem.scale = o.get("scale", 1)
+                ops[i].mem.disp = o.get("disp", 0)
+                ops[i].mem.size = o.get("size", 0)
+            elif isinstance(o, (str, bytes)):
+                ops[i].type = KS_OP_REG
+                ops[i].reg = reg(o)
+            else:
+                ops[i].type = KS_OP_IMM
+                ops[i].imm = o
+
+        encode = POINTER(c_ubyte)()
+        encode_size = c_size_t()
+        status = _ks.ks_encode(self._ksh, mnemonic, ops, len(operands), addr, byref(encode), byref(encode_size))
+        if (status != 0):
+            errno = _ks.ks_errno(self._ksh)
+            raise KsError(errno)
+
+        return _take_encoding(encode, encode_size.value, as_bytes)
+
+    # estimate the timing of a block on the scheduling model of the current
+    # CPU (see the cpu property). Returns a dict with the block's reciprocal
+    # "throughput", critical path "latency", "uops" & per resource "pressure",
+    # plus the same figures for each instruction in "insns".
+    def analyze(self, string, addr=0):
+        result = POINTER(_ks_analysis)()
+        if not isinstance(string, bytes) and isinstance(string, str):
+            string = string.encode('ascii')
+
+        status = _ks.ks_analyze(self._ksh, string, addr, byref(result))
+        if (status != 0):
+            errno = _ks.ks_errno(self._ksh)
+            raise KsError(errno)
+
+        a = result.contents
+        names = [a.resources[r].decode('ascii') for r in range(a.num_resources)]
+        def pressure(p):
+            return dict((names[r], p[r]) for r in range(a.num_resources) if p[r])
+
+        analysis = {
+            "throughput": a.throughput,
+            "latency": a.latency,
+            "uops": a.uops,
+            "pressure": pressure(a.pressure),
+            "insns": [],
+        }
+        for i in range(a.count):
+            t = a.insns[i]
+            analysis["insns"].append({
+                "uops": t.uops,
+                "latency": t.latency,
+                "ready": t.ready,
+                "pressure": pressure(t.pressure),
+            })
+
+        _ks.ks_analysis_free(result)
+        return analysis
+
+    # assemble EVM code, then return a dict with its bytecode "size", the
+    # static "gas" of each instruction in "insns" and of each straight-line
+    # block in "blocks", and their total. "dynamic" flags costs that also
+    # depend on runtime values, of which only the fixed part is counted.
+    def evm_gas(self, string, addr=0):
+        result = POINTER(_ks_evm_cost)()
+        if not isinstance(string, bytes) and isinstance(string, str):
+            string = string.encode('ascii')
+
+        status = _ks.ks_evm_gas(self._ksh, string, addr, byref(result))
+        if (status != 0):
+            errno = _ks.ks_errno(self._ksh)
+            raise KsError(errno)
+
+        c = result.contents
+        cost = {
+            "size": c.size,
+            "gas": c.gas,
+            "dynamic": c.dynamic,
+            "insns": [],
+            "blocks": [],
+        }
+        for i in range(c.count):
+            t = c.insns[i]
+            cost["insns"].append({
+                "offset": t.offset,
+                "opcode": t.opcode,
+                "gas": t.gas,
+                "dynamic": t.dynamic,
+            })
+        for i in range(c.num_blocks):
+            b = c.blocks[i]
+            cost["blocks"].append({
+                "offset": c.insns[b.first].offset,
+                "count": b.count,
+                "size": b.size,
+                "gas": b.gas,
+                "dynamic": b.dynamic,
+            })
+
+        _ks.ks_evm_cost_free(result)
+        return cost
+
 
 # print out debugging info
 def debug():
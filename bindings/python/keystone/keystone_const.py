@@ -46,6 +46,7 @@ KS_ERR_HANDLE = 3
 KS_ERR_MODE = 4
 KS_ERR_VERSION = 5
 KS_ERR_OPT_INVALID = 6
+KS_ERR_NO_SCHED_MODEL = 7
 KS_ERR_ASM_EXPR_TOKEN = 128
 KS_ERR_ASM_DIRECTIVE_VALUE_RANGE = 129
 KS_ERR_ASM_DIRECTIVE_ID = 130
@@ -87,9 +88,29 @@ KS_ERR_ASM_MISSINGFEATURE = 513
 KS_ERR_ASM_MNEMONICFAIL = 514
 KS_OPT_SYNTAX = 1
 KS_OPT_SYM_RESOLVER = 2
+KS_OPT_PACKETIZE = 3
+KS_OPT_ALIGN_BRANCH_BOUNDARY = 4
+KS_OPT_ALIGN_BRANCH_TYPE = 5
+KS_OPT_CPU = 6
+KS_OPT_FEATURES = 7
+KS_OPT_OPTIMIZE_SIZE = 8
+KS_OPT_FIXED_WIDTH = 9
+KS_OPT_RIP_RELATIVE = 10
+KS_OPT_FILL_DELAY_SLOTS = 11
+KS_OPT_BLOCK_COUNTERS = 12
 KS_OPT_SYNTAX_INTEL = 1
 KS_OPT_SYNTAX_ATT = 2
 KS_OPT_SYNTAX_NASM = 4
 KS_OPT_SYNTAX_MASM = 8
 KS_OPT_SYNTAX_GAS = 16
 KS_OPT_SYNTAX_RADIX16 = 32
+KS_OPT_ALIGN_BRANCH_FUSED = 1
+KS_OPT_ALIGN_BRANCH_JCC = 2
+KS_OPT_ALIGN_BRANCH_JMP = 4
+KS_OPT_ALIGN_BRANCH_CALL = 8
+KS_OPT_ALIGN_BRANCH_RET = 16
+KS_OPT_ALIGN_BRANCH_INDIRECT = 32
+KS_OP_INVALID = 0
+KS_OP_REG = 1
+KS_OP_IMM = 2
+KS_OP_MEM = 3
@@ -115,6 +115,7 @@ typedef enum ks_err {
     KS_ERR_MODE,     // Invalid/unsupported mode: ks_open()
     KS_ERR_VERSION,  // Unsupported version (bindings)
     KS_ERR_OPT_INVALID,  // Unsupported option
+    KS_ERR_NO_SCHED_MODEL,  // No scheduling model for this CPU: ks_analyze()
 
     // generic input assembly errors - parser specific
     KS_ERR_ASM_EXPR_TOKEN = KS_ERR_ASM,    // unknown token in expression
@@ -174,6 +175,16 @@ typedef bool (*ks_sym_resolver)(const char *symbol, uint64_t *value);
 typedef enum ks_opt_type {
 	KS_OPT_SYNTAX = 1,    // Choose syntax for input assembly
 	KS_OPT_SYM_RESOLVER,  // Set symbol resolver callback
+	KS_OPT_PACKETIZE,     // Hexagon: group unbundled instructions into packets (value: 1 = on, 0 = off)
+	KS_OPT_ALIGN_BRANCH_BOUNDARY, // X86: keep branches within this many bytes (value: 0 = off, or a power of 2 >= 16)
+	KS_OPT_ALIGN_BRANCH_TYPE,     // X86: branches to keep within the boundary (value: KS_OPT_ALIGN_BRANCH_* mask)
+	KS_OPT_CPU,           // Select CPU to assemble for (value: CPU name as const char*, "native" for the host, NULL = default)
+	KS_OPT_FEATURES,      // Enable/disable CPU features (value: "+feat1,-feat2,..." as const char*, NULL = none)
+	KS_OPT_OPTIMIZE_SIZE, // X86, SystemZ: pick the shortest equivalent encoding (value: 1 = on, 0 = off)
+	KS_OPT_FIXED_WIDTH,   // Encode so that instruction sizes do not depend on operand values, for later patching (value: 1 = on, 0 = off)
+	KS_OPT_RIP_RELATIVE,  // X86-64: address symbols RIP-relative when within 2GB, absolute otherwise (value: 1 = on, 0 = off)
+	KS_OPT_FILL_DELAY_SLOTS, // Mips: in .set reorder mode, move a preceding instruction into branch delay slots instead of a nop (value: 1 = on, 0 = off)
+	KS_OPT_BLOCK_COUNTERS, // X86 32/64-bit: count executions of each basic block in a table of 64-bit counters (value: address of the table, 0 = off). See ks_block_counters()
 } ks_opt_type;
 
 
@@ -185,6 +196,13 @@ typedef enum ks_opt_value {
 	KS_OPT_SYNTAX_MASM  =   1 << 3, // X86 Masm syntax (KS_OPT_SYNTAX) - unsupported yet.
 	KS_OPT_SYNTAX_GAS   =   1 << 4, // X86 GNU GAS syntax (KS_OPT_SYNTAX).
 	KS_OPT_SYNTAX_RADIX16 = 1 << 5, // All immediates are in hex format (i.e 12 is 0x12)
+
+	KS_OPT_ALIGN_BRANCH_FUSED    = 1 << 0, // X86 macro-fused cmp/test+jcc pairs (KS_OPT_ALIGN_BRANCH_TYPE).
+	KS_OPT_ALIGN_BRANCH_JCC      = 1 << 1, // X86 conditional jumps (KS_OPT_ALIGN_BRANCH_TYPE).
+	KS_OPT_ALIGN_BRANCH_JMP      = 1 << 2, // X86 direct unconditional jumps (KS_OPT_ALIGN_BRANCH_TYPE).
+	KS_OPT_ALIGN_BRANCH_CALL     = 1 << 3, // X86 calls (KS_OPT_ALIGN_BRANCH_TYPE).
+	KS_OPT_ALIGN_BRANCH_RET      = 1 << 4, // X86 returns (KS_OPT_ALIGN_BRANCH_TYPE).
+	KS_OPT_ALIGN_BRANCH_INDIRECT = 1 << 5, // X86 indirect jumps (KS_OPT_ALIGN_BRANCH_TYPE).
 } ks_opt_value;
 
 
@@ -330,6 +348,240 @@ int ks_asm(ks_engine *ks,
         size_t *stat_count);
 
 
+/*
+ Report how many bytes the last ks_asm() call saved by choosing shorter
+ encodings, when option KS_OPT_OPTIMIZE_SIZE is on, or by filling delay
+ slots, when option KS_OPT_FILL_DELAY_SLOTS is on (one nop per slot).
+
+ @ks: handle returned by ks_open()
+
+ @return: number of bytes saved, or 0 if nothing could be shortened.
+*/
+KEYSTONE_EXPORT
+size_t ks_bytes_saved(ks_engine *ks);
+
+
+/*
+ Report the basic blocks instrumented by the last ks_asm() call, when option
+ KS_OPT_BLOCK_COUNTERS is on. A block starts at the first instruction, at
+ each label and after each branch, call or return. On entry, block i adds
+ 1 to the 64-bit counter at (table address + 8 * i), preserving all
+ registers and flags.
+
+ @ks: handle returned by ks_open()
+ @lines: set to an array holding the source line (counting from 1) of the
+   first instruction of each block. It stays valid until the next ks_asm()
+   or ks_close() call.
+
+ @return: number of blocks, i.e. of counters in the table.
+*/
+KEYSTONE_EXPORT
+size_t ks_block_counters(ks_engine *ks, const size_t **lines);
+
+
+// Maximum number of processor resources (ports, dividers...) reported
+// by ks_analyze()
+#define KS_ANALYSIS_MAX_RESOURCES 16
+
+// Timing of one instruction in a block given to ks_analyze()
+typedef struct ks_insn_timing {
+    unsigned int uops;      // micro-ops issued
+    unsigned int latency;   // cycles from issue until its results are ready
+    unsigned int ready;     // cycle all its register inputs are available
+    // cycles spent on each resource of ks_analysis.resources[]
+    double pressure[KS_ANALYSIS_MAX_RESOURCES];
+} ks_insn_timing;
+
+// Result of ks_analyze()
+typedef struct ks_analysis {
+    double throughput;      // reciprocal throughput, in cycles per iteration
+    unsigned int latency;   // critical path latency, in cycles
+    unsigned int uops;      // micro-ops of the whole block
+    size_t num_resources;   // number of valid entries in resources[]
+    const char *resources[KS_ANALYSIS_MAX_RESOURCES];
+    double pressure[KS_ANALYSIS_MAX_RESOURCES]; // sum over the block
+    size_t count;           // number of instructions
+    ks_insn_timing *insns;  // timing of each instruction, in program order
+} ks_analysis;
+
+
+/*
+ Assemble a block of instructions, then estimate its timing with the
+ scheduling model of the CPU chosen with KS_OPT_CPU.
+ Models exist for X86 "skylake", "skl", "skx" & "btver2", and for
+ ARM64 "cortex-a57" & "cortex-a72".
+
+ This is a static estimate: only register dependencies are followed,
+ memory accesses are assumed independent and to hit the L1 cache, and
+ branches are ignored.
+
+ @ks: handle returned by ks_open()
+ @str: NULL-terminated assembly string. Use ; or \n to separate statements.
+ @address: address of the first assembly instruction, or 0 to ignore.
+ @analysis: the result.
+	   NOTE: *analysis will be allocated by this function, and should be freed
+	   with ks_analysis_free() function.
+
+ @return: 0 on success, or -1 on failure.
+
+ On failure, call ks_errno() for error code: KS_ERR_NO_SCHED_MODEL if the
+ current CPU has no scheduling model, or the error of ks_asm().
+*/
+KEYSTONE_EXPORT
+int ks_analyze(ks_engine *ks,
+        const char *string,
+        uint64_t address,
+        ks_analysis **analysis);
+
+
+/*
+ Free memory allocated by ks_analyze()
+
+ @analysis: memory allocated in @analysis argument of ks_analyze()
+*/
+KEYSTONE_EXPORT
+void ks_analysis_free(ks_analysis *analysis);
+
+
+// Static gas of one instruction given to ks_evm_gas()
+typedef struct ks_evm_insn_cost {
+    size_t offset;          // offset of the opcode in the bytecode
+    unsigned char opcode;
+    unsigned int gas;       // static base gas
+    bool dynamic;           // true if the cost also depends on operands,
+                            // memory expansion, storage or the callee
+} ks_evm_insn_cost;
+
+// Static gas of a straight-line block: it starts at the beginning of the
+// code, at a JUMPDEST, or after a JUMPI or an opcode that halts or jumps
+typedef struct ks_evm_block_cost {
+    size_t first;           // index of its first instruction in insns[]
+    size_t count;           // number of instructions
+    size_t size;            // bytes of bytecode
+    uint64_t gas;           // sum of the static gas of its instructions
+    bool dynamic;           // true if any of them has a dynamic cost
+} ks_evm_block_cost;
+
+// Result of ks_evm_gas()
+typedef struct ks_evm_cost {
+    size_t size;            // bytecode size
+    uint64_t gas;           // sum of the static gas of all instructions
+    bool dynamic;           // true if any of them has a dynamic cost
+    size_t count;           // number of instructions
+    ks_evm_insn_cost *insns;
+    size_t num_blocks;
+    ks_evm_block_cost *blocks;
+} ks_evm_cost;
+
+
+/*
+ Assemble EVM code, then report its size and the static gas cost of each
+ instruction and of each straight-line block.
+
+ Costs follow the Byzantium fee schedule, which matches the opcodes known
+ to the assembler. Opcodes whose actual cost also depends on runtime
+ values (EXP, SHA3, copies & memory expansion, SSTORE, LOG*, CREATE,
+ CALL* and SUICIDE) report their fixed part and are flagged dynamic.
+
+ @ks: handle returned by ks_open() for KS_ARCH_EVM
+ @str: NULL-terminated assembly string. Use ; or \n to separate statements.
+ @address: address of the first assembly instruction, or 0 to ignore.
+ @cost: the result.
+	   NOTE: *cost will be allocated by this function, and should be freed
+	   with ks_evm_cost_free() function.
+
+ @return: 0 on success, or -1 on failure.
+
+ On failure, call ks_errno() for error code: KS_ERR_ARCH if @ks is not
+ for EVM, or the error of ks_asm().
+*/
+KEYSTONE_EXPORT
+int ks_evm_gas(ks_engine *ks,
+        const char *string,
+        uint64_t address,
+        ks_evm_cost **cost);
+
+
+/*
+ Free memory allocated by ks_evm_gas()
+
+ @cost: memory allocated in @cost argument of ks_evm_gas()
+*/
+KEYSTONE_EXPORT
+void ks_evm_cost_free(ks_evm_cost *cost);
+
+
+// Type of an operand given to ks_encode()
+typedef enum ks_op_type {
+    KS_OP_INVALID = 0,  // uninitialized
+    KS_OP_REG,          // register, as returned by ks_reg_id()
+    KS_OP_IMM,          // immediate value or branch target
+    KS_OP_MEM,          // memory: segment:[base + index * scale + disp]
+} ks_op_type;
+
+// Memory operand of ks_encode(). Registers come from ks_reg_id(), 0 for none.
+typedef struct ks_op_mem {
+    unsigned int segment;
+    unsigned int base;
+    unsigned int index;
+    unsigned int scale;     // 1, 2, 4 or 8 (0 means 1)
+    int64_t disp;
+    unsigned int size;      // access size in bytes (0 = implied by the instruction)
+} ks_op_mem;
+
+// Operand of ks_encode()
+typedef struct ks_operand {
+    ks_op_type type;
+    union {
+        unsigned int reg;   // KS_OP_REG
+        int64_t imm;        // KS_OP_IMM
+        ks_op_mem mem;      // KS_OP_MEM
+    };
+} ks_operand;
+
+
+/*
+ Look up a register for ks_encode() by its assembly name (case insensitive).
+ Ids depend on the architecture, so look them up once per engine.
+
+ @ks: handle returned by ks_open()
+ @name: register name, such as "rax" or "xmm3".
+
+ @return: the register id, or 0 if @name is not a register of this architecture.
+*/
+KEYSTONE_EXPORT
+unsigned int ks_reg_id(ks_engine *ks, const char *name);
+
+
+/*
+ Encode one instruction given in structured form, without lexing or parsing
+ any text. It matches and encodes exactly as ks_asm() would for the same
+ instruction, and honors the same options.
+ Only X86 is supported for now: other architectures fail with KS_ERR_ARCH.
+
+ @ks: handle returned by ks_open()
+ @mnemonic: NULL-terminated lowercase mnemonic, such as "add" or "vpaddd".
+ @ops: operands, in the order of the current syntax (destination first in
+   Intel syntax, last in AT&T syntax).
+ @count: number of operands in @ops.
+ @address: address of the instruction, or 0 to ignore.
+ @encoding: array of bytes of the encoded instruction.
+	   NOTE: *encoding will be allocated by this function, and should be freed
+	   with ks_free() function.
+ @encoding_size: size of *encoding
+
+ @return: 0 on success, or -1 on failure.
+
+ On failure, call ks_errno() for error code.
+*/
+KEYSTONE_EXPORT
+int ks_encode(ks_engine *ks,
+        const char *mnemonic,
+        const ks_operand *ops, size_t count,
+        uint64_t address,
+        unsigned char **encoding, size_t *encoding_size);
+
+
 /*
  Free memory allocated by ks_asm()
 
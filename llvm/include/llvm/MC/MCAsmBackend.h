@@ -26,6 +26,7 @@ struct MCFixupKindInfo;
 class MCFragment;
 class MCInst;
 class MCRelaxableFragment;
+class MCObjectStreamer;
 class MCObjectWriter;
 class MCSection;
 class MCValue;
@@ -91,6 +92,16 @@ public:
                           const MCValue &Target, MutableArrayRef<char> Data,
                           uint64_t Value, bool IsPCRel, unsigned int &KsError) const = 0;
 
+  /// Rewrite the contents of an encoded fragment once all of its \p Fixups
+  /// have been applied and the final addresses are known, the way a linker
+  /// relaxes instruction sequences. The size of the fragment must not change,
+  /// so no further layout is needed. The default does nothing.
+  virtual void relaxFixedUpFragment(const MCAssembler &Asm,
+                                    const MCAsmLayout &Layout,
+                                    const MCFragment &F,
+                                    ArrayRef<MCFixup> Fixups,
+                                    MutableArrayRef<char> Data) const {}
+
   /// @}
 
   /// \name Target Relaxation Interfaces
@@ -137,6 +148,21 @@ public:
   /// Handle any target-specific assembler flags. By default, do nothing.
   virtual void handleAssemblerFlag(MCAssemblerFlag Flag) {}
 
+  /// Give the target a chance to insert padding fragments around \p Inst,
+  /// before and after the streamer emits it. By default, do nothing.
+  virtual void alignBranchesBegin(MCObjectStreamer &OS, const MCInst &Inst) {}
+  virtual void alignBranchesEnd(MCObjectStreamer &OS, const MCInst &Inst) {}
+
+  /// True if alignBranchesBegin() has to see every instruction.
+  virtual bool isAligningBranches() const { return false; }
+
+  /// Keep branches of the given classes (KS_OPT_ALIGN_BRANCH_*) from crossing
+  /// or ending at a \p Boundary byte boundary. A zero \p Boundary disables
+  /// it. Returns false if the target does not support branch alignment.
+  virtual bool setAlignBranch(unsigned Boundary, unsigned Kinds) {
+    return false;
+  }
+
   /// \brief Generate the compact unwind encoding for the CFI instructions.
   virtual uint32_t
       generateCompactUnwindEncoding(ArrayRef<MCCFIInstruction>) const {
@@ -151,7 +151,7 @@ protected:
   /// Which dialect of an assembler variant to use.  Defaults to 0
   unsigned AssemblerDialect;
 
-  /// Default Radix for immediate 
+  /// Default Radix for immediate.  Defaults to 10
   unsigned Radix;
 
   /// This is true if the assembler allows @ characters in symbol names.
@@ -40,6 +40,7 @@ public:
     FT_DwarfFrame,
     FT_LEB,
     FT_SafeSEH,
+    FT_BoundaryAlign,
     FT_Dummy
   };
 
@@ -484,6 +485,51 @@ public:
   }
 };
 
+/// Represents NOP padding placed in front of a branch (or of a macro-fused
+/// compare and branch pair) so that the branch neither crosses nor ends at an
+/// alignment boundary. The padding size is computed during layout.
+class MCBoundaryAlignFragment : public MCFragment {
+
+  /// AlignBoundary - The boundary the branch must stay within, in bytes.
+  unsigned AlignBoundary;
+
+  /// Fused - The branch is macro-fused with the instruction in front of it,
+  /// so both of them have to stay within the boundary.
+  bool Fused : 1;
+
+  /// EmitNops - Padding is allowed. A fragment without it only marks the end
+  /// of the preceding branch, or waits for a branch to fuse with.
+  bool EmitNops : 1;
+
+  /// Size - The number of padding bytes currently emitted.
+  uint64_t Size;
+
+public:
+  MCBoundaryAlignFragment(unsigned AlignBoundary, MCSection *Sec = nullptr)
+      : MCFragment(FT_BoundaryAlign, false, 0, Sec),
+        AlignBoundary(AlignBoundary), Fused(false), EmitNops(false), Size(0) {}
+
+  /// \name Accessors
+  /// @{
+
+  unsigned getAlignment() const { return AlignBoundary; }
+
+  bool isFused() const { return Fused; }
+  void setFused(bool Value) { Fused = Value; }
+
+  bool canEmitNops() const { return EmitNops; }
+  void setEmitNops(bool Value) { EmitNops = Value; }
+
+  uint64_t getSize() const { return Size; }
+  void setSize(uint64_t Value) { Size = Value; }
+
+  /// @}
+
+  static bool classof(const MCFragment *F) {
+    return F->getKind() == MCFragment::FT_BoundaryAlign;
+  }
+};
+
 } // end namespace llvm_ks
 
 #endif
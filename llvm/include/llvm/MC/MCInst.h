@@ -149,11 +149,13 @@ template <> struct isPodLike<MCOperand> { static const bool value = true; };
 class MCInst {
   unsigned Opcode;
   uint64_t Address; // address of this instruction - keystone
+  // Target specific flags passed from the asm parser to the code emitter.
+  unsigned Flags;
   SMLoc Loc;
   SmallVector<MCOperand, 8> Operands;
 
 public:
-  MCInst(uint64_t addr = 0) : Opcode(0), Address(addr) {}
+  MCInst(uint64_t addr = 0) : Opcode(0), Address(addr), Flags(0) {}
 
   void setOpcode(unsigned Op) { Opcode = Op; }
   unsigned getOpcode() const { return Opcode; }
@@ -161,6 +163,9 @@ public:
   void setAddress(uint64_t addr) { Address = addr; }
   uint64_t getAddress() const { return Address; }
 
+  void setFlags(unsigned F) { Flags = F; }
+  unsigned getFlags() const { return Flags; }
+
   void setLoc(SMLoc loc) { Loc = loc; }
   SMLoc getLoc() const { return Loc; }
 
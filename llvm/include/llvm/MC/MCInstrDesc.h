@@ -212,16 +212,44 @@ public:
   /// branch through a register.
   bool isIndirectBranch() const { return Flags & (1 << MCID::IndirectBranch); }
 
+  /// \brief Returns true if this instruction is part of the terminator for a
+  /// basic block, and control flow does not fall through.
+  bool isBarrier() const { return Flags & (1 << MCID::Barrier); }
+
+  /// \brief Returns true if this instruction part of the terminator for a
+  /// basic block.  Typically this is things like return and branch
+  /// instructions.
+  bool isTerminator() const { return Flags & (1 << MCID::Terminator); }
+
+  /// \brief Return true if this is a branch which may fall through to the
+  /// next instruction or may transfer control flow to some other block.
+  bool isConditionalBranch() const {
+    return isBranch() && !isBarrier() && !isIndirectBranch();
+  }
+
+  /// \brief Return true if this is a branch which always transfers control
+  /// flow to some other block.
+  bool isUnconditionalBranch() const {
+    return isBranch() && isBarrier() && !isIndirectBranch();
+  }
+
   /// \brief Return true if this instruction has a predicate operand
   /// that controls execution. It may be set to 'always', or may be set to other
   /// values. There are various methods in TargetInstrInfo that can be used to
   /// control and modify the predicate in this instruction.
   bool isPredicable() const { return Flags & (1 << MCID::Predicable); }
 
+  /// \brief Return true if the first two source operands of this instruction
+  /// can be swapped without changing its result.
+  bool isCommutable() const { return Flags & (1 << MCID::Commutable); }
+
   /// \brief Returns true if the specified instruction has a delay slot which
   /// must be filled by the code generator.
   bool hasDelaySlot() const { return Flags & (1 << MCID::DelaySlot); }
 
+  /// \brief Return true if this instruction is a bitcast instruction.
+  bool isBitcast() const { return Flags & (1 << MCID::Bitcast); }
+
   //===--------------------------------------------------------------------===//
   // Side Effect Analysis
   //===--------------------------------------------------------------------===//
@@ -237,6 +265,14 @@ public:
   /// may not actually modify anything, for example.
   bool mayStore() const { return Flags & (1 << MCID::MayStore); }
 
+  /// \brief Return true if this instruction has side effects that are not
+  /// modeled by other flags.  This does not return true for instructions
+  /// whose effects are captured by mayLoad, mayStore or implicit register
+  /// defs and uses.
+  bool hasUnmodeledSideEffects() const {
+    return Flags & (1 << MCID::UnmodeledSideEffects);
+  }
+
   /// \brief Return a list of registers that are potentially read by any
   /// instance of this machine instruction.  For example, on X86, the "adc"
   /// instruction adds two register operands and adds the carry bit in from the
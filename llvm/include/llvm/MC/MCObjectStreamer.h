@@ -41,6 +41,8 @@ class MCObjectStreamer : public MCStreamer {
   SmallVector<MCSymbol *, 2> PendingLabels;
 
   virtual void EmitInstToData(MCInst &Inst, const MCSubtargetInfo&, unsigned int &KsError) = 0;
+  void EmitInstructionImpl(MCInst &Inst, const MCSubtargetInfo &STI,
+                           unsigned int &KsError);
   void EmitCFIStartProcImpl(MCDwarfFrameInfo &Frame) override;
   void EmitCFIEndProcImpl(MCDwarfFrameInfo &Frame) override;
 
@@ -98,6 +100,7 @@ public:
   void EmitWeakReference(MCSymbol *Alias, const MCSymbol *Symbol) override;
   void ChangeSection(MCSection *Section, const MCExpr *Subsection) override;
   void EmitInstruction(MCInst &Inst, const MCSubtargetInfo& STI, unsigned int &KsError) override;
+  bool EmitEncodedInstruction(StringRef Code) override;
 
   /// \brief Emit an instruction to a special fragment, because this instruction
   /// can change its size during relaxation.
@@ -10,11 +10,14 @@
 #ifndef LLVM_MC_MCPARSER_MCTARGETASMPARSER_H
 #define LLVM_MC_MCPARSER_MCTARGETASMPARSER_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/MC/MCExpr.h"
 #include "llvm/MC/MCParser/MCAsmParserExtension.h"
 #include "llvm/MC/MCTargetOptions.h"
 #include <memory>
 
+struct ks_operand;
+
 namespace llvm_ks {
 class AsmToken;
 class MCInst;
@@ -224,6 +227,40 @@ public:
   }
 
   virtual void onLabelParsed(MCSymbol *Symbol) { }
+
+  /// Emit any instructions the target is still holding back (e.g. an open
+  /// VLIW packet) before a label, a directive or the end of input.
+  /// Returns true on failure, with ErrorCode set.
+  virtual bool flushPendingInstructions(MCStreamer &Out,
+                                        unsigned int &ErrorCode) {
+    return false;
+  }
+
+  /// Number of bytes saved so far by picking shorter encodings
+  /// (MCTargetOptions::MCOptimizeSize).
+  virtual uint64_t getBytesSaved() const { return 0; }
+
+  /// Source line of the first instruction of each basic block given a
+  /// counter so far (MCTargetOptions::MCBlockCounters).
+  virtual ArrayRef<unsigned> getBlockCounterLines() const { return None; }
+
+  /// Encode the statement of instruction Name, whose operands start at the
+  /// current token, without parsing nor matching them, if it is one of the
+  /// simple forms the target knows by heart. Returns true if it emitted the
+  /// instruction, consumed the statement and advanced Address past it;
+  /// false leaves the lexer as is for ParseInstruction().
+  virtual bool tryFastEncode(StringRef Name, MCStreamer &Out,
+                             uint64_t &Address) {
+    return false;
+  }
+
+  /// Build the parsed operands of instruction Mnemonic from the structured
+  /// operands of ks_encode(), ready for MatchAndEmitInstruction(), as
+  /// ParseInstruction() would from text. Returns true on failure.
+  virtual bool createStructuredOperands(StringRef Mnemonic,
+                                        ArrayRef<ks_operand> Ops,
+                                        OperandVector &Operands,
+                                        unsigned int &ErrorCode);
 };
 
 } // End llvm namespace
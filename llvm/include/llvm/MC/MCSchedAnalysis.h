@@ -0,0 +1,58 @@
+//===- llvm/MC/MCSchedAnalysis.h - Static block timing ----------*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares a small static analyzer that estimates the throughput
+// and latency of a straight-line block of MCInsts from the per-operand
+// machine model (MCSchedModel) of the current CPU.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_MC_MCSCHEDANALYSIS_H
+#define LLVM_MC_MCSCHEDANALYSIS_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include <vector>
+
+namespace llvm_ks {
+class MCInst;
+class MCInstrInfo;
+class MCRegisterInfo;
+class MCSubtargetInfo;
+
+/// Timing of a block of instructions. Pressure vectors are indexed like
+/// MCSchedModel's processor resources (index 0 is the invalid unit), in
+/// cycles per unit of that resource kind.
+struct MCSchedAnalysis {
+  struct InstTiming {
+    unsigned NumMicroOps = 0;
+    unsigned Latency = 0;   // cycles from issue until its results are ready
+    unsigned Ready = 0;     // cycle all its register inputs are available
+    std::vector<double> Pressure;
+  };
+
+  /// Reciprocal throughput: cycles per iteration when the block runs in a
+  /// loop, bounded by the issue width and the busiest resource.
+  double Throughput = 0;
+  /// Length of the longest register dependency chain, in cycles.
+  unsigned Latency = 0;
+  unsigned NumMicroOps = 0;
+  std::vector<double> Pressure;
+  std::vector<InstTiming> Insts;
+};
+
+/// Analyze Insts in program order. Only register dependencies are followed;
+/// memory is assumed not to alias and every load to hit the L1 cache.
+/// Returns false if the CPU of STI has no instruction-level machine model.
+bool analyzeSchedule(ArrayRef<MCInst> Insts, const MCSubtargetInfo &STI,
+                     const MCInstrInfo &MCII, const MCRegisterInfo &MRI,
+                     MCSchedAnalysis &Result);
+
+} // End llvm namespace
+
+#endif
@@ -157,6 +157,7 @@ private:
 ///
 class MCStreamer {
   mutable void *KsSymResolver;
+  std::vector<MCInst> *KsInstRecorder;
   MCContext &Context;
   std::unique_ptr<MCTargetStreamer> TargetStreamer;
 
@@ -201,6 +202,11 @@ public:
   void setSymResolver(void *h) const { KsSymResolver = h; }
   void *getSymResolver() const { return KsSymResolver; }
 
+  /// Keep a copy of every instruction emitted from now on in \p Insts
+  /// (nullptr stops recording). Used by ks_analyze().
+  void setInstRecorder(std::vector<MCInst> *Insts) { KsInstRecorder = Insts; }
+  bool hasInstRecorder() const { return KsInstRecorder != nullptr; }
+
   void visitUsedExpr(const MCExpr &Expr);
   virtual void visitUsedSymbol(const MCSymbol &Sym);
 
@@ -730,6 +736,12 @@ public:
   /// \brief Emit the given \p Instruction into the current section.
   virtual void EmitInstruction(MCInst &Inst, const MCSubtargetInfo &STI, unsigned int &KsError);
 
+  /// \brief Emit an instruction the target parser encoded by itself, which
+  /// needs no fixup nor relaxation. Returns false, emitting nothing, if the
+  /// streamer has to see the MCInst, in which case the caller should go
+  /// through EmitInstruction() instead.
+  virtual bool EmitEncodedInstruction(StringRef Code) { return false; }
+
   /// \brief Set the bundle alignment mode from now on in the section.
   /// The argument is the power of 2 to which the alignment is set. The
   /// value 0 means turn the bundle alignment off.
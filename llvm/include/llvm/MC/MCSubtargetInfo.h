@@ -190,6 +190,9 @@ public:
     return Found != ProcDesc.end() && StringRef(Found->Key) == CPU;
   }
 
+  /// Check whether every flag in the feature string names a known feature.
+  bool isFeatureStringValid(StringRef FS) const;
+
   /// Returns string representation of scheduler comment
   virtual std::string getSchedInfoStr(const MachineInstr &MI) const {
     return {};
@@ -27,6 +27,22 @@ public:
   bool MCFatalWarnings : 1;
   bool MCNoWarn : 1;
   bool ShowMCEncoding : 1;
+  /// Group unbundled instructions into packets automatically (VLIW targets).
+  bool MCAutoPacketize : 1;
+  /// Pick the shortest equivalent encoding of each instruction.
+  bool MCOptimizeSize : 1;
+  /// Pick encodings whose size does not depend on immediate, displacement
+  /// or branch target values, so they can be patched in place.
+  bool MCFixedWidth : 1;
+  /// Address symbols RIP-relative when they are within reach of the
+  /// instruction, and absolutely otherwise (X86-64).
+  bool MCRIPRelative : 1;
+  /// Fill branch delay slots with a preceding instruction rather than a nop,
+  /// where the assembler is allowed to reorder (Mips .set reorder).
+  bool MCFillDelaySlots : 1;
+  /// Address of a table of 64-bit counters, one per basic block, which the
+  /// instrumented code increments (X86). 0 if off.
+  uint64_t MCBlockCounters;
   int DwarfVersion;
   /// getABIName - If this returns a non-empty string this represents the
   /// textual name of the ABI that we want the backend to use, e.g. o32, or
@@ -501,6 +501,29 @@ public:
   StringRef str() { return StringRef(OS.data(), OS.size()); }
 };
 
+/// A raw_ostream for short outputs such as one encoded instruction. The
+/// first bytes go straight into a fixed buffer inside the stream, so
+/// writing a byte is an inline store rather than a virtual call, and only
+/// longer outputs spill to the heap.
+class raw_inline_ostream : public raw_ostream {
+  char Inline[32];
+  SmallVector<char, 0> Spill;
+
+  /// See raw_ostream::write_impl.
+  void write_impl(const char *Ptr, size_t Size) override;
+
+  /// Return the current position within the stream, not counting the bytes
+  /// currently in the buffer.
+  uint64_t current_pos() const override;
+
+public:
+  explicit raw_inline_ostream() { SetBuffer(Inline, sizeof(Inline)); }
+  ~raw_inline_ostream() override;
+
+  /// Return everything written so far.
+  StringRef str();
+};
+
 /// A raw_ostream that discards all output.
 class raw_null_ostream : public raw_pwrite_stream {
   /// See raw_ostream::write_impl.
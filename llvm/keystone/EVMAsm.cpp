@@ -0,0 +1,216 @@
+/* Keystone Assembler Engine */
+
+#include <ctype.h>
+#include <string.h>
+
+#include <string>
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+
+#include "../../include/keystone/evm.h"
+#include "EVMAsm.h"
+#include "EVMMapping.h"
+#include "evm.h"
+
+using namespace llvm_ks;
+
+namespace {
+
+struct EVMStatement {
+    unsigned char Opcode;
+    bool AutoWidth = false;             // "push": narrowest PUSHn
+    unsigned Width = 0;                 // bytes of immediate
+    SmallVector<unsigned char, 32> Imm; // big-endian, no leading zeros
+    std::string Symbol;                 // label to push instead of Imm
+};
+
+} // end anonymous namespace
+
+static bool isIdentifier(StringRef Name)
+{
+    if (Name.empty() || isdigit((unsigned char)Name[0]))
+        return false;
+
+    for (char C : Name) {
+        if (!isalnum((unsigned char)C) && C != '_' && C != '.' && C != '$')
+            return false;
+    }
+
+    return true;
+}
+
+// big-endian bytes of Value, without leading zeros
+static void getValueBytes(uint64_t Value, SmallVectorImpl<unsigned char> &Bytes)
+{
+    Bytes.clear();
+    for (int Shift = 56; Shift >= 0; Shift -= 8) {
+        unsigned char B = (unsigned char)(Value >> Shift);
+        if (B || !Bytes.empty())
+            Bytes.push_back(B);
+    }
+}
+
+// parse a decimal or 0x-prefixed hexadecimal number of up to 256 bits
+static bool parseImmediate(StringRef S, SmallVectorImpl<unsigned char> &Bytes)
+{
+    unsigned Radix = 10;
+    if (S.startswith_lower("0x")) {
+        Radix = 16;
+        S = S.drop_front(2);
+    }
+    if (S.empty())
+        return false;
+
+    // 256-bit accumulator, big-endian
+    unsigned char Value[32];
+    memset(Value, 0, sizeof(Value));
+    for (char C : S) {
+        unsigned Digit;
+        if (isdigit((unsigned char)C))
+            Digit = C - '0';
+        else if (Radix == 16 && isxdigit((unsigned char)C))
+            Digit = tolower((unsigned char)C) - 'a' + 10;
+        else
+            return false;
+
+        unsigned Carry = Digit;
+        for (int i = sizeof(Value) - 1; i >= 0; i--) {
+            Carry += Value[i] * Radix;
+            Value[i] = (unsigned char)Carry;
+            Carry >>= 8;
+        }
+        if (Carry)
+            return false;   // does not fit PUSH32
+    }
+
+    Bytes.clear();
+    for (unsigned char B : Value) {
+        if (B || !Bytes.empty())
+            Bytes.push_back(B);
+    }
+
+    return true;
+}
+
+unsigned int EVM_assemble(StringRef Source, uint64_t Address,
+                          ks_sym_resolver Resolver,
+                          std::vector<unsigned char> &Code, size_t &Count)
+{
+    std::vector<EVMStatement> Insts;
+    // index of the instruction following each label
+    StringMap<size_t> Labels;
+
+    // a comment runs to the end of the line, ';' included
+    SmallVector<StringRef, 64> Stmts;
+    while (!Source.empty()) {
+        std::pair<StringRef, StringRef> Line = Source.split('\n');
+        Source = Line.second;
+        Line.first.split("//").first.split(Stmts, ';');
+    }
+
+    for (StringRef Stmt : Stmts) {
+        Stmt = Stmt.trim();
+
+        // label definitions
+        size_t Colon;
+        while ((Colon = Stmt.find(':')) != StringRef::npos) {
+            StringRef Name = Stmt.substr(0, Colon).trim();
+            if (!isIdentifier(Name))
+                return KS_ERR_ASM_LABEL_INVALID;
+            if (!Labels.insert(std::make_pair(Name, Insts.size())).second)
+                return KS_ERR_ASM_SYMBOL_REDEFINED;
+            Stmt = Stmt.substr(Colon + 1).ltrim();
+        }
+        if (Stmt.empty())
+            continue;
+
+        size_t Space = Stmt.find_first_of(" \t");
+        StringRef Mnemonic = Stmt.substr(0, Space);
+        StringRef Operand = Space == StringRef::npos ? StringRef() :
+            Stmt.substr(Space).trim();
+
+        EVMStatement Inst;
+        if (Mnemonic.equals_lower("push")) {
+            Inst.Opcode = EVM_INS_PUSH1;
+            Inst.AutoWidth = true;
+        } else {
+            unsigned short Opcode = EVM_opcode(Mnemonic);
+            if (Opcode == (unsigned short)-1)
+                return KS_ERR_ASM_EVM_MNEMONICFAIL;
+            Inst.Opcode = (unsigned char)Opcode;
+        }
+
+        if (Inst.Opcode >= EVM_INS_PUSH1 && Inst.Opcode <= EVM_INS_PUSH32) {
+            Inst.Width = Inst.Opcode - EVM_INS_PUSH1 + 1;
+            if (parseImmediate(Operand, Inst.Imm)) {
+                if (Inst.AutoWidth)
+                    Inst.Width = Inst.Imm.empty() ? 1 : Inst.Imm.size();
+                else if (Inst.Imm.size() > Inst.Width)
+                    return KS_ERR_ASM_EVM_INVALIDOPERAND;
+            } else if (isIdentifier(Operand))
+                Inst.Symbol = Operand;
+            else
+                return KS_ERR_ASM_EVM_INVALIDOPERAND;
+        } else if (!Operand.empty())
+            return KS_ERR_ASM_EVM_INVALIDOPERAND;
+
+        Insts.push_back(std::move(Inst));
+    }
+
+    // labels defined elsewhere are constants from the resolver
+    for (EVMStatement &Inst : Insts) {
+        if (Inst.Symbol.empty() || Labels.count(Inst.Symbol))
+            continue;
+        uint64_t Value;
+        if (!Resolver || !Resolver(Inst.Symbol.c_str(), &Value))
+            return KS_ERR_ASM_SYMBOL_MISSING;
+        getValueBytes(Value, Inst.Imm);
+        Inst.Symbol.clear();
+        if (Inst.AutoWidth)
+            Inst.Width = Inst.Imm.empty() ? 1 : Inst.Imm.size();
+        else if (Inst.Imm.size() > Inst.Width)
+            return KS_ERR_ASM_EVM_INVALIDOPERAND;
+    }
+
+    // Relax: every "push label" starts as PUSH1 and only grows until all
+    // label addresses fit, so this terminates.
+    std::vector<uint64_t> Offsets(Insts.size() + 1);
+    bool Changed;
+    do {
+        Changed = false;
+        uint64_t Offset = 0;
+        for (size_t i = 0; i < Insts.size(); i++) {
+            Offsets[i] = Offset;
+            Offset += 1 + Insts[i].Width;
+        }
+        Offsets[Insts.size()] = Offset;
+
+        for (EVMStatement &Inst : Insts) {
+            if (Inst.Symbol.empty())
+                continue;
+            getValueBytes(Address + Offsets[Labels[Inst.Symbol]], Inst.Imm);
+            if (Inst.AutoWidth && Inst.Imm.size() > Inst.Width) {
+                Inst.Width = Inst.Imm.size();
+                Changed = true;
+            }
+        }
+    } while (Changed);
+
+    Code.clear();
+    Code.reserve(Offsets.back());
+    for (const EVMStatement &Inst : Insts) {
+        if (Inst.Imm.size() > Inst.Width)
+            return KS_ERR_ASM_EVM_INVALIDOPERAND;
+        if (Inst.AutoWidth)
+            Code.push_back((unsigned char)(EVM_INS_PUSH1 + Inst.Width - 1));
+        else
+            Code.push_back(Inst.Opcode);
+        Code.insert(Code.end(), Inst.Width - Inst.Imm.size(), 0);
+        Code.insert(Code.end(), Inst.Imm.begin(), Inst.Imm.end());
+    }
+
+    Count = Insts.size();
+
+    return 0;
+}
@@ -0,0 +1,23 @@
+/* Keystone Assembler Engine */
+
+#ifndef KS_EVMASM_H
+#define KS_EVMASM_H
+
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+
+#include "../../include/keystone/keystone.h"
+
+// Assemble EVM source into Code, with the first byte at address Address.
+// Statements are separated by newlines or ';' and are made of optional
+// "label:" definitions followed by an optional instruction; "//" starts a
+// comment. PUSH1..PUSH32 take a number or a label, and "push" picks the
+// narrowest PUSHn that fits its operand. Labels missing from the source
+// are asked to Resolver. Count receives the number of instructions.
+// Return 0 on success, or a KS_ERR_* code on failure.
+unsigned int EVM_assemble(llvm_ks::StringRef Source, uint64_t Address,
+                          ks_sym_resolver Resolver,
+                          std::vector<unsigned char> &Code, size_t &Count);
+
+#endif
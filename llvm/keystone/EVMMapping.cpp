@@ -1,13 +1,19 @@
 /* Capstone Disassembly Engine */
 /* By Nguyen Anh Quynh, 2018 */
 
-#include <string.h>
+#include <ctype.h>
+
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
 
 #include "EVMMapping.h"
 #include "evm.h"
 
 #define ARR_SIZE(a) (sizeof(a)/sizeof(a[0]))
 
+using namespace llvm_ks;
+
 // map id to string
 typedef struct name_map {
     unsigned short id;
@@ -273,22 +279,133 @@ static name_map insn_name_maps[] = {
     { EVM_INS_SUICIDE, "suicide" },
 };
 
-#if defined(_WIN32) || defined(_WIN64)
-#define strcasecmp _stricmp
-#endif
+// find opcode of this mnemonic, or return -1 on failure
+unsigned short EVM_opcode(StringRef mnemonic)
+{
+    // mnemonics hashed in lower case, built on first use
+    static const StringMap<unsigned short> Opcodes = [] {
+        StringMap<unsigned short> Map;
+        for (unsigned int i = 0; i < ARR_SIZE(insn_name_maps); i++) {
+            if (insn_name_maps[i].name)
+                Map[insn_name_maps[i].name] = insn_name_maps[i].id;
+        }
+        return Map;
+    }();
+
+    char lower[16];
+    if (mnemonic.size() > sizeof(lower))
+        return (unsigned short)-1;
+    for (size_t i = 0; i < mnemonic.size(); i++)
+        lower[i] = (char)tolower((unsigned char)mnemonic[i]);
 
-#include <stdio.h>
+    auto I = Opcodes.find(StringRef(lower, mnemonic.size()));
+    if (I == Opcodes.end())
+        return (unsigned short)-1;
 
-// find opcode of this mnemonic, or return -1 on failure
-unsigned short EVM_opcode(const char *mnemonic)
+    return I->second;
+}
+
+// static gas of each opcode, Byzantium fee schedule
+typedef struct gas_map {
+    unsigned short id;
+    unsigned short gas;
+    bool dynamic;   // also depends on operands, memory, storage or callee
+} gas_map;
+
+static gas_map insn_gas_maps[] = {
+    { EVM_INS_STOP, 0, false },
+    { EVM_INS_ADD, 3, false },
+    { EVM_INS_MUL, 5, false },
+    { EVM_INS_SUB, 3, false },
+    { EVM_INS_DIV, 5, false },
+    { EVM_INS_SDIV, 5, false },
+    { EVM_INS_MOD, 5, false },
+    { EVM_INS_SMOD, 5, false },
+    { EVM_INS_ADDMOD, 8, false },
+    { EVM_INS_MULMOD, 8, false },
+    { EVM_INS_EXP, 10, true },          // + 50 per byte of exponent
+    { EVM_INS_SIGNEXTEND, 5, false },
+    { EVM_INS_LT, 3, false },
+    { EVM_INS_GT, 3, false },
+    { EVM_INS_SLT, 3, false },
+    { EVM_INS_SGT, 3, false },
+    { EVM_INS_EQ, 3, false },
+    { EVM_INS_ISZERO, 3, false },
+    { EVM_INS_AND, 3, false },
+    { EVM_INS_OR, 3, false },
+    { EVM_INS_XOR, 3, false },
+    { EVM_INS_NOT, 3, false },
+    { EVM_INS_BYTE, 3, false },
+    { EVM_INS_SHA3, 30, true },         // + 6 per word, memory
+    { EVM_INS_ADDRESS, 2, false },
+    { EVM_INS_BALANCE, 400, false },
+    { EVM_INS_ORIGIN, 2, false },
+    { EVM_INS_CALLER, 2, false },
+    { EVM_INS_CALLVALUE, 2, false },
+    { EVM_INS_CALLDATALOAD, 3, false },
+    { EVM_INS_CALLDATASIZE, 2, false },
+    { EVM_INS_CALLDATACOPY, 3, true },  // + 3 per word, memory
+    { EVM_INS_CODESIZE, 2, false },
+    { EVM_INS_CODECOPY, 3, true },      // + 3 per word, memory
+    { EVM_INS_GASPRICE, 2, false },
+    { EVM_INS_EXTCODESIZE, 700, false },
+    { EVM_INS_EXTCODECOPY, 700, true }, // + 3 per word, memory
+    { EVM_INS_RETURNDATASIZE, 2, false },
+    { EVM_INS_RETURNDATACOPY, 3, true },    // + 3 per word, memory
+    { EVM_INS_BLOCKHASH, 20, false },
+    { EVM_INS_COINBASE, 2, false },
+    { EVM_INS_TIMESTAMP, 2, false },
+    { EVM_INS_NUMBER, 2, false },
+    { EVM_INS_DIFFICULTY, 2, false },
+    { EVM_INS_GASLIMIT, 2, false },
+    { EVM_INS_POP, 2, false },
+    { EVM_INS_MLOAD, 3, true },         // memory
+    { EVM_INS_MSTORE, 3, true },        // memory
+    { EVM_INS_MSTORE8, 3, true },       // memory
+    { EVM_INS_SLOAD, 200, false },
+    { EVM_INS_SSTORE, 5000, true },     // 20000 to set a zero slot
+    { EVM_INS_JUMP, 8, false },
+    { EVM_INS_JUMPI, 10, false },
+    { EVM_INS_PC, 2, false },
+    { EVM_INS_MSIZE, 2, false },
+    { EVM_INS_GAS, 2, false },
+    { EVM_INS_JUMPDEST, 1, false },
+    { EVM_INS_LOG0, 375, true },        // + 8 per byte, memory
+    { EVM_INS_LOG1, 750, true },
+    { EVM_INS_LOG2, 1125, true },
+    { EVM_INS_LOG3, 1500, true },
+    { EVM_INS_LOG4, 1875, true },
+    { EVM_INS_CREATE, 32000, true },
+    { EVM_INS_CALL, 700, true },        // value transfer, new account, callee
+    { EVM_INS_CALLCODE, 700, true },
+    { EVM_INS_RETURN, 0, true },        // memory
+    { EVM_INS_DELEGATECALL, 700, true },
+    { EVM_INS_STATICCALL, 700, true },
+    { EVM_INS_REVERT, 0, true },        // memory
+    { EVM_INS_SUICIDE, 5000, true },    // + 25000 for a new account
+};
+
+// get static gas of this opcode, or return -1 if it is not defined
+int EVM_gas(unsigned char opcode, bool *dynamic)
 {
-    unsigned int i;
+    // indexed by opcode, built on first use
+    static const std::vector<const gas_map *> Costs = [] {
+        std::vector<const gas_map *> Table(256, nullptr);
+        for (unsigned int i = 0; i < ARR_SIZE(insn_gas_maps); i++)
+            Table[insn_gas_maps[i].id] = &insn_gas_maps[i];
+        return Table;
+    }();
 
-    for(i = 0; i < ARR_SIZE(insn_name_maps); i++) {
-        if (insn_name_maps[i].name && !strcasecmp(insn_name_maps[i].name, mnemonic)) {
-            return (unsigned short)insn_name_maps[i].id;
-        }
+    *dynamic = false;
+    if (opcode >= EVM_INS_PUSH1 && opcode <= EVM_INS_SWAP16)
+        return 3;   // PUSHn, DUPn & SWAPn
+
+    if (!Costs[opcode]) {
+        // INVALID and the rest consume all remaining gas
+        *dynamic = true;
+        return -1;
     }
 
-    return (unsigned short)-1;
+    *dynamic = Costs[opcode]->dynamic;
+    return Costs[opcode]->gas;
 }
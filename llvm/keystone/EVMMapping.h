@@ -1,7 +1,13 @@
 #ifndef KS_EVMMAPPING_H
 #define KS_EVMMAPPING_H
 
-// find opcode of this mnemonic, or return -1 on failure
-unsigned short EVM_opcode(const char *mnemonic);
+#include "llvm/ADT/StringRef.h"
+
+// find opcode of this mnemonic (in any case), or return -1 on failure
+unsigned short EVM_opcode(llvm_ks::StringRef mnemonic);
+
+// get static gas of this opcode, or return -1 if it is not defined.
+// *dynamic tells if the actual cost also depends on runtime values.
+int EVM_gas(unsigned char opcode, bool *dynamic);
 
 #endif
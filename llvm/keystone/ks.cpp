@@ -12,10 +12,18 @@
 
 #include "llvm/MC/MCObjectFileInfo.h"
 #include "llvm/MC/MCCodeEmitter.h"
+#include "llvm/MC/MCParser/MCParsedAsmOperand.h"
+#include "llvm/MC/MCSchedAnalysis.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Host.h"
 
 // FIXME: setup this with CMake
 #define LLVM_ENABLE_ARCH_EVM
+#include "EVMAsm.h"
 #include "EVMMapping.h"
+#include "evm.h"
 
 // DEBUG
 //#include <iostream>
@@ -64,6 +72,8 @@ const char *ks_strerror(ks_err code)
             return "Different API version between core & binding (KS_ERR_VERSION)";
         case KS_ERR_OPT_INVALID:
             return "Invalid option (KS_ERR_OPT_INVALID)";
+        case KS_ERR_NO_SCHED_MODEL:
+            return "No scheduling model for this CPU (KS_ERR_NO_SCHED_MODEL)";
         case KS_ERR_ASM_INVALIDOPERAND:
             return "Invalid operand (KS_ERR_ASM_INVALIDOPERAND)";
         case KS_ERR_ASM_MISSINGFEATURE:
@@ -200,10 +210,90 @@ static const Target *GetTarget(std::string TripleName)
 }
 
 
+// CPU used when the caller did not choose one with KS_OPT_CPU
+static std::string GetDefaultCPU(ks_engine *ks)
+{
+    // enable Knights Landing architecture for X86
+    if (ks->arch == KS_ARCH_X86)
+        return "knl";
+
+    return "";
+}
+
+
+// features every handle of this arch/mode needs, whatever the CPU
+static std::string GetDefaultFeatures(ks_engine *ks)
+{
+    std::string Features;
+
+    if (ks->arch == KS_ARCH_RISCV) {
+        Features = "+m,+a,+f,+d";
+        if (ks->mode & KS_MODE_RISCVC)
+            Features += ",+c";
+    }
+
+    return Features;
+}
+
+
+// (re)build subtarget & asm backend for the current CPU and features.
+// the caller must have validated ks->CPU & the feature strings already.
+static void InitSubtarget(ks_engine *ks)
+{
+    ks->FeaturesStr = GetDefaultFeatures(ks);
+    for (const std::string *F : { &ks->HostFeatures, &ks->UserFeatures }) {
+        if (F->empty())
+            continue;
+        if (!ks->FeaturesStr.empty())
+            ks->FeaturesStr += ",";
+        ks->FeaturesStr += *F;
+    }
+
+    delete ks->STI;
+    delete ks->MAB;
+
+    ks->STI = ks->TheTarget->createMCSubtargetInfo(ks->TripleName, ks->CPU, ks->FeaturesStr);
+    // X86AsmBackend keeps a reference to the CPU name, so pass ks->CPU itself
+    ks->MAB = ks->TheTarget->createMCAsmBackend(*ks->MRI, ks->TripleName, ks->CPU);
+    ks->MAB->setArch(ks->arch);
+    ks->MAB->setAlignBranch(ks->align_branch_boundary, ks->align_branch_type);
+}
+
+
+// resolve "native" to the CPU name & features of the host.
+// return false if the host is not a variant of this handle's arch.
+static bool GetHostCPU(ks_engine *ks, std::string &CPU, std::string &Features)
+{
+    Triple Host(sys::getProcessTriple());
+    Triple Target(ks->TripleName);
+
+    if (Host.getArch() != Target.getArch() &&
+            Host.get32BitArchVariant().getArch() != Target.getArch())
+        return false;
+
+    CPU = sys::getHostCPUName();
+    if (!ks->STI->isCPUStringValid(CPU))
+        return false;
+
+    SubtargetFeatures HostFeatures;
+    StringMap<bool> FeatureMap;
+    if (sys::getHostCPUFeatures(FeatureMap)) {
+        for (auto &F : FeatureMap) {
+            std::string Flag = (F.second ? "+" : "-") + F.first().str();
+            // skip what the host reports but this target does not model
+            if (ks->STI->isFeatureStringValid(Flag))
+                HostFeatures.AddFeature(Flag);
+        }
+    }
+    Features = HostFeatures.getString();
+
+    return true;
+}
+
+
 static ks_err InitKs(int arch, ks_engine *ks, std::string TripleName)
 {
     static bool initialized = false;
-    std::string MCPU = "";
 
     if (!initialized) {
         initialized = true;
@@ -238,20 +328,9 @@ static ks_err InitKs(int arch, ks_engine *ks, std::string TripleName)
     ks->MAI = ks->TheTarget->createMCAsmInfo(*ks->MRI, ks->TripleName);
     assert(ks->MAI && "Unable to create target asm info!");
 
-    // enable Knights Landing architecture for X86
-    if (ks->arch == KS_ARCH_X86)
-        MCPU = "knl";
-
-    if (ks->arch == KS_ARCH_RISCV) {
-        ks->FeaturesStr = "+m,+a,+f,+d";
-        if (ks->mode & KS_MODE_RISCVC)
-            ks->FeaturesStr += ",+c";
-    }
-
     ks->MCII = ks->TheTarget->createMCInstrInfo();
-    ks->STI = ks->TheTarget->createMCSubtargetInfo(ks->TripleName, MCPU, ks->FeaturesStr);
-    ks->MAB = ks->TheTarget->createMCAsmBackend(*ks->MRI, ks->TripleName, MCPU);
-    ks->MAB->setArch(arch);
+    ks->CPU = GetDefaultCPU(ks);
+    InitSubtarget(ks);
     ks->MCOptions = InitMCTargetOptionsFromFlags();
 
     return KS_ERR_OK;
@@ -549,7 +628,9 @@ ks_err ks_close(ks_engine *ks)
 KEYSTONE_EXPORT
 ks_err ks_option(ks_engine *ks, ks_opt_type type, size_t value)
 {
-    ks->MAI->setRadix(16);
+    // EVM has no MC layer
+    if (ks->MAI)
+        ks->MAI->setRadix(16);
     switch(type) {
         case KS_OPT_SYNTAX:
             if (ks->arch != KS_ARCH_X86)
@@ -580,12 +661,114 @@ ks_err ks_option(ks_engine *ks, ks_opt_type type, size_t value)
         case KS_OPT_SYM_RESOLVER:
             ks->sym_resolver = (ks_sym_resolver)value;
             return KS_ERR_OK;
+        case KS_OPT_PACKETIZE:
+            if (ks->arch != KS_ARCH_HEXAGON)
+                return KS_ERR_OPT_INVALID;
+            ks->MCOptions.MCAutoPacketize = (value != 0);
+            return KS_ERR_OK;
+        case KS_OPT_ALIGN_BRANCH_BOUNDARY:
+            if (ks->arch != KS_ARCH_X86)
+                return KS_ERR_OPT_INVALID;
+            // 0 turns alignment off, otherwise a power of 2 no less than 16
+            if (value != 0 && (value < 16 || (value & (value - 1))))
+                return KS_ERR_OPT_INVALID;
+            if (!ks->MAB->setAlignBranch(value, ks->align_branch_type))
+                return KS_ERR_OPT_INVALID;
+            ks->align_branch_boundary = value;
+            return KS_ERR_OK;
+        case KS_OPT_ALIGN_BRANCH_TYPE:
+            if (ks->arch != KS_ARCH_X86)
+                return KS_ERR_OPT_INVALID;
+            if (value & ~(size_t)(KS_OPT_ALIGN_BRANCH_FUSED | KS_OPT_ALIGN_BRANCH_JCC |
+                        KS_OPT_ALIGN_BRANCH_JMP | KS_OPT_ALIGN_BRANCH_CALL |
+                        KS_OPT_ALIGN_BRANCH_RET | KS_OPT_ALIGN_BRANCH_INDIRECT))
+                return KS_ERR_OPT_INVALID;
+            if (!ks->MAB->setAlignBranch(ks->align_branch_boundary, value))
+                return KS_ERR_OPT_INVALID;
+            ks->align_branch_type = value;
+            return KS_ERR_OK;
+        case KS_OPT_CPU: {
+            if (!ks->STI)
+                return KS_ERR_OPT_INVALID;
+            // NULL or "" restores the default CPU of this arch
+            StringRef Name = value ? (const char *)value : "";
+            std::string CPU, HostFeatures;
+            if (Name.empty())
+                CPU = GetDefaultCPU(ks);
+            else if (Name == "native") {
+                if (!GetHostCPU(ks, CPU, HostFeatures))
+                    return KS_ERR_OPT_INVALID;
+            } else {
+                // check first: LLVM complains on stderr about unknown CPUs
+                if (!ks->STI->isCPUStringValid(Name))
+                    return KS_ERR_OPT_INVALID;
+                CPU = Name;
+            }
+            ks->CPU = CPU;
+            ks->HostFeatures = HostFeatures;
+            InitSubtarget(ks);
+            return KS_ERR_OK;
+        }
+        case KS_OPT_FEATURES: {
+            if (!ks->STI)
+                return KS_ERR_OPT_INVALID;
+            // NULL or "" drops the features set earlier
+            StringRef Features = value ? (const char *)value : "";
+            if (!ks->STI->isFeatureStringValid(Features))
+                return KS_ERR_OPT_INVALID;
+            ks->UserFeatures = Features;
+            InitSubtarget(ks);
+            return KS_ERR_OK;
+        }
+        case KS_OPT_OPTIMIZE_SIZE:
+            if (ks->arch != KS_ARCH_X86 && ks->arch != KS_ARCH_SYSTEMZ)
+                return KS_ERR_OPT_INVALID;
+            ks->MCOptions.MCOptimizeSize = (value != 0);
+            return KS_ERR_OK;
+        case KS_OPT_FIXED_WIDTH:
+            if (!ks->STI)
+                return KS_ERR_OPT_INVALID;
+            ks->MCOptions.MCFixedWidth = (value != 0);
+            return KS_ERR_OK;
+        case KS_OPT_RIP_RELATIVE:
+            if (ks->arch != KS_ARCH_X86 || ks->mode != KS_MODE_64)
+                return KS_ERR_OPT_INVALID;
+            ks->MCOptions.MCRIPRelative = (value != 0);
+            return KS_ERR_OK;
+        case KS_OPT_FILL_DELAY_SLOTS:
+            if (ks->arch != KS_ARCH_MIPS)
+                return KS_ERR_OPT_INVALID;
+            ks->MCOptions.MCFillDelaySlots = (value != 0);
+            return KS_ERR_OK;
+        case KS_OPT_BLOCK_COUNTERS:
+            if (ks->arch != KS_ARCH_X86 || ks->mode == KS_MODE_16)
+                return KS_ERR_OPT_INVALID;
+            // a 32-bit counter table must be addressable from 32-bit code
+            if (ks->mode == KS_MODE_32 && (uint64_t)value > 0xffffffff)
+                return KS_ERR_OPT_INVALID;
+            ks->MCOptions.MCBlockCounters = value;
+            return KS_ERR_OK;
     }
 
     return KS_ERR_OPT_INVALID;
 }
 
 
+KEYSTONE_EXPORT
+size_t ks_bytes_saved(ks_engine *ks)
+{
+    return ks->bytes_saved;
+}
+
+
+KEYSTONE_EXPORT
+size_t ks_block_counters(ks_engine *ks, const size_t **lines)
+{
+    *lines = ks->block_lines.data();
+    return ks->block_lines.size();
+}
+
+
 KEYSTONE_EXPORT
 void ks_free(unsigned char *p)
 {
@@ -596,37 +779,18 @@ void ks_free(unsigned char *p)
  @return: 0 on success, or -1 on failure.
  On failure, call ks_errno() for error code.
 */
-KEYSTONE_EXPORT
-int ks_asm(ks_engine *ks,
-        const char *assembly,
-        uint64_t address,
-        unsigned char **insn, size_t *insn_size,
-        size_t *stat_count)
+// Set up the code emitter, object streamer and parsers of one ks_asm() or
+// ks_encode() call over Source, let Run drive them and keep its error code
+// in ks->errnum, then tear everything down. The machine code lands in Code.
+// Return KS_ERR_NOMEM if any piece cannot be created, or 0.
+static unsigned int RunMC(ks_engine *ks, StringRef Source, uint64_t address,
+        SmallVectorImpl<char> &Code,
+        function_ref<unsigned int(MCAsmParser &, MCTargetAsmParser &,
+                                  MCStreamer &)> Run)
 {
     MCCodeEmitter *CE;
     MCStreamer *Streamer;
-    unsigned char *encoding;
-    SmallString<1024> Msg;
-    raw_svector_ostream OS(Msg);
-
-    if (ks->arch == KS_ARCH_EVM) {
-        // handle EVM differently
-        unsigned short opcode = EVM_opcode(assembly);
-        if (opcode == (unsigned short)-1) {
-            // invalid instruction
-            return -1;
-        }
-
-        *insn_size = 1;
-        *stat_count = 1;
-        encoding = (unsigned char *)malloc(*insn_size);
-        encoding[0] = opcode;
-        *insn = encoding;
-        return 0;
-    }
-
-    *insn = NULL;
-    *insn_size = 0;
+    raw_svector_ostream OS(Code);
 
     MCContext Ctx(ks->MAI, ks->MRI, &ks->MOFI, &ks->SrcMgr, true, address);
     ks->MOFI.InitMCObjectFileInfo(Triple(ks->TripleName), Ctx);
@@ -636,7 +800,9 @@ int ks_asm(ks_engine *ks,
         return KS_ERR_NOMEM;
     }
     Streamer = ks->TheTarget->createMCObjectStreamer(
-            Triple(ks->TripleName), Ctx, *ks->MAB, OS, CE, *ks->STI, ks->MCOptions.MCRelaxAll,
+            Triple(ks->TripleName), Ctx, *ks->MAB, OS, CE, *ks->STI,
+            // fixed width also means every branch gets its long form
+            ks->MCOptions.MCRelaxAll || ks->MCOptions.MCFixedWidth,
             /*DWARFMustBeAtTheEnd*/ false);
             
     if (!Streamer) {
@@ -646,17 +812,11 @@ int ks_asm(ks_engine *ks,
     }
 
     // Tell SrcMgr about this buffer, which is what the parser will pick up.
-    ErrorOr<std::unique_ptr<MemoryBuffer>> BufferPtr = MemoryBuffer::getMemBuffer(assembly);
-    if (BufferPtr.getError()) {
-        delete Streamer;
-        delete CE;
-        return KS_ERR_NOMEM;
-    }
-
     ks->SrcMgr.clearBuffers();
-    ks->SrcMgr.AddNewSourceBuffer(std::move(*BufferPtr), SMLoc());
+    ks->SrcMgr.AddNewSourceBuffer(MemoryBuffer::getMemBuffer(Source), SMLoc());
 
     Streamer->setSymResolver((void *)(ks->sym_resolver));
+    Streamer->setInstRecorder(ks->insts);
 
     MCAsmParser *Parser = createMCAsmParser(ks->SrcMgr, Ctx, *Streamer, *ks->MAI);
     if (!Parser) {
@@ -677,25 +837,72 @@ int ks_asm(ks_engine *ks,
 
     Parser->setTargetParser(*TAP);
 
-    // TODO: optimize this to avoid setting up NASM every time we call ks_asm()
-    if (ks->arch == KS_ARCH_X86 && ks->syntax == KS_OPT_SYNTAX_NASM) {
-        Parser->initializeDirectiveKindMap(KS_OPT_SYNTAX_NASM);
-        ks->MAI->setCommentString(";");
-    }
-
-    *stat_count = Parser->Run(false, address);
-
-    // PPC counts empty statement
-    if (ks->arch == KS_ARCH_PPC)
-        *stat_count = *stat_count / 2;
-
-    ks->errnum = Parser->KsError;
+    ks->errnum = Run(*Parser, *TAP, *Streamer);
+    ks->bytes_saved = TAP->getBytesSaved();
+    ArrayRef<unsigned> BlockLines = TAP->getBlockCounterLines();
+    ks->block_lines.assign(BlockLines.begin(), BlockLines.end());
 
     delete TAP;
     delete Parser;
     delete CE;
     delete Streamer;
 
+    return 0;
+}
+
+
+KEYSTONE_EXPORT
+int ks_asm(ks_engine *ks,
+        const char *assembly,
+        uint64_t address,
+        unsigned char **insn, size_t *insn_size,
+        size_t *stat_count)
+{
+    unsigned char *encoding;
+    SmallString<1024> Msg;
+
+    if (ks->arch == KS_ARCH_EVM) {
+        // handle EVM differently
+        std::vector<unsigned char> Code;
+        ks->errnum = EVM_assemble(assembly, address, ks->sym_resolver,
+                                  Code, *stat_count);
+        if (ks->errnum)
+            return -1;
+
+        *insn_size = Code.size();
+        encoding = (unsigned char *)malloc(*insn_size);
+        if (!encoding) {
+            return KS_ERR_NOMEM;
+        }
+        memcpy(encoding, Code.data(), *insn_size);
+        *insn = encoding;
+        return 0;
+    }
+
+    *insn = NULL;
+    *insn_size = 0;
+    ks->bytes_saved = 0;
+    ks->block_lines.clear();
+
+    unsigned int err = RunMC(ks, assembly, address, Msg,
+            [&](MCAsmParser &Parser, MCTargetAsmParser &TAP, MCStreamer &Out) {
+        // TODO: optimize this to avoid setting up NASM every time we call ks_asm()
+        if (ks->arch == KS_ARCH_X86 && ks->syntax == KS_OPT_SYNTAX_NASM) {
+            Parser.initializeDirectiveKindMap(KS_OPT_SYNTAX_NASM);
+            ks->MAI->setCommentString(";");
+        }
+
+        *stat_count = Parser.Run(false, address);
+
+        // PPC counts empty statement
+        if (ks->arch == KS_ARCH_PPC)
+            *stat_count = *stat_count / 2;
+
+        return Parser.KsError;
+    });
+    if (err)
+        return err;
+
     if (ks->errnum >= KS_ERR_ASM)
         return -1;
     else {
@@ -709,3 +916,251 @@ int ks_asm(ks_engine *ks,
         return 0;
     }
 }
+
+KEYSTONE_EXPORT
+unsigned int ks_reg_id(ks_engine *ks, const char *name)
+{
+    if (ks->arch == KS_ARCH_EVM)
+        return 0;
+
+    StringRef Name(name);
+    for (unsigned Reg = 1, e = ks->MRI->getNumRegs(); Reg != e; ++Reg) {
+        if (Name.equals_lower(ks->MRI->getName(Reg)))
+            return Reg;
+    }
+
+    return 0;
+}
+
+
+KEYSTONE_EXPORT
+int ks_encode(ks_engine *ks,
+        const char *mnemonic,
+        const ks_operand *ops, size_t count,
+        uint64_t address,
+        unsigned char **insn, size_t *insn_size)
+{
+    unsigned char *encoding;
+    SmallString<32> Msg;
+
+    *insn = NULL;
+    *insn_size = 0;
+    ks->bytes_saved = 0;
+    ks->block_lines.clear();
+
+    if (ks->arch == KS_ARCH_EVM) {
+        ks->errnum = KS_ERR_ARCH;
+        return -1;
+    }
+
+    // the parser wants a buffer, even though nothing gets lexed
+    unsigned int err = RunMC(ks, "", address, Msg,
+            [&](MCAsmParser &Parser, MCTargetAsmParser &TAP, MCStreamer &Out) {
+        Out.InitSections(false);
+
+        SmallVector<std::unique_ptr<MCParsedAsmOperand>, 8> Operands;
+        unsigned int ErrorCode = 0;
+        if (!TAP.createStructuredOperands(mnemonic, makeArrayRef(ops, count),
+                    Operands, ErrorCode)) {
+            unsigned Opcode;
+            uint64_t ErrorInfo;
+            if (TAP.MatchAndEmitInstruction(SMLoc(), Opcode, Operands, Out,
+                        ErrorInfo, false, ErrorCode, address) && !ErrorCode)
+                ErrorCode = KS_ERR_ASM_INVALIDOPERAND;
+        }
+        if (!ErrorCode)
+            TAP.flushPendingInstructions(Out, ErrorCode);
+        if (!ErrorCode)
+            ErrorCode = Out.Finish();
+        else
+            Out.Finish();
+
+        return ErrorCode;
+    });
+    if (err) {
+        ks->errnum = err;
+        return -1;
+    }
+
+    if (ks->errnum)
+        return -1;
+
+    *insn_size = Msg.size();
+    encoding = (unsigned char *)malloc(*insn_size);
+    if (!encoding) {
+        ks->errnum = KS_ERR_NOMEM;
+        return -1;
+    }
+    memcpy(encoding, Msg.data(), *insn_size);
+    *insn = encoding;
+    return 0;
+}
+
+KEYSTONE_EXPORT
+int ks_analyze(ks_engine *ks,
+        const char *assembly,
+        uint64_t address,
+        ks_analysis **analysis)
+{
+    *analysis = NULL;
+
+    if (!ks->STI || !ks->STI->getSchedModel().hasInstrSchedModel()) {
+        ks->errnum = KS_ERR_NO_SCHED_MODEL;
+        return -1;
+    }
+
+    // only opcodes & registers of these are looked at: their expressions
+    // die with the MCContext of ks_asm()
+    std::vector<MCInst> Insts;
+    unsigned char *encoding;
+    size_t size, count;
+
+    ks->insts = &Insts;
+    int err = ks_asm(ks, assembly, address, &encoding, &size, &count);
+    ks->insts = nullptr;
+    if (err) {
+        if (err != -1)
+            ks->errnum = err;
+        return -1;
+    }
+    ks_free(encoding);
+
+    MCSchedAnalysis Result;
+    analyzeSchedule(Insts, *ks->STI, *ks->MCII, *ks->MRI, Result);
+
+    ks_analysis *a = (ks_analysis *)calloc(1, sizeof(*a));
+    if (!a) {
+        ks->errnum = KS_ERR_NOMEM;
+        return -1;
+    }
+    a->insns = (ks_insn_timing *)calloc(Result.Insts.size() + 1, sizeof(ks_insn_timing));
+    if (!a->insns) {
+        free(a);
+        ks->errnum = KS_ERR_NOMEM;
+        return -1;
+    }
+
+    // resource 0 is the invalid unit
+    const MCSchedModel &SM = ks->STI->getSchedModel();
+    a->num_resources = std::min<size_t>(SM.getNumProcResourceKinds() - 1,
+            KS_ANALYSIS_MAX_RESOURCES);
+    for (size_t r = 0; r < a->num_resources; r++) {
+        a->resources[r] = SM.getProcResource(r + 1)->Name;
+        a->pressure[r] = Result.Pressure[r + 1];
+    }
+    a->throughput = Result.Throughput;
+    a->latency = Result.Latency;
+    a->uops = Result.NumMicroOps;
+    a->count = Result.Insts.size();
+    for (size_t i = 0; i < a->count; i++) {
+        const MCSchedAnalysis::InstTiming &T = Result.Insts[i];
+        a->insns[i].uops = T.NumMicroOps;
+        a->insns[i].latency = T.Latency;
+        a->insns[i].ready = T.Ready;
+        for (size_t r = 0; r < a->num_resources; r++)
+            a->insns[i].pressure[r] = T.Pressure[r + 1];
+    }
+
+    *analysis = a;
+    return 0;
+}
+
+
+KEYSTONE_EXPORT
+void ks_analysis_free(ks_analysis *analysis)
+{
+    if (analysis) {
+        free(analysis->insns);
+        free(analysis);
+    }
+}
+
+
+KEYSTONE_EXPORT
+int ks_evm_gas(ks_engine *ks,
+        const char *assembly,
+        uint64_t address,
+        ks_evm_cost **cost)
+{
+    *cost = NULL;
+
+    if (ks->arch != KS_ARCH_EVM) {
+        ks->errnum = KS_ERR_ARCH;
+        return -1;
+    }
+
+    std::vector<unsigned char> Code;
+    size_t count;
+    ks->errnum = EVM_assemble(assembly, address, ks->sym_resolver, Code, count);
+    if (ks->errnum)
+        return -1;
+
+    ks_evm_cost *c = (ks_evm_cost *)calloc(1, sizeof(*c));
+    if (c) {
+        c->insns = (ks_evm_insn_cost *)calloc(count + 1, sizeof(ks_evm_insn_cost));
+        c->blocks = (ks_evm_block_cost *)calloc(count + 1, sizeof(ks_evm_block_cost));
+    }
+    if (!c || !c->insns || !c->blocks) {
+        ks_evm_cost_free(c);
+        ks->errnum = KS_ERR_NOMEM;
+        return -1;
+    }
+
+    c->size = Code.size();
+    ks_evm_block_cost *block = NULL;
+    for (size_t offset = 0; offset < Code.size(); c->count++) {
+        unsigned char opcode = Code[offset];
+        ks_evm_insn_cost *insn = &c->insns[c->count];
+        insn->offset = offset;
+        insn->opcode = opcode;
+        int gas = EVM_gas(opcode, &insn->dynamic);
+        insn->gas = gas < 0 ? 0 : gas;
+
+        size_t size = 1;
+        if (opcode >= EVM_INS_PUSH1 && opcode <= EVM_INS_PUSH32)
+            size += opcode - EVM_INS_PUSH1 + 1;
+        offset += size;
+
+        // a JUMPDEST is where jumps enter a new block
+        if (!block || (opcode == EVM_INS_JUMPDEST && block->count)) {
+            block = &c->blocks[c->num_blocks++];
+            block->first = c->count;
+        }
+        block->count++;
+        block->size += size;
+        block->gas += insn->gas;
+        block->dynamic |= insn->dynamic;
+        c->gas += insn->gas;
+        c->dynamic |= insn->dynamic;
+
+        // and control leaves it after jumps and halts
+        switch (opcode) {
+            case EVM_INS_JUMP:
+            case EVM_INS_JUMPI:
+            case EVM_INS_STOP:
+            case EVM_INS_RETURN:
+            case EVM_INS_REVERT:
+            case EVM_INS_SUICIDE:
+                block = NULL;
+                break;
+            default:
+                if (gas < 0)
+                    block = NULL;
+                break;
+        }
+    }
+
+    *cost = c;
+    return 0;
+}
+
+
+KEYSTONE_EXPORT
+void ks_evm_cost_free(ks_evm_cost *cost)
+{
+    if (cost) {
+        free(cost->insns);
+        free(cost->blocks);
+        free(cost);
+    }
+}
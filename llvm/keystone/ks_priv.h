@@ -11,6 +11,7 @@
 #include "llvm/MC/MCAsmBackend.h"
 #include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCContext.h"
+#include "llvm/MC/MCInst.h"
 #include "llvm/MC/MCInstrInfo.h"
 #include "llvm/MC/MCParser/MCTargetAsmParser.h"
 #include "llvm/MC/MCTargetOptionsCommandFlags.h"
@@ -53,10 +54,18 @@ struct ks_struct {
     MCRegisterInfo *MRI = nullptr;
     MCAsmInfo *MAI = nullptr;
     MCInstrInfo *MCII = nullptr;
-    std::string FeaturesStr;
+    std::string CPU;            // current CPU name (KS_OPT_CPU)
+    std::string HostFeatures;   // detected host features when CPU is "native"
+    std::string UserFeatures;   // features given with KS_OPT_FEATURES
+    std::string FeaturesStr;    // arch defaults + HostFeatures + UserFeatures
     MCSubtargetInfo *STI = nullptr;
     MCObjectFileInfo MOFI;
     ks_sym_resolver sym_resolver = nullptr;
+    unsigned align_branch_boundary = 0;
+    unsigned align_branch_type = KS_OPT_ALIGN_BRANCH_FUSED | KS_OPT_ALIGN_BRANCH_JCC | KS_OPT_ALIGN_BRANCH_JMP;
+    size_t bytes_saved = 0;     // by KS_OPT_OPTIMIZE_SIZE in the last ks_asm()
+    std::vector<MCInst> *insts = nullptr;   // ks_asm() records here if set
+    std::vector<size_t> block_lines;    // by KS_OPT_BLOCK_COUNTERS in the last ks_asm()
 
     ks_struct(ks_arch arch, int mode, unsigned int errnum, ks_opt_value syntax)
         : arch(arch), mode(mode), errnum(errnum), syntax(syntax) { }
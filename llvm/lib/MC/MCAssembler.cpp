@@ -208,7 +208,7 @@ bool MCAssembler::evaluateFixup(const MCAsmLayout &Layout,
             ks_sym_resolver resolver = (ks_sym_resolver)KsSymResolver;
             if (resolver(Sym.getName().str().c_str(), &imm)) {
                 // resolver handled this symbol
-                Value = imm;
+                Value += imm;
                 IsResolved = true;
             } else {
                 // resolver did not handle this symbol
@@ -282,6 +282,9 @@ uint64_t MCAssembler::computeFragmentSize(const MCAsmLayout &Layout,
   case MCFragment::FT_SafeSEH:
     return 4;
 
+  case MCFragment::FT_BoundaryAlign:
+    return cast<MCBoundaryAlignFragment>(F).getSize();
+
   case MCFragment::FT_Align: {
     const MCAlignFragment &AF = cast<MCAlignFragment>(F);
     unsigned Offset = Layout.getFragmentOffset(&AF, valid);
@@ -576,6 +579,12 @@ static void writeFragment(const MCAssembler &Asm, const MCAsmLayout &Layout,
     break;
   }
 
+  case MCFragment::FT_BoundaryAlign:
+    if (!Asm.getBackend().writeNopData(FragmentSize, OW))
+      report_fatal_error("unable to write nop sequence of " +
+                        Twine(FragmentSize) + " bytes");
+    break;
+
   case MCFragment::FT_Org: {
     const MCOrgFragment &OF = cast<MCOrgFragment>(F);
 
@@ -768,6 +777,7 @@ void MCAssembler::layout(MCAsmLayout &Layout, unsigned int &KsError)
         if (KsError)
             return;
       }
+      getBackend().relaxFixedUpFragment(*this, Layout, Frag, Fixups, Contents);
     }
   }
 }
@@ -836,13 +846,14 @@ bool MCAssembler::relaxInstruction(MCAsmLayout &Layout,
   // FIXME-PERF: If it matters, we could let the target do this. It can
   // probably do so more efficiently in many cases.
   SmallVector<MCFixup, 4> Fixups;
-  SmallString<256> Code;
-  raw_svector_ostream VecOS(Code);
+  raw_inline_ostream VecOS;
   getEmitter().encodeInstruction(Relaxed, VecOS, Fixups, F.getSubtargetInfo(), KsError);
+  StringRef Code = VecOS.str();
 
   // Update the fragment.
   F.setInst(Relaxed);
-  F.getContents() = Code;
+  F.getContents().clear();
+  F.getContents().append(Code.begin(), Code.end());
   F.getFixups() = Fixups;
 
   return true;
@@ -864,6 +875,55 @@ bool MCAssembler::relaxLEB(MCAsmLayout &Layout, MCLEBFragment &LF) {
   return OldSize != LF.getContents().size();
 }
 
+/// Check if a branch of \p Size bytes at \p StartAddr crosses or ends at a
+/// \p BoundaryAlignment boundary.
+static bool needPadding(uint64_t StartAddr, uint64_t Size,
+                        unsigned BoundaryAlignment) {
+  uint64_t EndAddr = StartAddr + Size;
+  return StartAddr / BoundaryAlignment != (EndAddr - 1) / BoundaryAlignment ||
+         EndAddr % BoundaryAlignment == 0;
+}
+
+bool MCAssembler::relaxBoundaryAlign(MCAsmLayout &Layout,
+                                     MCBoundaryAlignFragment &BF) {
+  // A fragment that only marks the end of a branch never pads.
+  if (!BF.canEmitNops())
+    return false;
+
+  // The branch follows this fragment: in one fragment when it is on its own,
+  // in at most two when it is fused. Another boundary-align fragment always
+  // ends it.
+  uint64_t AlignedSize = 0;
+  const MCFragment *F = BF.getNextNode();
+  for (unsigned i = 0, e = BF.isFused() ? 2 : 1;
+       i != e && F && !isa<MCBoundaryAlignFragment>(F);
+       ++i, F = F->getNextNode()) {
+    bool valid = true;
+    AlignedSize += computeFragmentSize(Layout, *F, valid);
+    if (!valid)
+      return false;
+  }
+  if (AlignedSize == 0)
+    return false;
+
+  bool valid = true;
+  uint64_t AlignedOffset = Layout.getFragmentOffset(&BF, valid);
+  if (!valid)
+    return false;
+
+  uint64_t OldSize = BF.getSize();
+  unsigned Boundary = BF.getAlignment();
+  uint64_t NewSize = needPadding(AlignedOffset, AlignedSize, Boundary)
+                         ? OffsetToAlignment(AlignedOffset, Boundary)
+                         : 0;
+  if (NewSize == OldSize)
+    return false;
+
+  BF.setSize(NewSize);
+  Layout.invalidateFragmentsFrom(&BF);
+  return true;
+}
+
 bool MCAssembler::relaxDwarfLineAddr(MCAsmLayout &Layout,
                                      MCDwarfLineAddrFragment &DF) {
   return false;
@@ -906,6 +966,10 @@ bool MCAssembler::layoutSectionOnce(MCAsmLayout &Layout, MCSection &Sec)
     case MCFragment::FT_LEB:
       RelaxedFrag = relaxLEB(Layout, *cast<MCLEBFragment>(I));
       break;
+    case MCFragment::FT_BoundaryAlign:
+      RelaxedFrag =
+          relaxBoundaryAlign(Layout, *cast<MCBoundaryAlignFragment>(I));
+      break;
     }
     if (RelaxedFrag && !FirstRelaxedFragment)
       FirstRelaxedFragment = &*I;
@@ -481,11 +481,11 @@ void MCELFStreamer::EmitInstToData(MCInst &Inst,
 {
   MCAssembler &Assembler = getAssembler();
   SmallVector<MCFixup, 4> Fixups;
-  SmallString<256> Code;
-  raw_svector_ostream VecOS(Code);
+  raw_inline_ostream VecOS;
   Assembler.getEmitter().encodeInstruction(Inst, VecOS, Fixups, STI, KsError);
   if (KsError)
       return;
+  StringRef Code = VecOS.str();
 
   for (unsigned i = 0, e = Fixups.size(); i != e; ++i)
     fixSymbolsInTLSFixups(Fixups[i].getValue());
@@ -318,6 +318,9 @@ void MCFragment::destroy() {
     case FT_SafeSEH:
       delete cast<MCSafeSEHFragment>(this);
       return;
+    case FT_BoundaryAlign:
+      delete cast<MCBoundaryAlignFragment>(this);
+      return;
     case FT_Dummy:
       delete cast<MCDummyFragment>(this);
       return;
@@ -356,6 +359,7 @@ LLVM_DUMP_METHOD void MCFragment::dump() {
   case MCFragment::FT_DwarfFrame: OS << "MCDwarfCallFrameFragment"; break;
   case MCFragment::FT_LEB:   OS << "MCLEBFragment"; break;
   case MCFragment::FT_SafeSEH:    OS << "MCSafeSEHFragment"; break;
+  case MCFragment::FT_BoundaryAlign: OS << "MCBoundaryAlignFragment"; break;
   case MCFragment::FT_Dummy:
     OS << "MCDummyFragment";
     break;
@@ -455,6 +459,16 @@ LLVM_DUMP_METHOD void MCFragment::dump() {
     OS << " Sym:" << F->getSymbol();
     break;
   }
+  case MCFragment::FT_BoundaryAlign: {
+    const MCBoundaryAlignFragment *BF = cast<MCBoundaryAlignFragment>(this);
+    if (BF->canEmitNops())
+      OS << " (can emit nops)";
+    if (BF->isFused())
+      OS << " (fused)";
+    OS << "\n       ";
+    OS << " BoundarySize:" << BF->getAlignment() << " Size:" << BF->getSize();
+    break;
+  }
   case MCFragment::FT_Dummy:
     break;
   }
@@ -245,6 +245,32 @@ bool MCObjectStreamer::mayHaveInstructions(MCSection &Sec) const {
 void MCObjectStreamer::EmitInstruction(MCInst &Inst,
                                        const MCSubtargetInfo &STI,
                                        unsigned int &KsError)
+{
+  MCAsmBackend &Backend = getAssembler().getBackend();
+  Backend.alignBranchesBegin(*this, Inst);
+  EmitInstructionImpl(Inst, STI, KsError);
+  Backend.alignBranchesEnd(*this, Inst);
+}
+
+bool MCObjectStreamer::EmitEncodedInstruction(StringRef Code)
+{
+  MCAssembler &Assembler = getAssembler();
+  if (hasInstRecorder() || Assembler.isBundlingEnabled() ||
+      Assembler.getBackend().isAligningBranches())
+    return false;
+
+  getCurrentSectionOnly()->setHasInstructions(true);
+
+  MCDataFragment *DF = getOrCreateDataFragment();
+  flushPendingLabels(DF, DF->getContents().size());
+  DF->setHasInstructions(true);
+  DF->getContents().append(Code.begin(), Code.end());
+  return true;
+}
+
+void MCObjectStreamer::EmitInstructionImpl(MCInst &Inst,
+                                           const MCSubtargetInfo &STI,
+                                           unsigned int &KsError)
 {
   MCStreamer::EmitInstruction(Inst, STI, KsError);
 
@@ -293,11 +319,11 @@ void MCObjectStreamer::EmitInstToFragment(MCInst &Inst,
   MCRelaxableFragment *IF = new MCRelaxableFragment(Inst, STI);
   insert(IF);
 
-  SmallString<128> Code;
-  raw_svector_ostream VecOS(Code);
+  raw_inline_ostream VecOS;
   unsigned int KsError;
   getAssembler().getEmitter().encodeInstruction(Inst, VecOS, IF->getFixups(),
                                                 STI, KsError);
+  StringRef Code = VecOS.str();
   IF->getContents().append(Code.begin(), Code.end());
 }
 
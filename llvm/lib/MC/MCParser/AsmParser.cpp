@@ -727,6 +727,10 @@ size_t AsmParser::Run(bool NoInitialTextSection, uint64_t Address, bool NoFinali
     //eatToEndOfStatement();
   }
 
+  // Emit whatever the target is still holding back.
+  if (!KsError && getTargetParser().flushPendingInstructions(Out, KsError))
+    return 0;
+
   if (TheCondState.TheCond != StartingCondState.TheCond ||
       TheCondState.Ignore != StartingCondState.Ignore) {
     //return TokError("unmatched .ifs or .elses");
@@ -1642,6 +1646,10 @@ bool AsmParser::parseStatement(ParseStatementInfo &Info,
       return true;
     }
 
+    // Instructions held back by the target belong before the label.
+    if (getTargetParser().flushPendingInstructions(Out, Info.KsError))
+      return true;
+
     // Emit the label.
     if (!ParsingInlineAsm)
       Out.EmitLabel(Sym);
@@ -1683,6 +1691,10 @@ bool AsmParser::parseStatement(ParseStatementInfo &Info,
 
   // Otherwise, we have a normal instruction or directive.
   if (isDirective(IDVal)) {
+    // Directives may emit data, so flush held back instructions first.
+    if (getTargetParser().flushPendingInstructions(Out, Info.KsError))
+      return true;
+
     // There are several entities interested in parsing directives:
     //
     // 1. The target-specific assembly parser. Some directives are target
@@ -1951,6 +1963,9 @@ bool AsmParser::parseStatement(ParseStatementInfo &Info,
 
   // Canonicalize the opcode to lower case.
   std::string OpcodeStr = IDVal.lower();
+  if (!ParsingInlineAsm && getTargetParser().tryFastEncode(OpcodeStr, Out, Address))
+    return false;
+
   ParseInstructionInfo IInfo(Info.AsmRewrites);
   //printf(">> Going to ParseInstruction()\n");
   bool HadError = getTargetParser().ParseInstruction(IInfo, OpcodeStr, ID,
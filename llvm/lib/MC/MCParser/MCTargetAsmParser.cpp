@@ -9,6 +9,9 @@
 
 #include "llvm/MC/MCParser/MCTargetAsmParser.h"
 #include "llvm/MC/MCContext.h"
+
+#include "../../../../include/keystone/keystone.h"
+
 using namespace llvm_ks;
 
 MCTargetAsmParser::MCTargetAsmParser(MCTargetOptions const &MCOptions,
@@ -30,3 +33,11 @@ MCSubtargetInfo &MCTargetAsmParser::copySTI() {
 const MCSubtargetInfo &MCTargetAsmParser::getSTI() const {
   return *STI;
 }
+
+bool MCTargetAsmParser::createStructuredOperands(StringRef Mnemonic,
+                                                 ArrayRef<ks_operand> Ops,
+                                                 OperandVector &Operands,
+                                                 unsigned int &ErrorCode) {
+  ErrorCode = KS_ERR_ARCH;
+  return true;
+}
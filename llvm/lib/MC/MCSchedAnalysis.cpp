@@ -0,0 +1,100 @@
+//===- MCSchedAnalysis.cpp - Static block timing --------------------------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/MC/MCSchedAnalysis.h"
+#include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCRegisterInfo.h"
+#include "llvm/MC/MCSchedule.h"
+#include "llvm/MC/MCSubtargetInfo.h"
+#include <algorithm>
+
+using namespace llvm_ks;
+
+bool llvm_ks::analyzeSchedule(ArrayRef<MCInst> Insts,
+                              const MCSubtargetInfo &STI,
+                              const MCInstrInfo &MCII,
+                              const MCRegisterInfo &MRI,
+                              MCSchedAnalysis &Result) {
+  const MCSchedModel &SM = STI.getSchedModel();
+  if (!SM.hasInstrSchedModel())
+    return false;
+
+  unsigned NumResources = SM.getNumProcResourceKinds();
+  Result = MCSchedAnalysis();
+  Result.Pressure.assign(NumResources, 0);
+
+  // Cycle at which each register unit gets its last written value.
+  std::vector<unsigned> UnitReady(MRI.getNumRegUnits(), 0);
+
+  for (const MCInst &Inst : Insts) {
+    const MCInstrDesc &Desc = MCII.get(Inst.getOpcode());
+    const MCSchedClassDesc *SC = SM.getSchedClassDesc(Desc.getSchedClass());
+
+    MCSchedAnalysis::InstTiming T;
+    T.Pressure.assign(NumResources, 0);
+    if (SC->isValid() && !SC->isVariant()) {
+      T.NumMicroOps = SC->NumMicroOps;
+      for (const MCWriteProcResEntry *WPR = STI.getWriteProcResBegin(SC),
+                                     *E = STI.getWriteProcResEnd(SC);
+           WPR != E; ++WPR) {
+        unsigned Units = SM.getProcResource(WPR->ProcResourceIdx)->NumUnits;
+        T.Pressure[WPR->ProcResourceIdx] += double(WPR->Cycles) / Units;
+      }
+      for (unsigned i = 0; i < SC->NumWriteLatencyEntries; ++i) {
+        int Cycles = STI.getWriteLatencyEntry(SC, i)->Cycles;
+        T.Latency = std::max(T.Latency, (unsigned)std::max(Cycles, 0));
+      }
+    } else {
+      // no model for this instruction: assume a simple one
+      T.NumMicroOps = 1;
+      T.Latency = 1;
+    }
+
+    // wait for every register read, explicit or implicit
+    auto readReg = [&](unsigned Reg) {
+      for (MCRegUnitIterator Unit(Reg, &MRI); Unit.isValid(); ++Unit)
+        T.Ready = std::max(T.Ready, UnitReady[*Unit]);
+    };
+    for (unsigned i = Desc.getNumDefs(), e = Inst.getNumOperands(); i < e; ++i)
+      if (Inst.getOperand(i).isReg() && Inst.getOperand(i).getReg())
+        readReg(Inst.getOperand(i).getReg());
+    for (unsigned i = 0, e = Desc.getNumImplicitUses(); i < e; ++i)
+      readReg(Desc.getImplicitUses()[i]);
+
+    // then publish the results, the i-th def with the i-th write latency
+    auto writeReg = [&](unsigned Reg, unsigned Latency) {
+      for (MCRegUnitIterator Unit(Reg, &MRI); Unit.isValid(); ++Unit)
+        UnitReady[*Unit] = T.Ready + Latency;
+    };
+    for (unsigned i = 0, e = std::min(Desc.getNumDefs(), Inst.getNumOperands());
+         i < e; ++i) {
+      if (!Inst.getOperand(i).isReg() || !Inst.getOperand(i).getReg())
+        continue;
+      unsigned Latency = T.Latency;
+      if (SC->isValid() && !SC->isVariant() && i < SC->NumWriteLatencyEntries)
+        Latency = std::max(STI.getWriteLatencyEntry(SC, i)->Cycles, 0);
+      writeReg(Inst.getOperand(i).getReg(), Latency);
+    }
+    for (unsigned i = 0, e = Desc.getNumImplicitDefs(); i < e; ++i)
+      writeReg(Desc.getImplicitDefs()[i], T.Latency);
+
+    Result.Latency = std::max(Result.Latency, T.Ready + T.Latency);
+    Result.NumMicroOps += T.NumMicroOps;
+    for (unsigned i = 0; i < NumResources; ++i)
+      Result.Pressure[i] += T.Pressure[i];
+    Result.Insts.push_back(std::move(T));
+  }
+
+  Result.Throughput = double(Result.NumMicroOps) / SM.IssueWidth;
+  for (double P : Result.Pressure)
+    Result.Throughput = std::max(Result.Throughput, P);
+
+  return true;
+}
@@ -43,7 +43,7 @@ void MCTargetStreamer::finish() {}
 void MCTargetStreamer::emitAssignment(MCSymbol *Symbol, const MCExpr *Value) {}
 
 MCStreamer::MCStreamer(MCContext &Ctx)
-    : Context(Ctx), CurrentWinFrameInfo(nullptr) {
+    : KsInstRecorder(nullptr), Context(Ctx), CurrentWinFrameInfo(nullptr) {
   SectionStack.push_back(std::pair<MCSectionSubPair, MCSectionSubPair>());
 }
 
@@ -679,6 +679,9 @@ void MCStreamer::visitUsedExpr(const MCExpr &Expr) {
 void MCStreamer::EmitInstruction(MCInst &Inst,
                                  const MCSubtargetInfo &STI,
                                  unsigned int &KsError) {
+  if (KsInstRecorder)
+    KsInstRecorder->push_back(Inst);
+
   // Scan for values.
   for (unsigned i = Inst.getNumOperands(); i--;)
     if (Inst.getOperand(i).isExpr())
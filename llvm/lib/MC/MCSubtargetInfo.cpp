@@ -87,6 +87,19 @@ bool MCSubtargetInfo::checkFeatures(StringRef FS) const {
   return (FeatureBits & All) == Set;
 }
 
+bool MCSubtargetInfo::isFeatureStringValid(StringRef FS) const {
+  SubtargetFeatures T(FS);
+  for (StringRef F : T.getFeatures()) {
+    if (F.size() < 2 || (F[0] != '+' && F[0] != '-'))
+      return false;
+    F = F.substr(1);
+    auto Found = std::lower_bound(ProcFeatures.begin(), ProcFeatures.end(), F);
+    if (Found == ProcFeatures.end() || StringRef(Found->Key) != F)
+      return false;
+  }
+  return true;
+}
+
 const MCSchedModel &MCSubtargetInfo::getSchedModelForCPU(StringRef CPU) const {
   if (!ProcSchedModels) {
     return MCSchedModel::GetDefaultSchedModel();
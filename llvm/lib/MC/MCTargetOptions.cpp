@@ -14,7 +14,9 @@ namespace llvm_ks {
 
 MCTargetOptions::MCTargetOptions()
     : MCRelaxAll(false),
-      MCFatalWarnings(false), MCNoWarn(false),
+      MCFatalWarnings(false), MCNoWarn(false), MCAutoPacketize(false),
+      MCOptimizeSize(false), MCFixedWidth(false),
+      MCRIPRelative(false), MCFillDelaySlots(false), MCBlockCounters(0),
       DwarfVersion(0), ABIName() {}
 
 StringRef MCTargetOptions::getABIName() const {
@@ -730,6 +730,28 @@ void raw_svector_ostream::pwrite_impl(const char *Ptr, size_t Size,
   memcpy(OS.data() + Offset, Ptr, Size);
 }
 
+//===----------------------------------------------------------------------===//
+//  raw_inline_ostream
+//===----------------------------------------------------------------------===//
+
+raw_inline_ostream::~raw_inline_ostream() {
+  // ~raw_ostream asserts that the buffer is empty.
+  flush();
+}
+
+uint64_t raw_inline_ostream::current_pos() const { return Spill.size(); }
+
+void raw_inline_ostream::write_impl(const char *Ptr, size_t Size) {
+  Spill.append(Ptr, Ptr + Size);
+}
+
+StringRef raw_inline_ostream::str() {
+  if (Spill.empty())
+    return StringRef(Inline, GetNumBytesInBuffer());
+  flush();
+  return StringRef(Spill.data(), Spill.size());
+}
+
 //===----------------------------------------------------------------------===//
 //  raw_null_ostream
 //===----------------------------------------------------------------------===//
@@ -86,6 +86,8 @@ private:
   bool parseDirectiveUnreq(SMLoc L);
 
   bool validateInstruction(MCInst &Inst, SmallVectorImpl<SMLoc> &Loc);
+  bool emitMOVImm(SMLoc IDLoc, OperandVector &Operands, MCStreamer &Out,
+                  unsigned int &ErrorCode, uint64_t &Address);
   bool MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
                                OperandVector &Operands, MCStreamer &Out,
                                uint64_t &ErrorInfo,
@@ -3893,6 +3895,367 @@ bool AArch64AsmParser::showMatchError(SMLoc Loc, unsigned ErrCode)
   }
 }
 
+namespace {
+/// One instruction of a "mov Rd, #imm" expansion. For MOVZ/MOVN/MOVK, Op1 is
+/// the 16-bit chunk and Op2 the shift amount; for ORR, Op2 is the encoded
+/// logical immediate.
+struct ImmInsnModel {
+  unsigned Opcode;
+  uint64_t Op1;
+  uint64_t Op2;
+};
+} // end anonymous namespace
+
+static uint64_t getChunk(uint64_t Imm, unsigned ChunkIdx) {
+  assert(ChunkIdx < 4 && "Out of range chunk index specified!");
+  return (Imm >> (ChunkIdx * 16)) & 0xFFFF;
+}
+
+/// Check whether the given 16-bit chunk replicated to full 64-bit width
+/// can be materialized with an ORR instruction.
+static bool canUseOrr(uint64_t Chunk, uint64_t &Encoding) {
+  Chunk = (Chunk << 48) | (Chunk << 32) | (Chunk << 16) | Chunk;
+  return AArch64_AM::processLogicalImmediate(Chunk, 64, Encoding);
+}
+
+/// Check for identical 16-bit chunks within the constant and if so
+/// materialize them with a single ORR instruction. The remaining one or two
+/// 16-bit chunks will be materialized with MOVK instructions.
+static bool tryToReplicateChunks(uint64_t UImm,
+                                 SmallVectorImpl<ImmInsnModel> &Insn) {
+  for (unsigned Idx = 0; Idx < 4; ++Idx) {
+    const uint64_t ChunkVal = getChunk(UImm, Idx);
+    unsigned Count = 0;
+    for (unsigned I = 0; I < 4; ++I)
+      if (getChunk(UImm, I) == ChunkVal)
+        ++Count;
+
+    // We are looking for chunks which have two or three instances and can be
+    // materialized with an ORR instruction.
+    uint64_t Encoding = 0;
+    if ((Count != 2 && Count != 3) || !canUseOrr(ChunkVal, Encoding))
+      continue;
+
+    Insn.push_back({ AArch64::ORRXri, 0, Encoding });
+
+    // Patch up every chunk not materialized by the ORR instruction.
+    for (unsigned Shift = 0; Shift < 64; Shift += 16) {
+      uint64_t Imm16 = (UImm >> Shift) & 0xFFFF;
+      if (Imm16 != ChunkVal)
+        Insn.push_back({ AArch64::MOVKXi, Imm16, Shift });
+    }
+    return true;
+  }
+
+  return false;
+}
+
+/// Check whether this chunk matches the pattern '1...0...'. This pattern
+/// starts a contiguous sequence of ones if we look at the bits from the LSB
+/// towards the MSB.
+static bool isStartChunk(uint64_t Chunk) {
+  if (Chunk == 0 || Chunk == UINT64_MAX)
+    return false;
+
+  return isMask_64(~Chunk);
+}
+
+/// Check whether this chunk matches the pattern '0...1...' This pattern
+/// ends a contiguous sequence of ones if we look at the bits from the LSB
+/// towards the MSB.
+static bool isEndChunk(uint64_t Chunk) {
+  if (Chunk == 0 || Chunk == UINT64_MAX)
+    return false;
+
+  return isMask_64(Chunk);
+}
+
+/// Clear or set all bits in the chunk at the given index.
+static uint64_t updateImm(uint64_t Imm, unsigned Idx, bool Clear) {
+  const uint64_t Mask = 0xFFFF;
+
+  if (Clear)
+    // Clear chunk in the immediate.
+    Imm &= ~(Mask << (Idx * 16));
+  else
+    // Set all bits in the immediate for the particular chunk.
+    Imm |= Mask << (Idx * 16);
+
+  return Imm;
+}
+
+/// Check whether the constant contains a sequence of contiguous ones,
+/// which might be interrupted by one or two chunks. If so, materialize the
+/// sequence of contiguous ones with an ORR instruction. Materialize the
+/// chunks which are either interrupting the sequence or outside of the
+/// sequence with a MOVK instruction.
+static bool trySequenceOfOnes(uint64_t UImm,
+                              SmallVectorImpl<ImmInsnModel> &Insn) {
+  const int NotSet = -1;
+  const uint64_t Mask = 0xFFFF;
+
+  int StartIdx = NotSet;
+  int EndIdx = NotSet;
+  // Try to find the chunks which start/end a contiguous sequence of ones.
+  for (int Idx = 0; Idx < 4; ++Idx) {
+    // Sign extend the 16-bit chunk to 64-bit.
+    uint64_t Chunk = (uint64_t)((int64_t)(getChunk(UImm, Idx) << 48) >> 48);
+
+    if (isStartChunk(Chunk))
+      StartIdx = Idx;
+    else if (isEndChunk(Chunk))
+      EndIdx = Idx;
+  }
+
+  // Early exit in case we can't find a start/end chunk.
+  if (StartIdx == NotSet || EndIdx == NotSet)
+    return false;
+
+  // Outside of the contiguous sequence of ones everything needs to be zero.
+  uint64_t Outside = 0;
+  // Chunks between the start and end chunk need to have all their bits set.
+  uint64_t Inside = Mask;
+
+  // If our contiguous sequence of ones wraps around from the MSB into the LSB,
+  // just swap indices and pretend we are materializing a contiguous sequence
+  // of zeros surrounded by a contiguous sequence of ones.
+  if (StartIdx > EndIdx) {
+    std::swap(StartIdx, EndIdx);
+    std::swap(Outside, Inside);
+  }
+
+  uint64_t OrrImm = UImm;
+  SmallVector<int, 2> MovkIdx;
+
+  // Find out which chunks we need to patch up to obtain a contiguous sequence
+  // of ones.
+  for (int Idx = 0; Idx < 4; ++Idx) {
+    const uint64_t Chunk = getChunk(UImm, Idx);
+
+    if ((Idx < StartIdx || EndIdx < Idx) && Chunk != Outside) {
+      // A chunk which is not part of the contiguous sequence of ones.
+      OrrImm = updateImm(OrrImm, Idx, Outside == 0);
+      MovkIdx.push_back(Idx);
+    } else if (Idx > StartIdx && Idx < EndIdx && Chunk != Inside) {
+      // A chunk which is part of the contiguous sequence of ones.
+      OrrImm = updateImm(OrrImm, Idx, Inside != Mask);
+      MovkIdx.push_back(Idx);
+    }
+  }
+
+  uint64_t Encoding = 0;
+  if (MovkIdx.empty() || MovkIdx.size() > 2 ||
+      !AArch64_AM::processLogicalImmediate(OrrImm, 64, Encoding))
+    return false;
+
+  Insn.push_back({ AArch64::ORRXri, 0, Encoding });
+  for (int Idx : MovkIdx)
+    Insn.push_back({ AArch64::MOVKXi, getChunk(UImm, Idx), Idx * 16u });
+  return true;
+}
+
+/// Materialize the constant with a MOVZ or MOVN for the lowest interesting
+/// chunk, followed by a MOVK for every other chunk that is not already right.
+static void expandMOVImmSimple(uint64_t Imm, unsigned BitSize,
+                               unsigned OneChunks, unsigned ZeroChunks,
+                               SmallVectorImpl<ImmInsnModel> &Insn) {
+  const unsigned Mask = 0xFFFF;
+
+  // Use MOVN to materialize the high bits if we have more all one chunks
+  // than all zero chunks.
+  bool IsNeg = false;
+  if (OneChunks > ZeroChunks) {
+    IsNeg = true;
+    Imm = ~Imm;
+  }
+
+  unsigned FirstOpc;
+  if (BitSize == 32) {
+    Imm &= 0xFFFFFFFFULL;
+    FirstOpc = (IsNeg ? AArch64::MOVNWi : AArch64::MOVZWi);
+  } else {
+    FirstOpc = (IsNeg ? AArch64::MOVNXi : AArch64::MOVZXi);
+  }
+
+  unsigned Shift = 0;     // LSL amount for high bits with MOVZ/MOVN
+  unsigned LastShift = 0; // LSL amount for last MOVK
+  if (Imm != 0) {
+    unsigned LZ = countLeadingZeros(Imm);
+    unsigned TZ = countTrailingZeros(Imm);
+    Shift = (TZ / 16) * 16;
+    LastShift = ((63 - LZ) / 16) * 16;
+  }
+  Insn.push_back({ FirstOpc, (Imm >> Shift) & Mask, Shift });
+
+  if (Shift == LastShift)
+    return;
+
+  // If a MOVN was used for the high bits of a negative value, flip the rest
+  // of the bits back for use with MOVK.
+  if (IsNeg)
+    Imm = ~Imm;
+
+  unsigned Opc = (BitSize == 32 ? AArch64::MOVKWi : AArch64::MOVKXi);
+  while (Shift < LastShift) {
+    Shift += 16;
+    uint64_t Imm16 = (Imm >> Shift) & Mask;
+    if (Imm16 == (IsNeg ? Mask : 0))
+      continue; // This 16-bit portion is already set correctly.
+
+    Insn.push_back({ Opc, Imm16, Shift });
+  }
+}
+
+/// Compute the shortest MOVZ/MOVN/ORR + MOVK sequence that materializes
+/// \p Imm in a register of \p BitSize bits, mirroring the constant
+/// materialization done by the code generator.
+static void expandMOVImm(uint64_t Imm, unsigned BitSize,
+                         SmallVectorImpl<ImmInsnModel> &Insn) {
+  const unsigned Mask = 0xFFFF;
+  const unsigned NumChunks = BitSize / 16;
+
+  if (BitSize == 32)
+    Imm &= 0xFFFFFFFFULL;
+
+  // Scan the immediate and count the number of 16-bit chunks which are either
+  // all ones or all zeros.
+  unsigned OneChunks = 0;
+  unsigned ZeroChunks = 0;
+  for (unsigned Shift = 0; Shift < BitSize; Shift += 16) {
+    const unsigned Chunk = (Imm >> Shift) & Mask;
+    if (Chunk == Mask)
+      OneChunks++;
+    else if (Chunk == 0)
+      ZeroChunks++;
+  }
+
+  // Prefer MOVZ/MOVN over ORR because of the rules for the "mov" alias.
+  if (NumChunks - OneChunks <= 1 || NumChunks - ZeroChunks <= 1) {
+    expandMOVImmSimple(Imm, BitSize, OneChunks, ZeroChunks, Insn);
+    return;
+  }
+
+  // Try a single ORR.
+  uint64_t Encoding;
+  if (AArch64_AM::processLogicalImmediate(Imm, BitSize, Encoding)) {
+    unsigned Opc = (BitSize == 32 ? AArch64::ORRWri : AArch64::ORRXri);
+    Insn.push_back({ Opc, 0, Encoding });
+    return;
+  }
+
+  // Two instruction sequences: prefer MOVZ/MOVN followed by MOVK, it's more
+  // readable and possibly the fastest sequence.
+  if (NumChunks - OneChunks <= 2 || NumChunks - ZeroChunks <= 2) {
+    expandMOVImmSimple(Imm, BitSize, OneChunks, ZeroChunks, Insn);
+    return;
+  }
+
+  assert(BitSize == 64 && "All 32-bit immediates fit a MOVZ/MOVK pair");
+
+  // 64-bit ORR followed by MOVK. We try to construct the ORR immediate in
+  // three different ways: either we zero out the chunk which will be
+  // replaced, we fill the chunk which will be replaced with ones, or we take
+  // the bit pattern from the other half of the 64-bit immediate. This is
+  // comprehensive because of the way ORR immediates are constructed.
+  for (unsigned Shift = 0; Shift < BitSize; Shift += 16) {
+    uint64_t ShiftedMask = (0xFFFFULL << Shift);
+    uint64_t ZeroChunk = Imm & ~ShiftedMask;
+    uint64_t OneChunk = Imm | ShiftedMask;
+    uint64_t RotatedImm = (Imm << 32) | (Imm >> 32);
+    uint64_t ReplicateChunk = ZeroChunk | (RotatedImm & ShiftedMask);
+    if (AArch64_AM::processLogicalImmediate(ZeroChunk, BitSize, Encoding) ||
+        AArch64_AM::processLogicalImmediate(OneChunk, BitSize, Encoding) ||
+        AArch64_AM::processLogicalImmediate(ReplicateChunk, BitSize,
+                                            Encoding)) {
+      Insn.push_back({ AArch64::ORRXri, 0, Encoding });
+      Insn.push_back({ AArch64::MOVKXi, getChunk(Imm, Shift / 16), Shift });
+      return;
+    }
+  }
+
+  // Three instruction sequences: prefer MOVZ/MOVN followed by two MOVK.
+  if (OneChunks || ZeroChunks) {
+    expandMOVImmSimple(Imm, BitSize, OneChunks, ZeroChunks, Insn);
+    return;
+  }
+
+  if (tryToReplicateChunks(Imm, Insn))
+    return;
+
+  if (trySequenceOfOnes(Imm, Insn))
+    return;
+
+  // We found no possible two or three instruction sequence; use the general
+  // four-instruction sequence.
+  expandMOVImmSimple(Imm, BitSize, OneChunks, ZeroChunks, Insn);
+}
+
+/// Expand "mov Rd, #imm" for a constant no single MOVZ/MOVN/ORR can produce
+/// into the shortest MOVZ/MOVN/ORR + MOVK sequence and emit it.
+/// Returns false (and leaves Operands alone) if this is not such a "mov".
+bool AArch64AsmParser::emitMOVImm(SMLoc IDLoc, OperandVector &Operands,
+                                  MCStreamer &Out, unsigned int &ErrorCode,
+                                  uint64_t &Address) {
+  AArch64Operand &RegOp = static_cast<AArch64Operand &>(*Operands[1]);
+  AArch64Operand &ImmOp = static_cast<AArch64Operand &>(*Operands[2]);
+  if (!RegOp.isReg() || !ImmOp.isImm())
+    return false;
+
+  const MCConstantExpr *CE = dyn_cast<MCConstantExpr>(ImmOp.getImm());
+  if (!CE)
+    return false;
+
+  unsigned Reg = RegOp.getReg();
+  unsigned BitSize;
+  if (AArch64MCRegisterClasses[AArch64::GPR64RegClassID].contains(Reg))
+    BitSize = 64;
+  else if (AArch64MCRegisterClasses[AArch64::GPR32RegClassID].contains(Reg))
+    BitSize = 32;
+  else
+    return false;
+
+  int64_t Value = CE->getValue();
+  if (BitSize == 32 && !isInt<32>(Value) && !isUInt<32>(Value))
+    return false;
+
+  SmallVector<ImmInsnModel, 4> Insn;
+  expandMOVImm(Value, BitSize, Insn);
+  // A single instruction is left to the matcher, which already knows how to
+  // pick between the movz/movn/orr forms of the alias.
+  if (Insn.size() < 2)
+    return false;
+
+  unsigned ZeroReg = BitSize == 64 ? AArch64::XZR : AArch64::WZR;
+  for (const ImmInsnModel &I : Insn) {
+    MCInst Inst(Address);
+    Inst.setOpcode(I.Opcode);
+    Inst.addOperand(MCOperand::createReg(Reg));
+    switch (I.Opcode) {
+    case AArch64::ORRWri:
+    case AArch64::ORRXri:
+      Inst.addOperand(MCOperand::createReg(ZeroReg));
+      Inst.addOperand(MCOperand::createImm(I.Op2));
+      break;
+    case AArch64::MOVKWi:
+    case AArch64::MOVKXi:
+      Inst.addOperand(MCOperand::createReg(Reg));
+      // FALLTHROUGH
+    default:
+      Inst.addOperand(MCOperand::createImm(I.Op1));
+      Inst.addOperand(MCOperand::createImm(I.Op2));
+      break;
+    }
+
+    Inst.setLoc(IDLoc);
+    Out.EmitInstruction(Inst, getSTI(), ErrorCode);
+    if (ErrorCode != 0)
+      return true;
+    Address = Inst.getAddress();
+  }
+
+  return true;
+}
+
 static const char *getSubtargetFeatureName(uint64_t Val);
 
 // return True on error
@@ -4202,6 +4565,14 @@ bool AArch64AsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
     }
   }
 
+  // "mov Rd, #imm" accepts any constant that fits the register, expanding to
+  // a movz/movn/orr + movk sequence when a single instruction won't do.
+  if (NumOperands == 3 && Tok == "mov") {
+    ErrorCode = 0;
+    if (emitMOVImm(IDLoc, Operands, Out, ErrorCode, Address))
+      return ErrorCode != 0;
+  }
+
   MCInst Inst(Address);
   // First try to match against the secondary set of tables containing the
   // short-form NEON instructions (e.g. "fadd.2s v0, v1, v2").
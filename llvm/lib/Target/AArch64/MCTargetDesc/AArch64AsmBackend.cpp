@@ -11,8 +11,11 @@
 #include "Utils/AArch64BaseInfo.h"
 #include "MCTargetDesc/AArch64MCTargetDesc.h"
 #include "MCTargetDesc/AArch64FixupKinds.h"
+#include "MCTargetDesc/AArch64MCExpr.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/MC/MCAsmBackend.h"
+#include "llvm/MC/MCAsmLayout.h"
+#include "llvm/MC/MCAssembler.h"
 #include "llvm/MC/MCDirectives.h"
 #include "llvm/MC/MCELFObjectWriter.h"
 #include "llvm/MC/MCFixupKindInfo.h"
@@ -20,6 +23,7 @@
 #include "llvm/MC/MCSectionELF.h"
 #include "llvm/MC/MCSectionMachO.h"
 #include "llvm/MC/MCValue.h"
+#include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/MachO.h"
 
@@ -77,6 +81,9 @@ public:
   void applyFixup(const MCAssembler &Asm, const MCFixup &Fixup,
                   const MCValue &Target, MutableArrayRef<char> Data,
                   uint64_t Value, bool IsPCRel, unsigned int &KsError) const override;
+  void relaxFixedUpFragment(const MCAssembler &Asm, const MCAsmLayout &Layout,
+                            const MCFragment &F, ArrayRef<MCFixup> Fixups,
+                            MutableArrayRef<char> Data) const override;
 
   bool mayNeedRelaxation(const MCInst &Inst) const override;
   bool fixupNeedsRelaxation(const MCFixup &Fixup, uint64_t Value,
@@ -297,6 +304,130 @@ void AArch64AsmBackend::applyFixup(const MCAssembler &Asm, const MCFixup &Fixup,
   }
 }
 
+/// Compute the address \p Target refers to, if it is a plain symbol (+
+/// constant) known to this assembly or to the symbol resolver.
+static bool getSymbolAddress(const MCAssembler &Asm, const MCAsmLayout &Layout,
+                             const MCValue &Target, uint64_t &Address) {
+  const MCSymbolRefExpr *A = Target.getSymA();
+  if (!A || Target.getSymB())
+    return false;
+
+  const MCSymbol &Sym = A->getSymbol();
+  if (Sym.isDefined()) {
+    bool valid;
+    Address = Layout.getSymbolOffset(Sym, valid) + Target.getConstant();
+    return valid;
+  }
+
+  ks_sym_resolver resolver = (ks_sym_resolver)Asm.getSymResolver();
+  uint64_t Imm;
+  if (!resolver || !resolver(Sym.getName().str().c_str(), &Imm))
+    return false;
+  Address = Imm + Target.getConstant();
+  return true;
+}
+
+// Linker-style relaxation of address materialization. Once the layout is
+// final, a page-relative pair whose target is within +/-1MB of the ADRP
+//
+//   adrp xN, sym                      adr  xN, sym
+//   add  xN, xN, :lo12:sym     ==>    nop
+//
+//   adrp xN, sym                      ldr  xN, sym
+//   ldr  xN, [xN, :lo12:sym]   ==>    nop
+//
+// is rewritten in place, saving the dependent instruction. Only pairs whose
+// second instruction overwrites the ADRP register are touched, as otherwise
+// the page address would still be live.
+void AArch64AsmBackend::relaxFixedUpFragment(const MCAssembler &Asm,
+                                             const MCAsmLayout &Layout,
+                                             const MCFragment &F,
+                                             ArrayRef<MCFixup> Fixups,
+                                             MutableArrayRef<char> Data) const {
+  // RelaxAll (also used for KS_OPT_FIXED_WIDTH) keeps every sequence as
+  // written.
+  if (Asm.getRelaxAll())
+    return;
+
+  for (unsigned i = 0, e = Fixups.size(); i + 1 < e; ++i) {
+    const MCFixup &Hi = Fixups[i];
+    const MCFixup &Lo = Fixups[i + 1];
+    if ((unsigned)Hi.getKind() != AArch64::fixup_aarch64_pcrel_adrp_imm21 ||
+        Lo.getOffset() != Hi.getOffset() + 4 ||
+        Lo.getOffset() + 4 > Data.size())
+      continue;
+
+    // Both halves must refer to the same plain symbol.
+    MCValue HiTarget, LoTarget;
+    if (!Hi.getValue()->evaluateAsRelocatable(HiTarget, &Layout, &Hi) ||
+        !Lo.getValue()->evaluateAsRelocatable(LoTarget, &Layout, &Lo))
+      continue;
+    if (HiTarget.getRefKind() != AArch64MCExpr::VK_ABS_PAGE ||
+        AArch64MCExpr::getSymbolLoc(
+            (AArch64MCExpr::VariantKind)LoTarget.getRefKind()) !=
+            AArch64MCExpr::VK_ABS ||
+        AArch64MCExpr::getAddressFrag(
+            (AArch64MCExpr::VariantKind)LoTarget.getRefKind()) !=
+            AArch64MCExpr::VK_PAGEOFF ||
+        !HiTarget.getSymA() || !LoTarget.getSymA() ||
+        &HiTarget.getSymA()->getSymbol() != &LoTarget.getSymA()->getSymbol() ||
+        HiTarget.getConstant() != LoTarget.getConstant())
+      continue;
+
+    uint64_t S;
+    bool valid;
+    if (!getSymbolAddress(Asm, Layout, HiTarget, S))
+      continue;
+    uint64_t P = Layout.getFragmentOffset(&F, valid) + Hi.getOffset();
+    if (!valid)
+      continue;
+    int64_t Delta = S - P;
+    if (Delta > 1048575 || Delta < -1048576)
+      continue;
+
+    char *HiData = &Data[Hi.getOffset()];
+    char *LoData = &Data[Lo.getOffset()];
+    uint32_t HiInsn = support::endian::read32le(HiData);
+    uint32_t LoInsn = support::endian::read32le(LoData);
+    unsigned Reg = HiInsn & 0x1f;
+    // adrp xzr is useless, and "add sp, sp" would read a different register.
+    if (Reg == 31 || ((LoInsn >> 5) & 0x1f) != Reg || (LoInsn & 0x1f) != Reg)
+      continue;
+
+    uint32_t NewInsn;
+    switch ((unsigned)Lo.getKind()) {
+    default:
+      continue;
+    case AArch64::fixup_aarch64_add_imm12:
+      // ADD Xd, Xn, #imm (64-bit, no shift)
+      if ((LoInsn & 0xffc00000) != 0x91000000)
+        continue;
+      NewInsn = 0x10000000 | AdrImmBits(Delta & 0x1fffff) | Reg;
+      break;
+    case AArch64::fixup_aarch64_ldst_imm12_scale4:
+    case AArch64::fixup_aarch64_ldst_imm12_scale8:
+      if (Delta & 3)
+        continue;
+      // LDR Xt, LDR Wt and LDRSW Xt (unsigned offset) map to their literal
+      // forms.
+      if ((LoInsn & 0xffc00000) == 0xf9400000)
+        NewInsn = 0x58000000;
+      else if ((LoInsn & 0xffc00000) == 0xb9400000)
+        NewInsn = 0x18000000;
+      else if ((LoInsn & 0xffc00000) == 0xb9800000)
+        NewInsn = 0x98000000;
+      else
+        continue;
+      NewInsn |= ((Delta >> 2) & 0x7ffff) << 5 | Reg;
+      break;
+    }
+
+    support::endian::write32le(HiData, NewInsn);
+    support::endian::write32le(LoData, 0xd503201f);
+    ++i;
+  }
+}
+
 bool AArch64AsmBackend::mayNeedRelaxation(const MCInst &Inst) const {
   return false;
 }
@@ -406,8 +537,39 @@ void ELFAArch64AsmBackend::processFixupValue(
   // same page as the ADRP and the instruction should encode 0x0. Assuming the
   // section isn't 0x1000-aligned, we therefore need to delegate this decision
   // to the linker -- a relocation!
-  if ((uint32_t)Fixup.getKind() == AArch64::fixup_aarch64_pcrel_adrp_imm21)
+  //
+  // Keystone has no linker to hand this to though, and knows where the code
+  // will live: resolve plain page/page-offset pairs here instead.
+  switch ((unsigned)Fixup.getKind()) {
+  default:
+    break;
+  case AArch64::fixup_aarch64_pcrel_adrp_imm21:
     IsResolved = false;
+    if (Target.getRefKind() == AArch64MCExpr::VK_ABS_PAGE &&
+        Target.getSymA() && !Target.getSymB()) {
+      bool valid;
+      uint64_t P = Layout.getFragmentOffset(DF, valid) + Fixup.getOffset();
+      if (valid) {
+        // Value is S - P here; turn it into the distance between the pages.
+        uint64_t S = Value + P;
+        Value = (S & ~0xfffULL) - (P & ~0xfffULL);
+        IsResolved = true;
+      }
+    }
+    break;
+  case AArch64::fixup_aarch64_add_imm12:
+  case AArch64::fixup_aarch64_ldst_imm12_scale1:
+  case AArch64::fixup_aarch64_ldst_imm12_scale2:
+  case AArch64::fixup_aarch64_ldst_imm12_scale4:
+  case AArch64::fixup_aarch64_ldst_imm12_scale8:
+  case AArch64::fixup_aarch64_ldst_imm12_scale16:
+    if (Target.getRefKind() == AArch64MCExpr::VK_LO12 &&
+        Target.getSymA() && !Target.getSymB()) {
+      Value &= 0xfff;
+      IsResolved = true;
+    }
+    break;
+  }
 }
 
 }
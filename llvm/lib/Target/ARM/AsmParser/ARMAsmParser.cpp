@@ -146,6 +146,10 @@ class ARMAsmParser : public MCTargetAsmParser {
 
   bool NextSymbolIsThumb;
 
+  // Set if MatchAndEmitInstruction() should first try the instruction with
+  // a .w qualifier, for MCTargetOptions::MCFixedWidth.
+  bool ImplicitWide;
+
   struct {
     ARMCC::CondCodes Cond;    // Condition for IT block.
     unsigned Mask:4;          // Condition mask for instructions.
@@ -378,6 +382,7 @@ public:
     ITState.CurPosition = ~0U;
 
     NextSymbolIsThumb = false;
+    ImplicitWide = false;
   }
 
   // Implementation of the MCTargetAsmParser interface:
@@ -6002,6 +6007,13 @@ bool ARMAsmParser::ParseInstruction(ParseInstructionInfo &Info, StringRef Name,
     return true;
   }
 
+  // In fixed-width mode ask for the 32-bit Thumb2 encoding, as if the
+  // instruction was written with .w. The operands are parsed as written,
+  // MatchAndEmitInstruction() adds the qualifier. IT only exists in 16 bits
+  // and takes its condition as a plain operand.
+  ImplicitWide = MCOptions.MCFixedWidth && isThumbTwo() &&
+                 Next == StringRef::npos && Mnemonic != "it";
+
   // Add the remaining tokens in the mnemonic.
   while (Next != StringRef::npos) {
     Start = Next;
@@ -8847,8 +8859,80 @@ bool ARMAsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
   MCInst Inst(Address);
   unsigned MatchResult;
 
-  MatchResult = MatchInstructionImpl(Operands, Inst, ErrorInfo,
-                                     MatchingInlineAsm);
+  // In fixed-width mode, try the instruction with .w first. The wide forms
+  // of some Thumb instructions want operands the narrow ones lack: a cc_out
+  // (e.g. "add sp, #8" as "add.w sp, sp, #8"), or a third operand, as
+  // two-operand forms have no .w alias of their own ("adds r0, #1" as
+  // "adds.w r0, r0, #1", "negs r0, r1" as "rsbs.w r0, r1, #0"). Only
+  // without any wide encoding, fall back to what was actually written.
+  if (ImplicitWide) {
+    ImplicitWide = false;
+    SmallVector<std::unique_ptr<MCParsedAsmOperand>, 8> Written;
+    for (auto &Op : Operands)
+      Written.push_back(std::move(Op));
+
+    // .w follows the mnemonic, cc_out and predicate, as in "adds.w"
+    unsigned Wide = 1;
+    while (Wide < Written.size() &&
+           (static_cast<ARMOperand &>(*Written[Wide]).isCCOut() ||
+            static_cast<ARMOperand &>(*Written[Wide]).isCondCode()))
+      ++Wide;
+    bool HasCCOut = static_cast<ARMOperand &>(*Written[1]).isCCOut();
+    bool TwoOperand = Wide + 2 == Written.size() &&
+                      static_cast<ARMOperand &>(*Written[Wide]).isReg();
+
+    auto tryWide = [&](bool AddCCOut, bool ThreeOperand) {
+      Operands.clear();
+      for (auto &Op : Written)
+        Operands.push_back(
+            make_unique<ARMOperand>(static_cast<ARMOperand &>(*Op)));
+      SMLoc Loc = Operands[0]->getStartLoc();
+      unsigned W = Wide;
+      if (AddCCOut)
+        Operands.insert(Operands.begin() + 1, ARMOperand::CreateCCOut(0, Loc));
+      W += AddCCOut;
+      Operands.insert(Operands.begin() + W, ARMOperand::CreateToken(".w", Loc));
+      if (ThreeOperand) {
+        ARMOperand &Rd = static_cast<ARMOperand &>(*Operands[W + 1]);
+        if (static_cast<ARMOperand &>(*Operands[0]).getToken() == "neg") {
+          Operands[0] = ARMOperand::CreateToken("rsb", Loc);
+          Operands.push_back(ARMOperand::CreateImm(
+              MCConstantExpr::create(0, getContext()), Rd.getStartLoc(),
+              Rd.getEndLoc()));
+        } else {
+          Operands.insert(Operands.begin() + W + 2,
+                          ARMOperand::CreateReg(Rd.getReg(), Rd.getStartLoc(),
+                                                Rd.getEndLoc()));
+        }
+      }
+
+      Inst = MCInst(Address);
+      MatchResult = MatchInstructionImpl(Operands, Inst, ErrorInfo,
+                                         MatchingInlineAsm);
+      if (MatchResult != Match_Success)
+        return false;
+      // validateInstruction() steps the IT block state, run it on a copy.
+      auto SavedITState = ITState;
+      bool Invalid = validateInstruction(Inst, Operands);
+      ITState = SavedITState;
+      return !Invalid;
+    };
+
+    if (!tryWide(false, false) && !(TwoOperand && tryWide(false, true)) &&
+        !(!HasCCOut && tryWide(true, false)) &&
+        !(!HasCCOut && TwoOperand && tryWide(true, true))) {
+      Operands.clear();
+      for (auto &Op : Written)
+        Operands.push_back(std::move(Op));
+      Inst = MCInst(Address);
+      MatchResult = MatchInstructionImpl(Operands, Inst, ErrorInfo,
+                                         MatchingInlineAsm);
+    }
+  } else {
+    MatchResult = MatchInstructionImpl(Operands, Inst, ErrorInfo,
+                                       MatchingInlineAsm);
+  }
+
   switch (MatchResult) {
   case Match_Success:
     // Context sensitive operand constraints aren't handled by the matcher,
@@ -18,6 +18,7 @@
 #include "MCTargetDesc/HexagonMCShuffler.h"
 #include "MCTargetDesc/HexagonMCTargetDesc.h"
 #include "MCTargetDesc/HexagonShuffler.h"
+#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringExtras.h"
@@ -30,6 +31,7 @@
 #include "llvm/MC/MCParser/MCAsmParser.h"
 #include "llvm/MC/MCParser/MCParsedAsmOperand.h"
 #include "llvm/MC/MCParser/MCTargetAsmParser.h"
+#include "llvm/MC/MCRegisterInfo.h"
 #include "llvm/MC/MCSectionELF.h"
 #include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCSubtargetInfo.h"
@@ -67,6 +69,9 @@ class HexagonAsmParser : public MCTargetAsmParser {
   MCInstrInfo const &MCII;
   MCInst MCB;
   bool InBrackets;
+  // Automatic packetization of unbundled instructions (KS_OPT_PACKETIZE)
+  bool AutoPacketize;
+  SMLoc PacketLoc;
 
   MCAsmParser &getParser() const { return Parser; }
   MCAssembler *getAssembler() const { return Assembler; }
@@ -90,6 +95,12 @@ class HexagonAsmParser : public MCTargetAsmParser {
   bool matchBundleOptions();
   bool handleNoncontigiousRegister(bool Contigious, SMLoc &Loc);
   bool finishBundle(SMLoc IDLoc, MCStreamer &Out, unsigned &KsError);
+  void resetBundle();
+  bool canJoinPacket(MCInst const &MCI);
+  bool isLegalPacket(MCInst const &Candidate);
+  bool endsPacket(MCInst const &MCI) const;
+  bool flushPendingInstructions(MCStreamer &Out,
+                                unsigned int &ErrorCode) override;
   void canonicalizeImmediates(MCInst &MCI);
   bool matchOneInstruction(MCInst &MCB, SMLoc IDLoc,
                            OperandVector &InstOperands, uint64_t &ErrorInfo,
@@ -122,7 +133,8 @@ public:
   HexagonAsmParser(const MCSubtargetInfo &_STI, MCAsmParser &_Parser,
                    const MCInstrInfo &MII, const MCTargetOptions &Options)
     : MCTargetAsmParser(Options, _STI), Parser(_Parser),
-      MCII (MII), MCB(HexagonMCInstrInfo::createBundle()), InBrackets(false) {
+      MCII (MII), MCB(HexagonMCInstrInfo::createBundle()), InBrackets(false),
+      AutoPacketize(Options.MCAutoPacketize) {
     setAvailableFeatures(ComputeAvailableFeatures(getSTI().getFeatureBits()));
 
   MCAsmParserExtension::Initialize(_Parser);
@@ -717,6 +729,87 @@ bool HexagonAsmParser::finishBundle(SMLoc IDLoc, MCStreamer &Out, unsigned &KsEr
   return false; // No error
 }
 
+void HexagonAsmParser::resetBundle() {
+  MCB.clear();
+  MCB.addOperand(MCOperand::createImm(0));
+}
+
+// Collect the registers read or written by MCI, including all their aliases.
+static void collectRegisters(MCInstrInfo const &MCII, MCRegisterInfo const &RI,
+                             MCInst const &MCI, bool Defs, BitVector &Regs) {
+  MCInstrDesc const &Desc = HexagonMCInstrInfo::getDesc(MCII, MCI);
+  unsigned Begin = Defs ? 0 : Desc.getNumDefs();
+  unsigned End = Defs ? Desc.getNumDefs() : MCI.getNumOperands();
+  for (unsigned i = Begin; i < End && i < MCI.getNumOperands(); ++i)
+    if (MCI.getOperand(i).isReg() && MCI.getOperand(i).getReg())
+      for (MCRegAliasIterator A(MCI.getOperand(i).getReg(), &RI, true);
+           A.isValid(); ++A)
+        Regs.set(*A);
+  MCPhysReg const *Implicit =
+      Defs ? Desc.getImplicitDefs() : Desc.getImplicitUses();
+  for (; Implicit && *Implicit; ++Implicit)
+    for (MCRegAliasIterator A(*Implicit, &RI, true); A.isValid(); ++A)
+      Regs.set(*A);
+}
+
+// Check that MCI can execute in the same packet as the instructions already
+// in MCB without changing the meaning of the sequential input: all of them
+// read the register and memory state from before the packet.
+bool HexagonAsmParser::canJoinPacket(MCInst const &MCI) {
+  MCRegisterInfo const &RI = *getContext().getRegisterInfo();
+  MCInstrDesc const &Desc = HexagonMCInstrInfo::getDesc(MCII, MCI);
+  BitVector Defs(RI.getNumRegs());
+  bool HasStore = false;
+
+  for (auto const &I : HexagonMCInstrInfo::bundleInstructions(MCB)) {
+    MCInst const &Prev = *I.getInst();
+    if (HexagonMCInstrInfo::isImmext(Prev))
+      continue;
+    collectRegisters(MCII, RI, Prev, true, Defs);
+    HasStore |= HexagonMCInstrInfo::getDesc(MCII, Prev).mayStore();
+  }
+
+  // A later load or store must observe an earlier store.
+  if (HasStore && (Desc.mayLoad() || Desc.mayStore()))
+    return false;
+
+  // Explicit .new consumers want the value produced in this packet; the
+  // checker validates them.
+  if (HexagonMCInstrInfo::isNewValue(MCII, MCI) ||
+      HexagonMCInstrInfo::isPredicatedNew(MCII, MCI))
+    return true;
+
+  BitVector Uses(RI.getNumRegs());
+  collectRegisters(MCII, RI, MCI, false, Uses);
+  return !Uses.anyCommon(Defs);
+}
+
+// Check resources, dependencies and slots of a candidate packet, letting
+// compounding and duplexing shrink it, without touching the candidate.
+bool HexagonAsmParser::isLegalPacket(MCInst const &Candidate) {
+  MCInst Trial(Candidate);
+  HexagonMCChecker Check(MCII, getSTI(), Trial, Trial,
+                         *getContext().getRegisterInfo());
+  return HexagonMCInstrInfo::canonicalizePacket(MCII, getSTI(), getContext(),
+                                                Trial, &Check);
+}
+
+// Control flow and solo instructions close the current packet.
+bool HexagonAsmParser::endsPacket(MCInst const &MCI) const {
+  MCInstrDesc const &Desc = HexagonMCInstrInfo::getDesc(MCII, MCI);
+  return Desc.isBranch() || Desc.isCall() || Desc.isReturn() ||
+         HexagonMCInstrInfo::isSolo(MCII, MCI);
+}
+
+bool HexagonAsmParser::flushPendingInstructions(MCStreamer &Out,
+                                                unsigned int &ErrorCode) {
+  if (!AutoPacketize || InBrackets || HexagonMCInstrInfo::bundleSize(MCB) == 0)
+    return false;
+  bool Failed = finishBundle(PacketLoc, Out, ErrorCode);
+  resetBundle();
+  return Failed;
+}
+
 bool HexagonAsmParser::matchBundleOptions() {
   MCAsmParser &Parser = getParser();
   MCAsmLexer &Lexer = getLexer();
@@ -839,10 +932,8 @@ bool HexagonAsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
                                                uint64_t &ErrorInfo,
                                                bool MatchingInlineAsm, unsigned int &ErrorCode, uint64_t &Address)
 {
-  if (!InBrackets) {
-    MCB.clear();
-    MCB.addOperand(MCOperand::createImm(0));
-  }
+  if (!InBrackets && !AutoPacketize)
+    resetBundle();
   if (Operands.size() == 0) {
       ErrorCode = KS_ERR_ASM_INVALIDOPERAND;
       return true;
@@ -855,6 +946,10 @@ bool HexagonAsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
       ErrorCode = KS_ERR_ASM_INVALIDOPERAND;
       return true;
     }
+    // Explicit packets are never merged with automatic ones.
+    if (flushPendingInstructions(Out, ErrorCode))
+      return true;
+    resetBundle();
     InBrackets = true;
     return false;
   }
@@ -870,7 +965,9 @@ bool HexagonAsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
       ErrorCode = KS_ERR_ASM_INVALIDOPERAND;
       return true;
     }
-    return finishBundle(IDLoc, Out, ErrorCode);
+    bool Failed = finishBundle(IDLoc, Out, ErrorCode);
+    resetBundle();
+    return Failed;
   }
   MCInst *SubInst = new (getParser().getContext()) MCInst;
   bool MustExtend = false;
@@ -879,9 +976,32 @@ bool HexagonAsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
     ErrorCode = KS_ERR_ASM_INVALIDOPERAND;
     return true;
   }
+  bool Extend = HexagonMCInstrInfo::isExtended(MCII, *SubInst) || MustExtend;
+  if (!InBrackets && AutoPacketize) {
+    // Greedily add the instruction to the open packet, or start a new one.
+    MCInst Candidate(MCB);
+    HexagonMCInstrInfo::extendIfNeeded(getParser().getContext(), MCII,
+                                       Candidate, *SubInst, Extend);
+    Candidate.addOperand(MCOperand::createInst(SubInst));
+    if (HexagonMCInstrInfo::bundleSize(MCB) == 0) {
+      PacketLoc = IDLoc;
+      MCB = Candidate;
+    } else if (canJoinPacket(*SubInst) && isLegalPacket(Candidate)) {
+      MCB = Candidate;
+    } else {
+      if (flushPendingInstructions(Out, ErrorCode))
+        return true;
+      PacketLoc = IDLoc;
+      HexagonMCInstrInfo::extendIfNeeded(getParser().getContext(), MCII, MCB,
+                                         *SubInst, Extend);
+      MCB.addOperand(MCOperand::createInst(SubInst));
+    }
+    if (endsPacket(*SubInst))
+      return flushPendingInstructions(Out, ErrorCode);
+    return false;
+  }
   HexagonMCInstrInfo::extendIfNeeded(
-      getParser().getContext(), MCII, MCB, *SubInst,
-      HexagonMCInstrInfo::isExtended(MCII, *SubInst) || MustExtend);
+      getParser().getContext(), MCII, MCB, *SubInst, Extend);
   MCB.addOperand(MCOperand::createInst(SubInst));
   if (!InBrackets)
     return finishBundle(IDLoc, Out, ErrorCode);
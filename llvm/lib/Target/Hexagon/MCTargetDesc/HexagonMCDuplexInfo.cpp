@@ -11,9 +11,11 @@
 //
 //===----------------------------------------------------------------------===//
 
+#include "Hexagon.h"
 #include "HexagonBaseInfo.h"
 #include "MCTargetDesc/HexagonMCInstrInfo.h"
 
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/raw_ostream.h"
@@ -83,29 +85,25 @@ static const std::pair<unsigned, unsigned> opcodeData[] = {
 static std::map<unsigned, unsigned>
     subinstOpcodeMap(std::begin(opcodeData), std::end(opcodeData));
 
+// For each sub-instruction group of the slot 1 insn, the set of groups the
+// slot 0 insn may belong to, one bit per HexagonII::SubInstructionGroup.
+static unsigned const duplexPartners[] = {
+    /* HSIG_None */ 0,
+    /* HSIG_L1 */ 1 << HexagonII::HSIG_L1 | 1 << HexagonII::HSIG_A,
+    /* HSIG_L2 */ 1 << HexagonII::HSIG_L1 | 1 << HexagonII::HSIG_L2 |
+        1 << HexagonII::HSIG_A,
+    /* HSIG_S1 */ 1 << HexagonII::HSIG_L1 | 1 << HexagonII::HSIG_L2 |
+        1 << HexagonII::HSIG_S1 | 1 << HexagonII::HSIG_A,
+    /* HSIG_S2 */ 1 << HexagonII::HSIG_L1 | 1 << HexagonII::HSIG_L2 |
+        1 << HexagonII::HSIG_S1 | 1 << HexagonII::HSIG_S2 |
+        1 << HexagonII::HSIG_A,
+    /* HSIG_A */ 1 << HexagonII::HSIG_A,
+    /* HSIG_Compound */ 1 << HexagonII::HSIG_Compound};
+
 bool HexagonMCInstrInfo::isDuplexPairMatch(unsigned Ga, unsigned Gb) {
-  switch (Ga) {
-  case HexagonII::HSIG_None:
-  default:
+  if (Ga >= array_lengthof(duplexPartners) || Gb >= 32)
     return false;
-  case HexagonII::HSIG_L1:
-    return (Gb == HexagonII::HSIG_L1 || Gb == HexagonII::HSIG_A);
-  case HexagonII::HSIG_L2:
-    return (Gb == HexagonII::HSIG_L1 || Gb == HexagonII::HSIG_L2 ||
-            Gb == HexagonII::HSIG_A);
-  case HexagonII::HSIG_S1:
-    return (Gb == HexagonII::HSIG_L1 || Gb == HexagonII::HSIG_L2 ||
-            Gb == HexagonII::HSIG_S1 || Gb == HexagonII::HSIG_A);
-  case HexagonII::HSIG_S2:
-    return (Gb == HexagonII::HSIG_L1 || Gb == HexagonII::HSIG_L2 ||
-            Gb == HexagonII::HSIG_S1 || Gb == HexagonII::HSIG_S2 ||
-            Gb == HexagonII::HSIG_A);
-  case HexagonII::HSIG_A:
-    return (Gb == HexagonII::HSIG_A);
-  case HexagonII::HSIG_Compound:
-    return (Gb == HexagonII::HSIG_Compound);
-  }
-  return false;
+  return (duplexPartners[Ga] >> Gb) & 1;
 }
 
 unsigned HexagonMCInstrInfo::iClassOfDuplexPair(unsigned Ga, unsigned Gb) {
@@ -575,6 +573,13 @@ bool HexagonMCInstrInfo::isOrderedDuplexPair(MCInstrInfo const &MCII,
                                              MCInst const &MIa, bool ExtendedA,
                                              MCInst const &MIb, bool ExtendedB,
                                              bool bisReversable) {
+  unsigned MIaG = HexagonMCInstrInfo::getDuplexCandidateGroup(MIa),
+           MIbG = HexagonMCInstrInfo::getDuplexCandidateGroup(MIb);
+
+  // Reject incompatible groups before deriving any sub-insns.
+  if (!isDuplexPairMatch(MIaG, MIbG))
+    return false;
+
   // Slot 1 cannot be extended in duplexes PRM 10.5
   if (ExtendedA)
     return false;
@@ -584,8 +589,6 @@ bool HexagonMCInstrInfo::isOrderedDuplexPair(MCInstrInfo const &MCII,
     if ((Opcode != Hexagon::A2_addi) && (Opcode != Hexagon::A2_tfrsi))
       return false;
   }
-  unsigned MIaG = HexagonMCInstrInfo::getDuplexCandidateGroup(MIa),
-           MIbG = HexagonMCInstrInfo::getDuplexCandidateGroup(MIb);
 
   // If a duplex contains 2 insns in the same group, the insns must be
   // ordered such that the numerically smaller opcode is in slot 1.
@@ -638,7 +641,7 @@ bool HexagonMCInstrInfo::isOrderedDuplexPair(MCInstrInfo const &MCII,
       return false;
   }
 
-  return (isDuplexPairMatch(MIaG, MIbG));
+  return true;
 }
 
 /// Symmetrical. See if these two instructions are fit for duplex pair.
@@ -1017,10 +1020,21 @@ HexagonMCInstrInfo::getDuplexPossibilties(MCInstrInfo const &MCII,
   // Use an "order matters" version of isDuplexPair.
   unsigned numInstrInPacket = MCB.getNumOperands();
 
+  // Classify each insn once, so pairs that cannot form a duplex in either
+  // order are skipped without looking at their operands again.
+  SmallVector<unsigned, HEXAGON_PRESHUFFLE_PACKET_SIZE + 1> groups(
+      numInstrInPacket, HexagonII::HSIG_None);
+  for (unsigned i = HexagonMCInstrInfo::bundleInstructionsOffset;
+       i < numInstrInPacket; ++i)
+    groups[i] = getDuplexCandidateGroup(*MCB.getOperand(i).getInst());
+
   for (unsigned distance = 1; distance < numInstrInPacket; ++distance) {
     for (unsigned j = HexagonMCInstrInfo::bundleInstructionsOffset,
                   k = j + distance;
          (j < numInstrInPacket) && (k < numInstrInPacket); ++j, ++k) {
+      if (!isDuplexPairMatch(groups[k], groups[j]) &&
+          !isDuplexPairMatch(groups[j], groups[k]))
+        continue;
 
       // Check if reversable.
       bool bisReversable = true;
@@ -1041,9 +1055,7 @@ HexagonMCInstrInfo::getDuplexPossibilties(MCInstrInfo const &MCII,
               HexagonMCInstrInfo::hasExtenderForIndex(MCB, j - 1),
               bisReversable)) {
         // Get iClass.
-        unsigned iClass = iClassOfDuplexPair(
-            getDuplexCandidateGroup(*MCB.getOperand(k).getInst()),
-            getDuplexCandidateGroup(*MCB.getOperand(j).getInst()));
+        unsigned iClass = iClassOfDuplexPair(groups[k], groups[j]);
 
         // Save off pairs for duplex checking.
         duplexToTry.push_back(DuplexCandidate(j, k, iClass));
@@ -1066,9 +1078,7 @@ HexagonMCInstrInfo::getDuplexPossibilties(MCInstrInfo const &MCII,
                 HexagonMCInstrInfo::hasExtenderForIndex(MCB, k - 1),
                 bisReversable)) {
           // Get iClass.
-          unsigned iClass = iClassOfDuplexPair(
-              getDuplexCandidateGroup(*MCB.getOperand(j).getInst()),
-              getDuplexCandidateGroup(*MCB.getOperand(k).getInst()));
+          unsigned iClass = iClassOfDuplexPair(groups[j], groups[k]);
 
           // Save off pairs for duplex checking.
           duplexToTry.push_back(DuplexCandidate(k, j, iClass));
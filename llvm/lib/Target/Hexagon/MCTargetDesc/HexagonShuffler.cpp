@@ -21,6 +21,7 @@
 #include "MCTargetDesc/HexagonMCTargetDesc.h"
 #include "MCTargetDesc/HexagonMCInstrInfo.h"
 #include "HexagonShuffler.h"
+#include "llvm/ADT/STLExtras.h"
 #include "llvm/Support/Debug.h"
 #include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
@@ -76,6 +77,16 @@ public:
       return false;
   };
 };
+
+// Find a distinct slot for each of the slot masks, most constrained first.
+static bool assignSlots(unsigned const *Masks, unsigned Count, unsigned Used) {
+  if (!Count)
+    return true;
+  for (unsigned Free = Masks[0] & ~Used; Free; Free &= Free - 1)
+    if (assignSlots(Masks + 1, Count - 1, Used | (Free & -Free)))
+      return true;
+  return false;
+}
 } // end anonymous namespace
 
 unsigned HexagonResource::setWeight(unsigned s) {
@@ -95,40 +106,45 @@ unsigned HexagonResource::setWeight(unsigned s) {
   return (Weight);
 }
 
-void HexagonCVIResource::SetupTUL(TypeUnitsAndLanes *TUL, StringRef CPU) {
-  (*TUL)[HexagonII::TypeCVI_VA] =
-      UnitsAndLanes(CVI_XLANE | CVI_SHIFT | CVI_MPY0 | CVI_MPY1, 1);
-  (*TUL)[HexagonII::TypeCVI_VA_DV] = UnitsAndLanes(CVI_XLANE | CVI_MPY0, 2);
-  (*TUL)[HexagonII::TypeCVI_VX] = UnitsAndLanes(CVI_MPY0 | CVI_MPY1, 1);
-  (*TUL)[HexagonII::TypeCVI_VX_DV] = UnitsAndLanes(CVI_MPY0, 2);
-  (*TUL)[HexagonII::TypeCVI_VP] = UnitsAndLanes(CVI_XLANE, 1);
-  (*TUL)[HexagonII::TypeCVI_VP_VS] = UnitsAndLanes(CVI_XLANE, 2);
-  (*TUL)[HexagonII::TypeCVI_VS] = UnitsAndLanes(CVI_SHIFT, 1);
-  (*TUL)[HexagonII::TypeCVI_VINLANESAT] = UnitsAndLanes(CVI_SHIFT, 1);
-  (*TUL)[HexagonII::TypeCVI_VM_LD] =
-      UnitsAndLanes(CVI_XLANE | CVI_SHIFT | CVI_MPY0 | CVI_MPY1, 1);
-  (*TUL)[HexagonII::TypeCVI_VM_TMP_LD] = UnitsAndLanes(CVI_NONE, 0);
-  (*TUL)[HexagonII::TypeCVI_VM_CUR_LD] =
-      UnitsAndLanes(CVI_XLANE | CVI_SHIFT | CVI_MPY0 | CVI_MPY1, 1);
-  (*TUL)[HexagonII::TypeCVI_VM_VP_LDU] = UnitsAndLanes(CVI_XLANE, 1);
-  (*TUL)[HexagonII::TypeCVI_VM_ST] =
-      UnitsAndLanes(CVI_XLANE | CVI_SHIFT | CVI_MPY0 | CVI_MPY1, 1);
-  (*TUL)[HexagonII::TypeCVI_VM_NEW_ST] = UnitsAndLanes(CVI_NONE, 0);
-  (*TUL)[HexagonII::TypeCVI_VM_STU] = UnitsAndLanes(CVI_XLANE, 1);
-  (*TUL)[HexagonII::TypeCVI_HIST] = UnitsAndLanes(CVI_XLANE, 4);
+bool HexagonCVIResource::getUnitsAndLanes(unsigned Type, UnitsAndLanes &UL) {
+  // Indexed by insn type, from TypeCVI_FIRST to TypeCVI_LAST.
+  static UnitsAndLanes const CVIUnitsAndLanes[] = {
+      /* TypeCVI_VA */ {CVI_XLANE | CVI_SHIFT | CVI_MPY0 | CVI_MPY1, 1},
+      /* TypeCVI_VA_DV */ {CVI_XLANE | CVI_MPY0, 2},
+      /* TypeCVI_VX */ {CVI_MPY0 | CVI_MPY1, 1},
+      /* TypeCVI_VX_DV */ {CVI_MPY0, 2},
+      /* TypeCVI_VP */ {CVI_XLANE, 1},
+      /* TypeCVI_VP_VS */ {CVI_XLANE, 2},
+      /* TypeCVI_VS */ {CVI_SHIFT, 1},
+      /* TypeCVI_VINLANESAT */ {CVI_SHIFT, 1},
+      /* TypeCVI_VM_LD */ {CVI_XLANE | CVI_SHIFT | CVI_MPY0 | CVI_MPY1, 1},
+      /* TypeCVI_VM_TMP_LD */ {CVI_NONE, 0},
+      /* TypeCVI_VM_CUR_LD */ {CVI_XLANE | CVI_SHIFT | CVI_MPY0 | CVI_MPY1, 1},
+      /* TypeCVI_VM_VP_LDU */ {CVI_XLANE, 1},
+      /* TypeCVI_VM_ST */ {CVI_XLANE | CVI_SHIFT | CVI_MPY0 | CVI_MPY1, 1},
+      /* TypeCVI_VM_NEW_ST */ {CVI_NONE, 0},
+      /* TypeCVI_VM_STU */ {CVI_XLANE, 1},
+      /* TypeCVI_HIST */ {CVI_XLANE, 4}};
+
+  static_assert(array_lengthof(CVIUnitsAndLanes) ==
+                    HexagonII::TypeCVI_LAST - HexagonII::TypeCVI_FIRST + 1,
+                "missing HVX insn type");
+  if (Type < HexagonII::TypeCVI_FIRST || Type > HexagonII::TypeCVI_LAST)
+    return false;
+  UL = CVIUnitsAndLanes[Type - HexagonII::TypeCVI_FIRST];
+  return true;
 }
 
-HexagonCVIResource::HexagonCVIResource(TypeUnitsAndLanes *TUL,
-                                       MCInstrInfo const &MCII, unsigned s,
+HexagonCVIResource::HexagonCVIResource(MCInstrInfo const &MCII, unsigned s,
                                        MCInst const *id)
-    : HexagonResource(s), TUL(TUL) {
-  unsigned T = HexagonMCInstrInfo::getType(MCII, *id);
+    : HexagonResource(s) {
+  UnitsAndLanes UL;
 
-  if (TUL->count(T)) {
+  if (getUnitsAndLanes(HexagonMCInstrInfo::getType(MCII, *id), UL)) {
     // For an HVX insn.
     Valid = true;
-    setUnits((*TUL)[T].first);
-    setLanes((*TUL)[T].second);
+    setUnits(UL.first);
+    setLanes(UL.second);
     setLoad(HexagonMCInstrInfo::getDesc(MCII, *id).mayLoad());
     setStore(HexagonMCInstrInfo::getDesc(MCII, *id).mayStore());
   } else {
@@ -145,7 +161,6 @@ HexagonShuffler::HexagonShuffler(MCInstrInfo const &MCII,
                                  MCSubtargetInfo const &STI)
     : MCII(MCII), STI(STI) {
   reset();
-  HexagonCVIResource::SetupTUL(&TUL, STI.getCPU());
 }
 
 void HexagonShuffler::reset() {
@@ -156,11 +171,21 @@ void HexagonShuffler::reset() {
 
 void HexagonShuffler::append(MCInst const *ID, MCInst const *Extender,
                              unsigned S, bool X) {
-  HexagonInstr PI(&TUL, MCII, ID, Extender, S, X);
+  HexagonInstr PI(MCII, ID, Extender, S, X);
 
   Packet.push_back(PI);
 }
 
+bool HexagonShuffler::checkCoreSlots() const {
+  if (size() > HEXAGON_PACKET_SIZE)
+    return false;
+
+  unsigned Masks[HEXAGON_PACKET_SIZE];
+  for (unsigned i = 0; i < size(); ++i)
+    Masks[i] = Packet[i].Core.getUnits();
+  return assignSlots(Masks, size(), 0);
+}
+
 /// Check that the packet is legal and enforce relative insn order.
 bool HexagonShuffler::check() {
   // Descriptive slot masks.
@@ -365,14 +390,10 @@ bool HexagonShuffler::check() {
     unsigned saveUnits = slot3ISJ->Core.getUnits();
     slot3ISJ->Core.setUnits(saveUnits & slotThree);
 
-    HexagonUnitAuction AuctionCore;
     std::sort(begin(), end(), HexagonInstr::lessCore);
 
     // see if things ok with that instruction being pinned to slot #3
-    bool bFail = false;
-    for (iterator I = begin(); I != end() && bFail != true; ++I)
-      if (!AuctionCore.bid(I->Core.getUnits()))
-        bFail = true;
+    bool bFail = !checkCoreSlots();
 
     // if yes, great, if not then restore original slot mask
     if (!bFail)
@@ -388,15 +409,12 @@ bool HexagonShuffler::check() {
   // Check if any slot, core, is over-subscribed.
   // Verify the core slot subscriptions.
   if (validateSlots) {
-    HexagonUnitAuction AuctionCore;
-
     std::sort(begin(), end(), HexagonInstr::lessCore);
 
-    for (iterator I = begin(); I != end(); ++I)
-      if (!AuctionCore.bid(I->Core.getUnits())) {
-        Error = SHUFFLE_ERROR_SLOTS;
-        return false;
-      }
+    if (!checkCoreSlots()) {
+      Error = SHUFFLE_ERROR_SLOTS;
+      return false;
+    }
   }
   // Verify the CVI slot subscriptions.
   {
@@ -56,7 +56,6 @@ public:
 class HexagonCVIResource : public HexagonResource {
 public:
   typedef std::pair<unsigned, unsigned> UnitsAndLanes;
-  typedef llvm_ks::DenseMap<unsigned, UnitsAndLanes> TypeUnitsAndLanes;
 
 private:
   // Available HVX slots.
@@ -68,8 +67,6 @@ private:
     CVI_MPY1 = 1 << 3
   };
 
-  TypeUnitsAndLanes *TUL;
-
   // Count of adjacent slots that the insn requires to be executed.
   unsigned Lanes;
   // Flag whether the insn is a load or a store.
@@ -82,9 +79,9 @@ private:
   void setStore(bool f = true) { Store = f; };
 
 public:
-  HexagonCVIResource(TypeUnitsAndLanes *TUL, MCInstrInfo const &MCII,
-                     unsigned s, MCInst const *id);
-  static void SetupTUL(TypeUnitsAndLanes *TUL, StringRef CPU);
+  HexagonCVIResource(MCInstrInfo const &MCII, unsigned s, MCInst const *id);
+  // HVX units and lanes used by an insn type, if it is an HVX type.
+  static bool getUnitsAndLanes(unsigned Type, UnitsAndLanes &UL);
 
   bool isValid() const { return (Valid); };
   unsigned getLanes() const { return (Lanes); };
@@ -103,10 +100,9 @@ class HexagonInstr {
   bool SoloException;
 
 public:
-  HexagonInstr(HexagonCVIResource::TypeUnitsAndLanes *T,
-               MCInstrInfo const &MCII, MCInst const *id,
+  HexagonInstr(MCInstrInfo const &MCII, MCInst const *id,
                MCInst const *Extender, unsigned s, bool x = false)
-      : ID(id), Extender(Extender), Core(s), CVI(T, MCII, s, id),
+      : ID(id), Extender(Extender), Core(s), CVI(MCII, s, id),
         SoloException(x) {};
 
   MCInst const *getDesc() const { return (ID); };
@@ -140,7 +136,8 @@ class HexagonShuffler {
   // Shuffling error code.
   unsigned Error;
 
-  HexagonCVIResource::TypeUnitsAndLanes TUL;
+  // Check if every insn can be assigned a core slot of its own.
+  bool checkCoreSlots() const;
 
 protected:
   int64_t BundleFlags;
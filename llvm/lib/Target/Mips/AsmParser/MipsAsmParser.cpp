@@ -23,6 +23,7 @@
 #include "llvm/MC/MCParser/MCAsmLexer.h"
 #include "llvm/MC/MCParser/MCParsedAsmOperand.h"
 #include "llvm/MC/MCParser/MCTargetAsmParser.h"
+#include "llvm/MC/MCRegisterInfo.h"
 #include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/MC/MCSymbol.h"
@@ -123,6 +124,13 @@ class MipsAsmParser : public MCTargetAsmParser {
   /// If true, then CpSaveLocation is a register, otherwise it's an offset.
   bool     CpSaveLocationIsRegister;
 
+  /// Delay slot filling (MCTargetOptions::MCFillDelaySlots): the last
+  /// instruction is held back, in case the next one is a branch whose delay
+  /// slot it can go to.
+  MCInst PendingInst;
+  bool HasPendingInst = false;
+  uint64_t BytesSaved = 0;
+
   // Print a warning along with its fix-it message at the given range.
   void printWarningWithFixIt(const Twine &Msg, const Twine &FixMsg,
                              SMRange Range, bool ShowColors = true);
@@ -240,6 +248,14 @@ class MipsAsmParser : public MCTargetAsmParser {
   void createNop(bool hasShortDelaySlot, SMLoc IDLoc,
                  SmallVectorImpl<MCInst> &Instructions);
 
+  bool emitInstruction(MCInst &Inst, MCStreamer &Out, unsigned int &ErrorCode,
+                       uint64_t &Address);
+  bool emitInstructions(SmallVectorImpl<MCInst> &Instructions,
+                        MCStreamer &Out, unsigned int &ErrorCode,
+                        uint64_t &Address);
+  bool isDelaySlotCandidate(const MCInst &Inst) const;
+  bool canFillDelaySlot(const MCInst &Inst, const MCInst &Branch);
+
   void createAddu(unsigned DstReg, unsigned SrcReg, unsigned TrgReg,
                   bool Is64Bit, SmallVectorImpl<MCInst> &Instructions);
 
@@ -442,6 +458,11 @@ public:
       IsLittleEndian = true;
   }
 
+  bool flushPendingInstructions(MCStreamer &Out,
+                                unsigned int &ErrorCode) override;
+
+  uint64_t getBytesSaved() const override { return BytesSaved; }
+
   /// True if all of $fcc0 - $fcc7 exist for the current ISA.
   bool hasEightFccRegisters() const { return hasMips4() || hasMips32(); }
 
@@ -3684,6 +3705,175 @@ void MipsAsmParser::createNop(bool hasShortDelaySlot, SMLoc IDLoc,
     emitRRI(Mips::SLL, Mips::ZERO, Mips::ZERO, 0, IDLoc, Instructions);
 }
 
+static bool isNop(const MCInst &Inst) {
+  switch (Inst.getOpcode()) {
+  default:
+    return false;
+  case Mips::SLL:
+  case Mips::SLL_MM:
+    return Inst.getOperand(0).getReg() == Mips::ZERO &&
+           Inst.getOperand(1).getReg() == Mips::ZERO &&
+           Inst.getOperand(2).isImm() && Inst.getOperand(2).getImm() == 0;
+  case Mips::MOVE16_MM:
+    return Inst.getOperand(0).getReg() == Mips::ZERO &&
+           Inst.getOperand(1).getReg() == Mips::ZERO;
+  }
+}
+
+static bool isPCRelative(unsigned Opcode) {
+  switch (Opcode) {
+  default:
+    return false;
+  case Mips::ADDIUPC: case Mips::ADDIUPC_MM: case Mips::ADDIUPC_MMR6:
+  case Mips::ALUIPC:  case Mips::ALUIPC_MMR6:
+  case Mips::AUIPC:   case Mips::AUIPC_MMR6:
+  case Mips::LDPC:    case Mips::LWPC: case Mips::LWPC_MMR6: case Mips::LWUPC:
+    return true;
+  }
+}
+
+/// Collect the registers Inst writes and reads, implicit ones included.
+static void getDefsAndUses(const MCInst &Inst,
+                           SmallVectorImpl<unsigned> &Defs,
+                           SmallVectorImpl<unsigned> &Uses) {
+  const MCInstrDesc &Desc = getInstDesc(Inst.getOpcode());
+  for (unsigned i = 0, e = Inst.getNumOperands(); i != e; ++i) {
+    const MCOperand &Op = Inst.getOperand(i);
+    if (!Op.isReg() || !Op.getReg())
+      continue;
+    if (i < Desc.getNumDefs())
+      Defs.push_back(Op.getReg());
+    else
+      Uses.push_back(Op.getReg());
+  }
+  for (unsigned i = 0, e = Desc.getNumImplicitDefs(); i != e; ++i)
+    Defs.push_back(Desc.getImplicitDefs()[i]);
+  for (unsigned i = 0, e = Desc.getNumImplicitUses(); i != e; ++i)
+    Uses.push_back(Desc.getImplicitUses()[i]);
+}
+
+static bool anyOverlap(const MCRegisterInfo &MRI, ArrayRef<unsigned> A,
+                       ArrayRef<unsigned> B) {
+  for (unsigned RegA : A)
+    for (unsigned RegB : B)
+      for (MCRegAliasIterator AI(RegA, &MRI, true); AI.isValid(); ++AI)
+        if (*AI == RegB)
+          return true;
+  return false;
+}
+
+/// Return true if Inst may be moved past a branch into its delay slot, as
+/// far as Inst alone is concerned.
+bool MipsAsmParser::isDelaySlotCandidate(const MCInst &Inst) const {
+  const MCInstrDesc &Desc = getInstDesc(Inst.getOpcode());
+  if (Desc.isBranch() || Desc.isCall() || Desc.isReturn() ||
+      Desc.isTerminator() || Desc.isBarrier() || Desc.hasDelaySlot() ||
+      Desc.isPseudo() || Desc.hasUnmodeledSideEffects() ||
+      isPCRelative(Inst.getOpcode()) || isNop(Inst))
+    return false;
+
+  // Before MIPS32, the hardware does not wait for HI/LO reads and
+  // coprocessor moves to complete, nor (on MIPS I) for loads; the branch
+  // target may start with a use of the result.
+  if (!hasMips32() &&
+      ((!hasMips2() && Desc.mayLoad()) || Desc.getNumImplicitUses() ||
+       Desc.isBitcast()))
+    return false;
+
+  return true;
+}
+
+/// Return true if Inst, which comes right before Branch, can be executed in
+/// the delay slot of Branch instead: Branch must not read what Inst writes,
+/// and Inst must not read or write what Branch writes (e.g. the link
+/// register).
+bool MipsAsmParser::canFillDelaySlot(const MCInst &Inst,
+                                     const MCInst &Branch) {
+  if (hasShortDelaySlot(Branch.getOpcode()))
+    return false;
+
+  SmallVector<unsigned, 4> InstDefs, InstUses, BranchDefs, BranchUses;
+  getDefsAndUses(Inst, InstDefs, InstUses);
+  getDefsAndUses(Branch, BranchDefs, BranchUses);
+
+  const MCRegisterInfo &MRI = *getContext().getRegisterInfo();
+  return !anyOverlap(MRI, InstDefs, BranchUses) &&
+         !anyOverlap(MRI, InstUses, BranchDefs) &&
+         !anyOverlap(MRI, InstDefs, BranchDefs);
+}
+
+bool MipsAsmParser::emitInstruction(MCInst &Inst, MCStreamer &Out,
+                                    unsigned int &ErrorCode,
+                                    uint64_t &Address) {
+  Inst.setAddress(Address);
+  Out.EmitInstruction(Inst, getSTI(), ErrorCode);
+  // Keystone: the code emitter moved the address past the instruction
+  Address = Inst.getAddress();
+  return ErrorCode != 0;
+}
+
+/// Emit the instructions of one statement. In .set reorder mode with delay
+/// slot filling on, the nop after a branch is replaced by the instruction
+/// before the branch when that is safe.
+bool MipsAsmParser::emitInstructions(SmallVectorImpl<MCInst> &Instructions,
+                                     MCStreamer &Out, unsigned int &ErrorCode,
+                                     uint64_t &Address) {
+  if (!MCOptions.MCFillDelaySlots || !AssemblerOptions.back()->isReorder()) {
+    for (MCInst &Inst : Instructions)
+      if (emitInstruction(Inst, Out, ErrorCode, Address))
+        return true;
+    return false;
+  }
+
+  for (unsigned i = 0, e = Instructions.size(); i != e; ++i) {
+    MCInst &Inst = Instructions[i];
+
+    if (HasPendingInst && getInstDesc(Inst.getOpcode()).hasDelaySlot() &&
+        i + 1 != e && isNop(Instructions[i + 1]) &&
+        canFillDelaySlot(PendingInst, Inst)) {
+      // The held back instruction already took its space: the branch goes
+      // there, and the instruction in place of the nop.
+      uint64_t InstAddress = PendingInst.getAddress();
+      HasPendingInst = false;
+      if (emitInstruction(Inst, Out, ErrorCode, InstAddress) ||
+          emitInstruction(PendingInst, Out, ErrorCode, InstAddress))
+        return true;
+      Address = InstAddress;
+      // drop the nop
+      ++i;
+      BytesSaved += getInstDesc(Instructions[i].getOpcode()).getSize();
+      continue;
+    }
+
+    if (flushPendingInstructions(Out, ErrorCode))
+      return true;
+
+    if (isDelaySlotCandidate(Inst)) {
+      PendingInst = Inst;
+      PendingInst.setAddress(Address);
+      HasPendingInst = true;
+      Address += getInstDesc(Inst.getOpcode()).getSize();
+      continue;
+    }
+
+    if (emitInstruction(Inst, Out, ErrorCode, Address))
+      return true;
+  }
+
+  return false;
+}
+
+bool MipsAsmParser::flushPendingInstructions(MCStreamer &Out,
+                                             unsigned int &ErrorCode) {
+  if (!HasPendingInst)
+    return false;
+
+  // Its space is already accounted for in the statement addresses.
+  uint64_t Address = PendingInst.getAddress();
+  HasPendingInst = false;
+  return emitInstruction(PendingInst, Out, ErrorCode, Address);
+}
+
 void MipsAsmParser::createAddu(unsigned DstReg, unsigned SrcReg,
                                unsigned TrgReg, bool Is64Bit,
                                SmallVectorImpl<MCInst> &Instructions) {
@@ -3747,13 +3937,7 @@ bool MipsAsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
   case Match_Success: {
     if (processInstruction(Inst, IDLoc, Instructions, ErrorCode))
       return true;
-    for (unsigned i = 0; i < Instructions.size(); i++)
-      Out.EmitInstruction(Instructions[i], getSTI(), ErrorCode);
-    if (ErrorCode == 0) {
-        Address = Inst.getAddress(); // Keystone update address
-        return false;
-    } else
-        return true;
+    return emitInstructions(Instructions, Out, ErrorCode, Address);
 
   }
   case Match_MissingFeature:
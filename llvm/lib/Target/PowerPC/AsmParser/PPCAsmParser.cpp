@@ -282,6 +282,10 @@ class PPCAsmParser : public MCTargetAsmParser {
 
   void ProcessInstruction(MCInst &Inst, const OperandVector &Ops);
 
+  bool emitLoadImm64(SMLoc IDLoc, const OperandVector &Operands,
+                     MCStreamer &Out, unsigned int &ErrorCode,
+                     uint64_t &Address);
+
   /// @name Auto-generated Match Functions
   /// {
 
@@ -446,6 +450,7 @@ public:
 
   bool isToken() const override { return Kind == Token; }
   bool isImm() const override { return Kind == Immediate || Kind == Expression; }
+  bool isExpr() const { return Kind == Expression; }
   bool isU1Imm() const { return Kind == Immediate && isUInt<1>(getImm()); }
   bool isU2Imm() const { return Kind == Immediate && isUInt<2>(getImm()); }
   bool isU3Imm() const { return Kind == Immediate && isUInt<3>(getImm()); }
@@ -1183,6 +1188,176 @@ void PPCAsmParser::ProcessInstruction(MCInst &Inst,
   }
 }
 
+static MCInst makeLoadImm(unsigned Opcode, unsigned Reg,
+                          const MCOperand &Imm) {
+  MCInst Inst;
+  Inst.setOpcode(Opcode);
+  Inst.addOperand(MCOperand::createReg(Reg));
+  Inst.addOperand(Imm);
+  return Inst;
+}
+
+static MCInst makeOrImm(unsigned Opcode, unsigned Reg, const MCOperand &Imm) {
+  MCInst Inst;
+  Inst.setOpcode(Opcode);
+  Inst.addOperand(MCOperand::createReg(Reg));
+  Inst.addOperand(MCOperand::createReg(Reg));
+  Inst.addOperand(Imm);
+  return Inst;
+}
+
+static MCInst makeRotate(unsigned Opcode, unsigned Reg, unsigned Sh,
+                         unsigned Mask) {
+  MCInst Inst;
+  Inst.setOpcode(Opcode);
+  Inst.addOperand(MCOperand::createReg(Reg));
+  Inst.addOperand(MCOperand::createReg(Reg));
+  Inst.addOperand(MCOperand::createImm(Sh));
+  Inst.addOperand(MCOperand::createImm(Mask));
+  return Inst;
+}
+
+/// Materialize \p Imm into \p Reg with li/lis, ori, sldi, oris and ori,
+/// without trying any rotation. This follows PPCISelDAGToDAG's getInt64Direct.
+static void buildLoadImm64Direct(SmallVectorImpl<MCInst> &Insts, unsigned Reg,
+                                 int64_t Imm) {
+  uint64_t Remainder = 0;
+  unsigned Shift = 0;
+
+  // A value that is not a sign-extended 32-bit one is either a 32-bit value
+  // shifted left, or needs its low word or'ed in after the high one.
+  if (!isInt<32>(Imm)) {
+    Shift = countTrailingZeros<uint64_t>(Imm);
+    int64_t ImmSh = static_cast<uint64_t>(Imm) >> Shift;
+    if (isInt<32>(ImmSh)) {
+      Imm = ImmSh;
+    } else {
+      Remainder = Imm;
+      Shift = 32;
+      Imm >>= 32;
+    }
+  }
+
+  unsigned Lo = Imm & 0xFFFF;
+  unsigned Hi = (Imm >> 16) & 0xFFFF;
+  if (isInt<16>(Imm)) {
+    Insts.push_back(makeLoadImm(PPC::LI8, Reg,
+                                MCOperand::createImm((int16_t)Lo)));
+  } else if (Lo) {
+    // li of a zero high half leaves the upper bits clear for ori.
+    if (Hi)
+      Insts.push_back(makeLoadImm(PPC::LIS8, Reg,
+                                  MCOperand::createImm((int16_t)Hi)));
+    else
+      Insts.push_back(makeLoadImm(PPC::LI8, Reg, MCOperand::createImm(0)));
+    Insts.push_back(makeOrImm(PPC::ORI8, Reg, MCOperand::createImm(Lo)));
+  } else {
+    Insts.push_back(makeLoadImm(PPC::LIS8, Reg,
+                                MCOperand::createImm((int16_t)Hi)));
+  }
+
+  if (!Shift)
+    return;
+
+  // sldi Reg, Reg, Shift
+  if (Imm)
+    Insts.push_back(makeRotate(PPC::RLDICR, Reg, Shift, 63 - Shift));
+
+  if ((Hi = (Remainder >> 16) & 0xFFFF))
+    Insts.push_back(makeOrImm(PPC::ORIS8, Reg, MCOperand::createImm(Hi)));
+  if ((Lo = Remainder & 0xFFFF))
+    Insts.push_back(makeOrImm(PPC::ORI8, Reg, MCOperand::createImm(Lo)));
+}
+
+/// Materialize \p Imm into \p Reg with the shortest sequence found: the
+/// direct one, a rotated value rotated back with rldicr (possibly masking
+/// off the ones that li/lis sign-extended in), or a value with its leading
+/// zeros set to ones cleared again with clrldi.
+static void buildLoadImm64(SmallVectorImpl<MCInst> &Insts, unsigned Reg,
+                           int64_t Imm) {
+  buildLoadImm64Direct(Insts, Reg, Imm);
+  if (Insts.size() == 1)
+    return;
+
+  SmallVector<MCInst, 5> Candidate;
+  auto tryCandidate = [&](uint64_t MatImm, const MCInst &Fixup) {
+    Candidate.clear();
+    buildLoadImm64Direct(Candidate, Reg, MatImm);
+    Candidate.push_back(Fixup);
+    if (Candidate.size() < Insts.size()) {
+      Insts.clear();
+      Insts.append(Candidate.begin(), Candidate.end());
+    }
+  };
+
+  uint64_t UImm = Imm;
+  for (unsigned R = 1; R < 63; ++R) {
+    uint64_t RImm = (UImm << R) | (UImm >> (64 - R));
+    tryCandidate(RImm, makeRotate(PPC::RLDICR, Reg, 64 - R, 63));
+
+    // Rotating back by 64-R moves the 63-LS high bits of RImm to the bottom,
+    // where rldicr can clear them, so those bits may as well be the ones
+    // li/lis sign-extend for free.
+    unsigned LS = findLastSet(RImm);
+    if (LS != R - 1)
+      continue;
+    uint64_t OnesMask = -(int64_t)(UINT64_C(1) << (LS + 1));
+    tryCandidate(RImm | OnesMask, makeRotate(PPC::RLDICR, Reg, 64 - R, LS));
+  }
+
+  unsigned LZ = countLeadingZeros(UImm);
+  if (LZ > 0 && LZ < 64)
+    tryCandidate(UImm | ~(~UINT64_C(0) >> LZ),
+                 makeRotate(PPC::RLDICL, Reg, 0, LZ));
+}
+
+/// li64 rD, value: load any 64-bit constant, or the address of a symbol,
+/// into rD. Symbols are only known at layout time, so they always take the
+/// five instruction form with @highest/@higher/@h/@l halves.
+bool PPCAsmParser::emitLoadImm64(SMLoc IDLoc, const OperandVector &Operands,
+                                 MCStreamer &Out, unsigned int &ErrorCode,
+                                 uint64_t &Address) {
+  PPCOperand &DstOp = (PPCOperand &)*Operands[1];
+  PPCOperand &ValOp = (PPCOperand &)*Operands[2];
+  if (!DstOp.isRegNumber() || !ValOp.isImm()) {
+    ErrorCode = KS_ERR_ASM_PPC_INVALIDOPERAND;
+    return true;
+  }
+  unsigned Reg = XRegs[DstOp.getReg()];
+
+  SmallVector<MCInst, 5> Insts;
+  if (ValOp.isExpr()) {
+    const MCExpr *Expr = ValOp.getExpr();
+    if (isa<PPCMCExpr>(Expr)) {
+      ErrorCode = KS_ERR_ASM_PPC_INVALIDOPERAND;
+      return true;
+    }
+    MCContext &Ctx = getContext();
+    auto half = [&](PPCMCExpr::VariantKind Kind) {
+      return MCOperand::createExpr(
+          PPCMCExpr::create(Kind, Expr, isDarwin(), Ctx));
+    };
+    Insts.push_back(makeLoadImm(PPC::LIS8, Reg,
+                                half(PPCMCExpr::VK_PPC_HIGHEST)));
+    Insts.push_back(makeOrImm(PPC::ORI8, Reg, half(PPCMCExpr::VK_PPC_HIGHER)));
+    Insts.push_back(makeRotate(PPC::RLDICR, Reg, 32, 31));
+    Insts.push_back(makeOrImm(PPC::ORIS8, Reg, half(PPCMCExpr::VK_PPC_HI)));
+    Insts.push_back(makeOrImm(PPC::ORI8, Reg, half(PPCMCExpr::VK_PPC_LO)));
+  } else {
+    buildLoadImm64(Insts, Reg, ValOp.getImm());
+  }
+
+  for (MCInst &Inst : Insts) {
+    Inst.setLoc(IDLoc);
+    Inst.setAddress(Address);
+    Out.EmitInstruction(Inst, getSTI(), ErrorCode);
+    if (ErrorCode)
+      return true;
+    Address = Inst.getAddress();
+  }
+  return false;
+}
+
 bool PPCAsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
                                            OperandVector &Operands,
                                            MCStreamer &Out, uint64_t &ErrorInfo,
@@ -1190,6 +1365,12 @@ bool PPCAsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
 {
   MCInst Inst(Address);
 
+  // li64 is a pseudo without a TableGen definition.
+  PPCOperand &MnemonicOp = (PPCOperand &)*Operands[0];
+  if (isPPC64() && Operands.size() == 3 && MnemonicOp.isToken() &&
+      MnemonicOp.getToken().equals_lower("li64"))
+    return emitLoadImm64(IDLoc, Operands, Out, ErrorCode, Address);
+
   switch (MatchInstructionImpl(Operands, Inst, ErrorInfo, MatchingInlineAsm)) {
   case Match_Success:
     // Post-process instructions (typically extended mnemonics)
@@ -46,6 +46,38 @@ static uint64_t adjustFixupValue(unsigned Kind, uint64_t Value) {
   }
 }
 
+/// Select the 16-bit half of a symbol's address named by its @l, @h, @ha,
+/// @higher, @highera, @highest or @highesta modifier. Returns false for
+/// any other modifier.
+static bool applyHalfModifier(MCSymbolRefExpr::VariantKind Kind,
+                              uint64_t &Value) {
+  switch (Kind) {
+  default:
+    return false;
+  case MCSymbolRefExpr::VK_PPC_LO:
+    Value &= 0xffff;
+    return true;
+  case MCSymbolRefExpr::VK_PPC_HI:
+    Value = (Value >> 16) & 0xffff;
+    return true;
+  case MCSymbolRefExpr::VK_PPC_HA:
+    Value = ((Value + 0x8000) >> 16) & 0xffff;
+    return true;
+  case MCSymbolRefExpr::VK_PPC_HIGHER:
+    Value = (Value >> 32) & 0xffff;
+    return true;
+  case MCSymbolRefExpr::VK_PPC_HIGHERA:
+    Value = ((Value + 0x8000) >> 32) & 0xffff;
+    return true;
+  case MCSymbolRefExpr::VK_PPC_HIGHEST:
+    Value = (Value >> 48) & 0xffff;
+    return true;
+  case MCSymbolRefExpr::VK_PPC_HIGHESTA:
+    Value = ((Value + 0x8000) >> 48) & 0xffff;
+    return true;
+  }
+}
+
 static unsigned getFixupKindNumBytes(unsigned Kind) {
   switch (Kind) {
   default:
@@ -136,6 +168,15 @@ public:
                          bool &IsResolved) override {
     switch ((PPC::Fixups)Fixup.getKind()) {
     default: break;
+    case PPC::fixup_ppc_half16:
+    case PPC::fixup_ppc_half16ds:
+      // PPCMCExpr leaves the half of a symbol's address to take as the
+      // modifier of the symbol reference. Keystone knows where the code
+      // will live, so resolve it here rather than through a relocation.
+      if (Target.getSymA() && !Target.getSymB() &&
+          applyHalfModifier(Target.getSymA()->getKind(), Value))
+        IsResolved = true;
+      break;
     case PPC::fixup_ppc_br24:
     case PPC::fixup_ppc_br24abs:
       // If the target symbol has a local entry point we must not attempt
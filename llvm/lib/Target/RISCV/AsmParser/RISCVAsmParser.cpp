@@ -15,6 +15,7 @@
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCExpr.h"
 #include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstBuilder.h"
 #include "llvm/MC/MCParser/MCAsmLexer.h"
 #include "llvm/MC/MCParser/MCParsedAsmOperand.h"
 #include "llvm/MC/MCParser/MCTargetAsmParser.h"
@@ -22,6 +23,7 @@
 #include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/Support/Casting.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/TargetRegistry.h"
 
 using namespace llvm_ks;
@@ -32,6 +34,7 @@ struct RISCVOperand;
 class RISCVAsmParser : public MCTargetAsmParser {
   SMLoc getLoc() const { return getParser().getTok().getLoc(); }
   bool isRV64() const { return getSTI().hasFeature(RISCV::Feature64Bit); }
+  bool hasStdExtC() const { return getSTI().hasFeature(RISCV::FeatureStdExtC); }
 
   unsigned validateTargetOperandClass(MCParsedAsmOperand &Op,
                                       unsigned Kind) override;
@@ -66,6 +69,25 @@ class RISCVAsmParser : public MCTargetAsmParser {
 
   bool parseOperand(OperandVector &Operands);
 
+  // Emit one instruction of an expansion, compressed if RVC allows it.
+  void emitToStreamer(MCStreamer &S, MCInst Inst, SMLoc IDLoc,
+                      unsigned int &ErrorCode);
+
+  // Emit the shortest sequence of lui/addi(w)/slli/srli that loads Value
+  // into DestReg.
+  void emitLoadImm(unsigned DestReg, int64_t Value, SMLoc IDLoc,
+                   MCStreamer &Out, unsigned int &ErrorCode);
+
+  // Emit auipc TmpReg, %pcrel_hi(Symbol) followed by SecondOpcode using the
+  // matching low 12 bits, for lla/la/call/tail.
+  void emitAuipcInstPair(unsigned DestReg, unsigned TmpReg,
+                         const MCExpr *Symbol, unsigned SecondOpcode,
+                         SMLoc IDLoc, MCStreamer &Out, unsigned int &ErrorCode);
+
+  // Expand pseudo instructions, then emit Inst.
+  void processInstruction(MCInst &Inst, SMLoc IDLoc, MCStreamer &Out,
+                          unsigned int &ErrorCode);
+
 public:
   enum RISCVMatchResultTy {
     Match_Dummy = FIRST_TARGET_MATCH_RESULT_TY,
@@ -297,6 +319,29 @@ public:
 
   bool isSImm9Lsb0() const { return isBareSimmNLsb0<9>(); }
 
+  bool isBareSymbol() const {
+    int64_t Imm;
+    RISCVMCExpr::VariantKind VK;
+    // Must be of 'immediate' type but not a constant.
+    if (!isImm() || evaluateConstantImm(Imm, VK))
+      return false;
+    return RISCVAsmParser::classifySymbolRef(getImm(), VK, Imm) &&
+           VK == RISCVMCExpr::VK_RISCV_None;
+  }
+
+  bool isImmXLenLI() const {
+    int64_t Imm;
+    RISCVMCExpr::VariantKind VK = RISCVMCExpr::VK_RISCV_None;
+    if (!isImm())
+      return false;
+    bool IsConstantImm = evaluateConstantImm(Imm, VK);
+    if (VK == RISCVMCExpr::VK_RISCV_LO)
+      return true;
+    // RV32 also takes unsigned 32-bit values, e.g. li a0, 0xffffffff.
+    return IsConstantImm && VK == RISCVMCExpr::VK_RISCV_None &&
+           (isRV64() || isInt<32>(Imm) || isUInt<32>(Imm));
+  }
+
   bool isUImm9Lsb000() const {
     int64_t Imm;
     RISCVMCExpr::VariantKind VK;
@@ -566,6 +611,421 @@ unsigned RISCVAsmParser::validateTargetOperandClass(MCParsedAsmOperand &AsmOp,
   return Match_InvalidOperand;
 }
 
+static bool isGPRC(unsigned Reg) {
+  return RISCVMCRegisterClasses[RISCV::GPRCRegClassID].contains(Reg);
+}
+
+// Check the offset of a branch or jump for its compressed form. Symbolic
+// targets are compressed too, the backend relaxes them back if needed.
+static bool isCompressibleOffset(const MCOperand &Op, unsigned Bits) {
+  if (Op.isExpr())
+    return true;
+  return Op.isImm() && isIntN(Bits, Op.getImm()) && (Op.getImm() & 1) == 0;
+}
+
+// Replace Inst with the 16-bit instruction Opcode taking Ops.
+static void setCompressed(MCInst &Inst, unsigned Opcode,
+                          ArrayRef<MCOperand> Ops) {
+  SmallVector<MCOperand, 3> NewOps(Ops.begin(), Ops.end());
+  Inst.clear();
+  Inst.setOpcode(Opcode);
+  for (const MCOperand &Op : NewOps)
+    Inst.addOperand(Op);
+}
+
+/// Rewrite Inst into its equivalent from the C extension, the way GNU as
+/// does when RVC is enabled. Only operands already known to fit are
+/// compressed, except for branch targets (see isCompressibleOffset).
+/// Returns true if Inst was changed.
+static bool compressInstruction(MCInst &Inst, bool IsRV64) {
+  unsigned Opcode = Inst.getOpcode();
+  unsigned NumOps = Inst.getNumOperands();
+  if (NumOps == 0) {
+    if (Opcode != RISCV::EBREAK)
+      return false;
+    Inst.setOpcode(RISCV::C_EBREAK);
+    return true;
+  }
+
+  const MCOperand &Last = Inst.getOperand(NumOps - 1);
+  bool HasImm = Last.isImm();
+  int64_t Imm = HasImm ? Last.getImm() : 0;
+  unsigned R0 = Inst.getOperand(0).isReg() ? Inst.getOperand(0).getReg() : 0;
+  unsigned R1 = NumOps > 1 && Inst.getOperand(1).isReg()
+                    ? Inst.getOperand(1).getReg() : 0;
+  unsigned R2 = NumOps > 2 && Inst.getOperand(2).isReg()
+                    ? Inst.getOperand(2).getReg() : 0;
+  MCOperand Rd = MCOperand::createReg(R0);
+
+  switch (Opcode) {
+  default:
+    return false;
+
+  case RISCV::ADDI:
+    if (!HasImm)
+      return false;
+    if (R0 == RISCV::X0 && R1 == RISCV::X0 && Imm == 0) {
+      setCompressed(Inst, RISCV::C_NOP, {});
+      return true;
+    }
+    if (R0 == RISCV::X0)
+      return false;
+    if (Imm == 0 && R1 != RISCV::X0) {
+      setCompressed(Inst, RISCV::C_MV, {Rd, MCOperand::createReg(R1)});
+      return true;
+    }
+    if (R1 == RISCV::X0 && isInt<6>(Imm)) {
+      setCompressed(Inst, RISCV::C_LI, {Rd, Last});
+      return true;
+    }
+    if (R0 == R1 && Imm != 0 && isInt<6>(Imm)) {
+      setCompressed(Inst, RISCV::C_ADDI, {Rd, Rd, Last});
+      return true;
+    }
+    if (R0 == RISCV::X2 && R1 == RISCV::X2 && Imm != 0 &&
+        isShiftedInt<6, 4>(Imm)) {
+      setCompressed(Inst, RISCV::C_ADDI16SP, {Rd, Rd, Last});
+      return true;
+    }
+    if (isGPRC(R0) && R1 == RISCV::X2 && Imm != 0 &&
+        isShiftedUInt<8, 2>(Imm)) {
+      Inst.setOpcode(RISCV::C_ADDI4SPN);
+      return true;
+    }
+    return false;
+
+  case RISCV::ADDIW:
+    if (!HasImm || R0 == RISCV::X0 || R0 != R1 || !isInt<6>(Imm))
+      return false;
+    setCompressed(Inst, RISCV::C_ADDIW, {Rd, Rd, Last});
+    return true;
+
+  case RISCV::LUI:
+    // c.lui sign-extends its 6-bit immediate into bits 17-12.
+    if (!HasImm || R0 == RISCV::X0 || R0 == RISCV::X2 || Imm == 0 ||
+        !(isUInt<5>(Imm) || (Imm >= 0xfffe0 && Imm <= 0xfffff)))
+      return false;
+    setCompressed(Inst, RISCV::C_LUI, {Rd, MCOperand::createImm(Imm & 0x3f)});
+    return true;
+
+  case RISCV::SLLI:
+    if (!HasImm || R0 == RISCV::X0 || R0 != R1 || Imm == 0)
+      return false;
+    setCompressed(Inst, RISCV::C_SLLI, {Rd, Rd, Last});
+    return true;
+
+  case RISCV::SRLI:
+  case RISCV::SRAI:
+    if (!HasImm || !isGPRC(R0) || R0 != R1 || Imm == 0)
+      return false;
+    setCompressed(Inst, Opcode == RISCV::SRLI ? RISCV::C_SRLI : RISCV::C_SRAI,
+                  {Rd, Rd, Last});
+    return true;
+
+  case RISCV::ANDI:
+    if (!HasImm || !isGPRC(R0) || R0 != R1 || !isInt<6>(Imm))
+      return false;
+    setCompressed(Inst, RISCV::C_ANDI, {Rd, Rd, Last});
+    return true;
+
+  case RISCV::ADD:
+    if (R0 == RISCV::X0)
+      return false;
+    if (R1 == RISCV::X0 && R2 != RISCV::X0) {
+      setCompressed(Inst, RISCV::C_MV, {Rd, MCOperand::createReg(R2)});
+      return true;
+    }
+    if (R2 == RISCV::X0 && R1 != RISCV::X0) {
+      setCompressed(Inst, RISCV::C_MV, {Rd, MCOperand::createReg(R1)});
+      return true;
+    }
+    if (R0 == R2)
+      std::swap(R1, R2);
+    if (R0 != R1 || R2 == RISCV::X0)
+      return false;
+    setCompressed(Inst, RISCV::C_ADD, {Rd, Rd, MCOperand::createReg(R2)});
+    return true;
+
+  case RISCV::SUB:
+  case RISCV::SUBW:
+  case RISCV::XOR:
+  case RISCV::OR:
+  case RISCV::AND:
+  case RISCV::ADDW: {
+    unsigned NewOpc;
+    switch (Opcode) {
+    default: llvm_unreachable("unexpected opcode");
+    case RISCV::SUB:  NewOpc = RISCV::C_SUB;  break;
+    case RISCV::SUBW: NewOpc = RISCV::C_SUBW; break;
+    case RISCV::XOR:  NewOpc = RISCV::C_XOR;  break;
+    case RISCV::OR:   NewOpc = RISCV::C_OR;   break;
+    case RISCV::AND:  NewOpc = RISCV::C_AND;  break;
+    case RISCV::ADDW: NewOpc = RISCV::C_ADDW; break;
+    }
+    if (R0 == R2 && Opcode != RISCV::SUB && Opcode != RISCV::SUBW)
+      std::swap(R1, R2);
+    if (!isGPRC(R0) || R0 != R1 || !isGPRC(R2))
+      return false;
+    setCompressed(Inst, NewOpc, {Rd, Rd, MCOperand::createReg(R2)});
+    return true;
+  }
+
+  case RISCV::JAL:
+    if (!isCompressibleOffset(Last, 12))
+      return false;
+    if (R0 == RISCV::X0) {
+      setCompressed(Inst, RISCV::C_J, {Last});
+      return true;
+    }
+    if (R0 == RISCV::X1 && !IsRV64) {
+      setCompressed(Inst, RISCV::C_JAL, {Last});
+      return true;
+    }
+    return false;
+
+  case RISCV::JALR:
+    if (!HasImm || Imm != 0 || R1 == RISCV::X0 ||
+        (R0 != RISCV::X0 && R0 != RISCV::X1))
+      return false;
+    setCompressed(Inst, R0 == RISCV::X0 ? RISCV::C_JR : RISCV::C_JALR,
+                  {MCOperand::createReg(R1)});
+    return true;
+
+  case RISCV::BEQ:
+  case RISCV::BNE:
+    if (R0 == RISCV::X0)
+      std::swap(R0, R1);
+    if (!isGPRC(R0) || R1 != RISCV::X0 || !isCompressibleOffset(Last, 9))
+      return false;
+    setCompressed(Inst, Opcode == RISCV::BEQ ? RISCV::C_BEQZ : RISCV::C_BNEZ,
+                  {MCOperand::createReg(R0), Last});
+    return true;
+
+  // Loads and stores keep their operands, only the opcode changes.
+  case RISCV::LW:
+  case RISCV::SW:
+  case RISCV::FLW:
+  case RISCV::FSW: {
+    if (!HasImm)
+      return false;
+    bool IsLoad = Opcode == RISCV::LW || Opcode == RISCV::FLW;
+    bool IsFP = Opcode == RISCV::FLW || Opcode == RISCV::FSW;
+    if (IsFP && IsRV64)
+      return false;
+    if (R1 == RISCV::X2 && isShiftedUInt<6, 2>(Imm) &&
+        !(Opcode == RISCV::LW && R0 == RISCV::X0)) {
+      Inst.setOpcode(IsFP ? (IsLoad ? RISCV::C_FLWSP : RISCV::C_FSWSP)
+                          : (IsLoad ? RISCV::C_LWSP : RISCV::C_SWSP));
+      return true;
+    }
+    bool RegC = IsFP ? RISCVMCRegisterClasses[RISCV::FPR32CRegClassID]
+                           .contains(R0)
+                     : isGPRC(R0);
+    if (!RegC || !isGPRC(R1) || !isShiftedUInt<5, 2>(Imm))
+      return false;
+    Inst.setOpcode(IsFP ? (IsLoad ? RISCV::C_FLW : RISCV::C_FSW)
+                        : (IsLoad ? RISCV::C_LW : RISCV::C_SW));
+    return true;
+  }
+
+  case RISCV::LD:
+  case RISCV::SD:
+  case RISCV::FLD:
+  case RISCV::FSD: {
+    if (!HasImm)
+      return false;
+    bool IsLoad = Opcode == RISCV::LD || Opcode == RISCV::FLD;
+    bool IsFP = Opcode == RISCV::FLD || Opcode == RISCV::FSD;
+    if (R1 == RISCV::X2 && isShiftedUInt<6, 3>(Imm) &&
+        !(Opcode == RISCV::LD && R0 == RISCV::X0)) {
+      Inst.setOpcode(IsFP ? (IsLoad ? RISCV::C_FLDSP : RISCV::C_FSDSP)
+                          : (IsLoad ? RISCV::C_LDSP : RISCV::C_SDSP));
+      return true;
+    }
+    bool RegC = IsFP ? RISCVMCRegisterClasses[RISCV::FPR64CRegClassID]
+                           .contains(R0)
+                     : isGPRC(R0);
+    if (!RegC || !isGPRC(R1) || !isShiftedUInt<5, 3>(Imm))
+      return false;
+    Inst.setOpcode(IsFP ? (IsLoad ? RISCV::C_FLD : RISCV::C_FSD)
+                        : (IsLoad ? RISCV::C_LD : RISCV::C_SD));
+    return true;
+  }
+  }
+}
+
+typedef SmallVector<std::pair<unsigned, int64_t>, 8> LoadImmSeq;
+
+// Build the lui/addi(w)/slli sequence for Val: 32-bit values take lui and
+// addi(w), wider ones are built from their upper bits, shifted into place
+// past any trailing zeros, plus the low 12 bits.
+static void generateLoadImmSeq(int64_t Val, bool IsRV64, LoadImmSeq &Res) {
+  if (isInt<32>(Val)) {
+    // Add 1 if bit 11 is 1, to compensate for the low 12 bits being negative.
+    int64_t Hi20 = ((Val + 0x800) >> 12) & 0xfffff;
+    int64_t Lo12 = SignExtend64<12>(Val);
+    if (Hi20)
+      Res.push_back(std::make_pair((unsigned)RISCV::LUI, Hi20));
+    // On RV64, addiw keeps the 32-bit wrap-around of lui + addi.
+    if (Lo12 || Hi20 == 0)
+      Res.push_back(std::make_pair(
+          (unsigned)(IsRV64 && Hi20 ? RISCV::ADDIW : RISCV::ADDI), Lo12));
+    return;
+  }
+
+  assert(IsRV64 && "Can't emit >32-bit imm for non-RV64 target");
+  int64_t Lo12 = SignExtend64<12>(Val);
+  int64_t Hi52 = ((uint64_t)Val + 0x800ull) >> 12;
+  int ShiftAmount = 12 + countTrailingZeros((uint64_t)Hi52);
+  Hi52 = SignExtend64(Hi52 >> (ShiftAmount - 12), 64 - ShiftAmount);
+
+  // If the remaining bits don't fit in 12 bits, let lui provide 12 of the
+  // zeros instead of the shift.
+  if (ShiftAmount > 12 && !isInt<12>(Hi52) && isInt<32>((uint64_t)Hi52 << 12)) {
+    ShiftAmount -= 12;
+    Hi52 = (uint64_t)Hi52 << 12;
+  }
+
+  generateLoadImmSeq(Hi52, IsRV64, Res);
+  Res.push_back(std::make_pair((unsigned)RISCV::SLLI, (int64_t)ShiftAmount));
+  if (Lo12)
+    Res.push_back(std::make_pair((unsigned)RISCV::ADDI, Lo12));
+}
+
+static void getLoadImmSeq(int64_t Val, bool IsRV64, LoadImmSeq &Res) {
+  generateLoadImmSeq(Val, IsRV64, Res);
+
+  // A positive constant can also be built with its leading zeros shifted
+  // out and a final srli, the vacated low bits filled with ones (masks such
+  // as 0xffffffff become addi -1; srli 32) or with zeros.
+  if (!IsRV64 || Val <= 0 || Res.size() <= 2)
+    return;
+  unsigned LeadingZeros = countLeadingZeros((uint64_t)Val);
+  uint64_t ShiftedVal = (uint64_t)Val << LeadingZeros;
+  uint64_t Fills[] = {(1ULL << LeadingZeros) - 1, 0};
+  for (uint64_t Fill : Fills) {
+    LoadImmSeq TmpSeq;
+    generateLoadImmSeq(ShiftedVal | Fill, IsRV64, TmpSeq);
+    TmpSeq.push_back(
+        std::make_pair((unsigned)RISCV::SRLI, (int64_t)LeadingZeros));
+    if (TmpSeq.size() < Res.size())
+      Res = TmpSeq;
+  }
+}
+
+void RISCVAsmParser::emitToStreamer(MCStreamer &S, MCInst Inst, SMLoc IDLoc,
+                                    unsigned int &ErrorCode) {
+  // Fixed-width mode wants sizes that do not depend on operand values.
+  if (hasStdExtC() && !MCOptions.MCFixedWidth)
+    compressInstruction(Inst, isRV64());
+  Inst.setLoc(IDLoc);
+  S.EmitInstruction(Inst, getSTI(), ErrorCode);
+}
+
+void RISCVAsmParser::emitLoadImm(unsigned DestReg, int64_t Value,
+                                 SMLoc IDLoc, MCStreamer &Out,
+                                 unsigned int &ErrorCode) {
+  LoadImmSeq Seq;
+  getLoadImmSeq(Value, isRV64(), Seq);
+
+  unsigned SrcReg = RISCV::X0;
+  for (auto &I : Seq) {
+    if (ErrorCode)
+      return;
+    if (I.first == RISCV::LUI)
+      emitToStreamer(Out,
+                     MCInstBuilder(RISCV::LUI).addReg(DestReg).addImm(I.second),
+                     IDLoc, ErrorCode);
+    else
+      emitToStreamer(Out,
+                     MCInstBuilder(I.first)
+                         .addReg(DestReg)
+                         .addReg(SrcReg)
+                         .addImm(I.second),
+                     IDLoc, ErrorCode);
+    SrcReg = DestReg;
+  }
+}
+
+void RISCVAsmParser::emitAuipcInstPair(unsigned DestReg, unsigned TmpReg,
+                                       const MCExpr *Symbol,
+                                       unsigned SecondOpcode, SMLoc IDLoc,
+                                       MCStreamer &Out,
+                                       unsigned int &ErrorCode) {
+  // The low part is relative to the auipc, so take it from the distance
+  // between Symbol and a label on the auipc:
+  //   .Ltmp: auipc tmp, %pcrel_hi(symbol)
+  //          op    dst, tmp, %lo(symbol - .Ltmp)
+  // Both resolve once the layout is known.
+  MCContext &Ctx = getContext();
+  MCSymbol *TmpLabel = Ctx.createTempSymbol();
+  Out.EmitLabel(TmpLabel);
+
+  emitToStreamer(Out,
+                 MCInstBuilder(RISCV::AUIPC)
+                     .addReg(TmpReg)
+                     .addExpr(RISCVMCExpr::create(
+                         Symbol, RISCVMCExpr::VK_RISCV_PCREL_HI, Ctx)),
+                 IDLoc, ErrorCode);
+  if (ErrorCode)
+    return;
+
+  const MCExpr *Lo = RISCVMCExpr::create(
+      MCBinaryExpr::createSub(Symbol, MCSymbolRefExpr::create(TmpLabel, Ctx),
+                              Ctx),
+      RISCVMCExpr::VK_RISCV_LO, Ctx);
+  emitToStreamer(
+      Out,
+      MCInstBuilder(SecondOpcode).addReg(DestReg).addReg(TmpReg).addExpr(Lo),
+      IDLoc, ErrorCode);
+}
+
+void RISCVAsmParser::processInstruction(MCInst &Inst, SMLoc IDLoc,
+                                        MCStreamer &Out,
+                                        unsigned int &ErrorCode) {
+  switch (Inst.getOpcode()) {
+  default:
+    break;
+  case RISCV::PseudoLI: {
+    unsigned Reg = Inst.getOperand(0).getReg();
+    const MCOperand &Op1 = Inst.getOperand(1);
+    if (Op1.isExpr()) {
+      // li reg, %lo(sym) is a plain addi.
+      emitToStreamer(Out,
+                     MCInstBuilder(RISCV::ADDI)
+                         .addReg(Reg)
+                         .addReg(RISCV::X0)
+                         .addExpr(Op1.getExpr()),
+                     IDLoc, ErrorCode);
+      return;
+    }
+    int64_t Imm = Op1.getImm();
+    // On RV32 the immediate is taken as a 32-bit value.
+    if (!isRV64())
+      Imm = SignExtend64<32>(Imm);
+    emitLoadImm(Reg, Imm, IDLoc, Out, ErrorCode);
+    return;
+  }
+  case RISCV::PseudoLLA:
+  case RISCV::PseudoLA: {
+    unsigned Reg = Inst.getOperand(0).getReg();
+    emitAuipcInstPair(Reg, Reg, Inst.getOperand(1).getExpr(), RISCV::ADDI,
+                      IDLoc, Out, ErrorCode);
+    return;
+  }
+  case RISCV::PseudoCALL:
+    emitAuipcInstPair(RISCV::X1, RISCV::X1, Inst.getOperand(0).getExpr(),
+                      RISCV::JALR, IDLoc, Out, ErrorCode);
+    return;
+  case RISCV::PseudoTAIL:
+    emitAuipcInstPair(RISCV::X0, RISCV::X6, Inst.getOperand(0).getExpr(),
+                      RISCV::JALR, IDLoc, Out, ErrorCode);
+    return;
+  }
+
+  emitToStreamer(Out, Inst, IDLoc, ErrorCode);
+}
+
 bool RISCVAsmParser::generateImmOutOfRangeError(
     OperandVector &Operands, uint64_t ErrorInfo, int Lower, int Upper,
     Twine Msg = "immediate must be an integer in the range") {
@@ -586,9 +1046,8 @@ bool RISCVAsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
   default:
     break;
   case Match_Success:
-    Inst.setLoc(IDLoc);
-    Out.EmitInstruction(Inst, getSTI(), ErrorCode);
-    return false;
+    processInstruction(Inst, IDLoc, Out, ErrorCode);
+    return ErrorCode != 0;
   case Match_MissingFeature:
     return Error(IDLoc, "instruction use requires an option to be enabled");
   case Match_MnemonicFail:
@@ -667,6 +1126,18 @@ bool RISCVAsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
     return generateImmOutOfRangeError(
         Operands, ErrorInfo, -(1 << 20), (1 << 20) - 2,
         "immediate must be a multiple of 2 bytes in the range");
+  case Match_InvalidBareSymbol: {
+    SMLoc ErrorLoc = ((RISCVOperand &)*Operands[ErrorInfo]).getStartLoc();
+    return Error(ErrorLoc, "operand must be a bare symbol name");
+  }
+  case Match_InvalidImmXLenLI:
+    if (isRV64()) {
+      SMLoc ErrorLoc = ((RISCVOperand &)*Operands[ErrorInfo]).getStartLoc();
+      return Error(ErrorLoc, "operand must be a constant 64-bit integer");
+    }
+    return generateImmOutOfRangeError(Operands, ErrorInfo,
+                                      std::numeric_limits<int32_t>::min(),
+                                      std::numeric_limits<uint32_t>::max());
   case Match_InvalidFenceArg: {
     SMLoc ErrorLoc = ((RISCVOperand &)*Operands[ErrorInfo]).getStartLoc();
     return Error(
@@ -17,6 +17,7 @@
 #include "llvm/MC/MCELFObjectWriter.h"
 #include "llvm/MC/MCExpr.h"
 #include "llvm/MC/MCFixupKindInfo.h"
+#include "llvm/MC/MCInst.h"
 #include "llvm/MC/MCObjectWriter.h"
 #include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/MC/MCSymbol.h"
@@ -44,9 +45,7 @@ public:
   bool fixupNeedsRelaxation(const MCFixup &Fixup, uint64_t Value,
                             const MCRelaxableFragment *DF,
                             const MCAsmLayout &Layout,
-                            unsigned &KsError) const override {
-    return false;
-  }
+                            unsigned &KsError) const override;
 
   unsigned getNumFixupKinds() const override {
     return RISCV::NumTargetFixupKinds;
@@ -76,22 +75,82 @@ public:
     return Infos[Kind - FirstTargetFixupKind];
   }
 
-  bool mayNeedRelaxation(const MCInst &Inst) const override { return false; }
-
-  void relaxInstruction(const MCInst &Inst, MCInst &Res) const override {
+  bool mayNeedRelaxation(const MCInst &Inst) const override;
 
-    llvm_unreachable("RISCVAsmBackend::relaxInstruction() unimplemented");
-  }
+  void relaxInstruction(const MCInst &Inst, MCInst &Res) const override;
 
   bool writeNopData(uint64_t Count, MCObjectWriter *OW) const override;
 };
 
+// Compressed branches and jumps, which the asm parser also produces from
+// their 32-bit forms when RVC is enabled, are relaxed back once their target
+// turns out to be out of range.
+bool RISCVAsmBackend::mayNeedRelaxation(const MCInst &Inst) const {
+  switch (Inst.getOpcode()) {
+  default:
+    return false;
+  case RISCV::C_BEQZ:
+  case RISCV::C_BNEZ:
+  case RISCV::C_J:
+  case RISCV::C_JAL:
+    return true;
+  }
+}
+
+bool RISCVAsmBackend::fixupNeedsRelaxation(const MCFixup &Fixup,
+                                           uint64_t Value,
+                                           const MCRelaxableFragment *DF,
+                                           const MCAsmLayout &Layout,
+                                           unsigned &KsError) const {
+  int64_t Offset = int64_t(Value);
+  switch ((unsigned)Fixup.getKind()) {
+  default:
+    return false;
+  case RISCV::fixup_riscv_rvc_branch:
+    return !isInt<9>(Offset);
+  case RISCV::fixup_riscv_rvc_jump:
+    return !isInt<12>(Offset);
+  }
+}
+
+void RISCVAsmBackend::relaxInstruction(const MCInst &Inst, MCInst &Res) const {
+  // Inst and Res may be the same object.
+  MCOperand Target = Inst.getOperand(Inst.getNumOperands() - 1);
+  unsigned Opcode = Inst.getOpcode();
+  unsigned Reg = Inst.getOperand(0).isReg() ? Inst.getOperand(0).getReg() : 0;
+
+  Res = Inst;
+  Res.clear();
+  switch (Opcode) {
+  default:
+    report_fatal_error("unexpected instruction to relax");
+  case RISCV::C_BEQZ:
+  case RISCV::C_BNEZ:
+    Res.setOpcode(Opcode == RISCV::C_BEQZ ? RISCV::BEQ : RISCV::BNE);
+    Res.addOperand(MCOperand::createReg(Reg));
+    Res.addOperand(MCOperand::createReg(RISCV::X0));
+    break;
+  case RISCV::C_J:
+  case RISCV::C_JAL:
+    Res.setOpcode(RISCV::JAL);
+    Res.addOperand(MCOperand::createReg(Opcode == RISCV::C_J ? RISCV::X0
+                                                             : RISCV::X1));
+    break;
+  }
+  Res.addOperand(Target);
+}
+
 bool RISCVAsmBackend::writeNopData(uint64_t Count, MCObjectWriter *OW) const {
-  // Once support for the compressed instruction set is added, we will be able
-  // to conditionally support 16-bit NOPs
-  if ((Count % 4) != 0)
+  if ((Count % 2) != 0)
     return false;
 
+  // Padding by an odd number of halfwords only happens after compressed
+  // code, so c.nop is available there.
+  if ((Count % 4) != 0) {
+    OW->write16(0x0001);
+    Count -= 2;
+  }
+
   // The canonical nop on RISC-V is addi x0, x0, 0
   for (uint64_t i = 0; i < Count; i += 4)
     OW->write32(0x13);
@@ -243,11 +243,24 @@ public:
   bool isMem(MemoryKind MemKind, RegisterKind RegKind) const {
     return isMem(MemKind) && Mem.RegKind == RegKind;
   }
+  // The displacement of a D(B), D(X,B) or D(L,B) operand may also be
+  // symbolic, in which case a fixup supplies it at layout time.
+  bool hasSymbolicDisp(MemoryKind MemKind) const {
+    return (MemKind == BDMem || MemKind == BDXMem || MemKind == BDLMem) &&
+           Mem.Disp &&
+           !isa<MCConstantExpr>(Mem.Disp);
+  }
   bool isMemDisp12(MemoryKind MemKind, RegisterKind RegKind) const {
-    return isMem(MemKind, RegKind) && inRange(Mem.Disp, 0, 0xfff);
+    return isMem(MemKind, RegKind) &&
+           (inRange(Mem.Disp, 0, 0xfff) || hasSymbolicDisp(MemKind));
   }
   bool isMemDisp20(MemoryKind MemKind, RegisterKind RegKind) const {
-    return isMem(MemKind, RegKind) && inRange(Mem.Disp, -524288, 524287);
+    return isMem(MemKind, RegKind) &&
+           (inRange(Mem.Disp, -524288, 524287) || hasSymbolicDisp(MemKind));
+  }
+  const MCExpr *getMemDisp() const {
+    assert(Kind == KindMem && "Not a memory operand");
+    return Mem.Disp;
   }
   bool isMemDisp12Len8(RegisterKind RegKind) const {
     return isMemDisp12(BDLMem, RegKind) && inRange(Mem.Length, 1, 0x100);
@@ -386,6 +399,13 @@ private:
 
   bool parseOperand(OperandVector &Operands, StringRef Mnemonic, unsigned int &ErrorCode);
 
+  unsigned matchDisp20Form(OperandVector &Operands, MCInst &Inst,
+                           uint64_t &ErrorInfo, bool MatchingInlineAsm);
+  void selectDispForm(MCInst &Inst, const OperandVector &Operands);
+
+  // Bytes saved by choosing short-displacement forms (MCOptimizeSize).
+  uint64_t BytesSaved = 0;
+
 public:
   SystemZAsmParser(const MCSubtargetInfo &sti, MCAsmParser &parser,
                    const MCInstrInfo &MII,
@@ -406,6 +426,7 @@ public:
                                OperandVector &Operands, MCStreamer &Out,
                                uint64_t &ErrorInfo,
                                bool MatchingInlineAsm, unsigned int &ErrorCode, uint64_t &Address) override;
+  uint64_t getBytesSaved() const override { return BytesSaved; }
 
   // Used by the TableGen code to parse particular operand types.
   OperandMatchResultTy parseGR32(OperandVector &Operands, unsigned int &ErrorCode) {
@@ -809,6 +830,67 @@ bool SystemZAsmParser::parseOperand(OperandVector &Operands,
   return false;
 }
 
+// The displacement of a short-displacement mnemonic such as "l" may not
+// fit in 12 bits: match its long-displacement twin ("ly") instead.
+unsigned SystemZAsmParser::matchDisp20Form(OperandVector &Operands,
+                                           MCInst &Inst, uint64_t &ErrorInfo,
+                                           bool MatchingInlineAsm) {
+  SystemZOperand &MnemonicOp = static_cast<SystemZOperand &>(*Operands[0]);
+  if (!MnemonicOp.isToken())
+    return Match_InvalidOperand;
+
+  std::string LongName = MnemonicOp.getToken().str() + "y";
+  std::unique_ptr<MCParsedAsmOperand> ShortOp = std::move(Operands[0]);
+  Operands[0] = SystemZOperand::createToken(LongName, ShortOp->getStartLoc());
+
+  MCInst LongInst(Inst.getAddress());
+  uint64_t LongErrorInfo;
+  unsigned MatchResult = MatchInstructionImpl(Operands, LongInst,
+                                              LongErrorInfo,
+                                              MatchingInlineAsm);
+  Operands[0] = std::move(ShortOp);
+
+  if (MatchResult != Match_Success ||
+      SystemZ::getDisp12Opcode(LongInst.getOpcode()) < 0)
+    return Match_InvalidOperand;
+  Inst = LongInst;
+  ErrorInfo = LongErrorInfo;
+  return Match_Success;
+}
+
+// Pick between the short and long displacement forms of Inst.  A symbolic
+// displacement starts out short and is widened by relaxation if it does
+// not fit; with MCOptimizeSize an explicit long form whose displacement
+// fits is shortened as well.
+void SystemZAsmParser::selectDispForm(MCInst &Inst,
+                                      const OperandVector &Operands) {
+  if (MCOptions.MCFixedWidth)
+    return;
+
+  int ShortOpcode = SystemZ::getDisp12Opcode(Inst.getOpcode());
+  bool IsShort = SystemZ::getDisp20Opcode(Inst.getOpcode()) >= 0;
+  if (!IsShort && (ShortOpcode < 0 || !MCOptions.MCOptimizeSize))
+    return;
+
+  const MCExpr *Disp = nullptr;
+  for (unsigned I = 1, E = Operands.size(); I != E; ++I) {
+    SystemZOperand &Op = static_cast<SystemZOperand &>(*Operands[I]);
+    if (Op.isMem()) {
+      Disp = Op.getMemDisp();
+      break;
+    }
+  }
+
+  if (Disp && !isa<MCConstantExpr>(Disp)) {
+    if (!IsShort)
+      Inst.setOpcode(ShortOpcode);
+    Inst.setFlags(Inst.getFlags() | SystemZ::IP_RELAX_DISP);
+  } else if (!IsShort && (!Disp || inRange(Disp, 0, 0xfff))) {
+    Inst.setOpcode(ShortOpcode);
+    BytesSaved += 2;
+  }
+}
+
 bool SystemZAsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
                                                OperandVector &Operands,
                                                MCStreamer &Out,
@@ -820,8 +902,13 @@ bool SystemZAsmParser::MatchAndEmitInstruction(SMLoc IDLoc, unsigned &Opcode,
 
   MatchResult = MatchInstructionImpl(Operands, Inst, ErrorInfo,
                                      MatchingInlineAsm);
+  if (MatchResult == Match_InvalidOperand && !MCOptions.MCFixedWidth &&
+      matchDisp20Form(Operands, Inst, ErrorInfo,
+                      MatchingInlineAsm) == Match_Success)
+    MatchResult = Match_Success;
   switch (MatchResult) {
   case Match_Success:
+    selectDispForm(Inst, Operands);
     Inst.setLoc(IDLoc);
     Out.EmitInstruction(Inst, getSTI(), ErrorCode);
     if (ErrorCode == 0) {
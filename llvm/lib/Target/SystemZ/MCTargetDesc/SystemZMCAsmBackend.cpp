@@ -33,6 +33,13 @@ static uint64_t extractBitsForFixup(MCFixupKind Kind, uint64_t Value) {
 
   case SystemZ::FK_390_TLS_CALL:
     return 0;
+
+  case SystemZ::FK_390_12:
+    return Value & 0xfff;
+
+  // The low 12 bits of a 20-bit displacement come before the high 8.
+  case SystemZ::FK_390_20:
+    return ((Value & 0xfff) << 8) | ((Value >> 12) & 0xff);
   }
 
   llvm_unreachable("Unknown fixup kind!");
@@ -53,17 +60,20 @@ public:
   void applyFixup(const MCAssembler &Asm, const MCFixup &Fixup,
                   const MCValue &Target, MutableArrayRef<char> Data,
                   uint64_t Value, bool IsPCRel, unsigned int &KsError) const override;
+  void processFixupValue(const MCAssembler &Asm, const MCAsmLayout &Layout,
+                         const MCFixup &Fixup, const MCFragment *DF,
+                         const MCValue &Target, uint64_t &Value,
+                         bool &IsResolved) override;
   bool mayNeedRelaxation(const MCInst &Inst) const override {
-    return false;
+    return Inst.getFlags() & SystemZ::IP_RELAX_DISP;
   }
   bool fixupNeedsRelaxation(const MCFixup &Fixup, uint64_t Value,
                             const MCRelaxableFragment *Fragment,
                             const MCAsmLayout &Layout, unsigned &KsError) const override {
-    return false;
-  }
-  void relaxInstruction(const MCInst &Inst, MCInst &Res) const override {
-    llvm_unreachable("SystemZ does do not have assembler relaxation");
+    return (unsigned)Fixup.getKind() == SystemZ::FK_390_12 &&
+           !isUInt<12>(Value);
   }
+  void relaxInstruction(const MCInst &Inst, MCInst &Res) const override;
   bool writeNopData(uint64_t Count, MCObjectWriter *OW) const override;
   MCObjectWriter *createObjectWriter(raw_pwrite_stream &OS) const override {
     return createSystemZObjectWriter(OS, OSABI);
@@ -76,7 +86,9 @@ SystemZMCAsmBackend::getFixupKindInfo(MCFixupKind Kind) const {
   const static MCFixupKindInfo Infos[SystemZ::NumTargetFixupKinds] = {
     { "FK_390_PC16DBL",  0, 16, MCFixupKindInfo::FKF_IsPCRel },
     { "FK_390_PC32DBL",  0, 32, MCFixupKindInfo::FKF_IsPCRel },
-    { "FK_390_TLS_CALL", 0, 0, 0 }
+    { "FK_390_TLS_CALL", 0, 0, 0 },
+    { "FK_390_12",       4, 12, 0 },
+    { "FK_390_20",       4, 20, 0 }
   };
 
   if (Kind < FirstTargetFixupKind)
@@ -100,6 +112,12 @@ void SystemZMCAsmBackend::applyFixup(const MCAssembler &Asm, const MCFixup &Fixu
       return;
   }
 
+  if ((Kind == (MCFixupKind)SystemZ::FK_390_12 && !isUInt<12>(Value)) ||
+      (Kind == (MCFixupKind)SystemZ::FK_390_20 && !isInt<20>(Value))) {
+      KsError = KS_ERR_ASM_FIXUP_INVALID;
+      return;
+  }
+
   // Big-endian insertion of Size bytes.
   Value = extractBitsForFixup(Kind, Value);
   unsigned ShiftValue = (Size * 8) - 8;
@@ -109,6 +127,29 @@ void SystemZMCAsmBackend::applyFixup(const MCAssembler &Asm, const MCFixup &Fixu
   }
 }
 
+void SystemZMCAsmBackend::processFixupValue(const MCAssembler &Asm,
+                                            const MCAsmLayout &Layout,
+                                            const MCFixup &Fixup,
+                                            const MCFragment *DF,
+                                            const MCValue &Target,
+                                            uint64_t &Value, bool &IsResolved) {
+  // Displacements have no relocation type; take the value computed from
+  // the layout.
+  switch ((unsigned)Fixup.getKind()) {
+  case SystemZ::FK_390_12:
+  case SystemZ::FK_390_20:
+    IsResolved = true;
+    break;
+  }
+}
+
+void SystemZMCAsmBackend::relaxInstruction(const MCInst &Inst,
+                                           MCInst &Res) const {
+  Res = Inst;
+  Res.setOpcode(SystemZ::getDisp20Opcode(Inst.getOpcode()));
+  Res.setFlags(Inst.getFlags() & ~SystemZ::IP_RELAX_DISP);
+}
+
 bool SystemZMCAsmBackend::writeNopData(uint64_t Count,
                                        MCObjectWriter *OW) const {
   for (uint64_t I = 0; I != Count; ++I)
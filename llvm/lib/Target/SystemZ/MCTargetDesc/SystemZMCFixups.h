@@ -20,6 +20,11 @@ enum FixupKind {
   FK_390_PC32DBL,
   FK_390_TLS_CALL,
 
+  // Symbolic 12-bit unsigned and 20-bit signed displacements.  These are
+  // always resolved at layout time.
+  FK_390_12,
+  FK_390_20,
+
   // Marker
   LastTargetFixupKind,
   NumTargetFixupKinds = LastTargetFixupKind - FirstTargetFixupKind
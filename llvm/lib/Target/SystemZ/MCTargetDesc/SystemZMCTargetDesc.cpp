@@ -21,6 +21,9 @@ using namespace llvm_ks;
 #define GET_INSTRINFO_MC_DESC
 #include "SystemZGenInstrInfo.inc"
 
+#define GET_INSTRMAP_INFO
+#include "SystemZGenInstrInfo.inc"
+
 #define GET_SUBTARGETINFO_MC_DESC
 #include "SystemZGenSubtargetInfo.inc"
 
@@ -79,6 +79,20 @@ inline unsigned getRegAsVR128(unsigned Reg) {
 }
 } // end namespace SystemZMC
 
+namespace SystemZ {
+// Flags on an MCInst.
+enum {
+  // A short-displacement instruction whose symbolic displacement may be
+  // widened to the long-displacement form during relaxation.
+  IP_RELAX_DISP = 1U << 0
+};
+
+// Return the form of Opcode with a 12-bit unsigned or a 20-bit signed
+// displacement, or -1 if there is none.
+int getDisp12Opcode(uint16_t Opcode);
+int getDisp20Opcode(uint16_t Opcode);
+} // end namespace SystemZ
+
 MCCodeEmitter *createSystemZMCCodeEmitter(const MCInstrInfo &MCII,
                                           const MCRegisterInfo &MRI,
                                           MCContext &Ctx);
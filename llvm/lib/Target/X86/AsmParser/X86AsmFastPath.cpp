@@ -0,0 +1,524 @@
+//===- X86AsmFastPath.cpp - Direct encoding of common x86 forms -----------===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+//
+// Most statements a JIT feeds us are plain moves, arithmetic, compares and
+// stack operations on general purpose registers. Going through the Intel
+// expression parser, the matcher and the code emitter for each of them is
+// most of the assembly time, so recognize these forms from their tokens and
+// build REX, opcode, ModRM, SIB, displacement and immediate directly.
+// Anything else, including every operand that involves a symbol, is left to
+// the regular path.
+//
+//===----------------------------------------------------------------------===//
+
+#include "X86AsmFastPath.h"
+#include "llvm/MC/MCParser/MCAsmLexer.h"
+#include "llvm/Support/MathExtras.h"
+
+using namespace llvm_ks;
+
+namespace {
+
+struct FastRegister {
+  const char *Name;
+  uint8_t Num;    // hardware encoding
+  uint8_t Size;   // in bits
+};
+
+const FastRegister Registers[] = {
+  {"eax", 0, 32}, {"ecx", 1, 32}, {"edx", 2, 32}, {"ebx", 3, 32},
+  {"esp", 4, 32}, {"ebp", 5, 32}, {"esi", 6, 32}, {"edi", 7, 32},
+  {"r8d", 8, 32}, {"r9d", 9, 32}, {"r10d", 10, 32}, {"r11d", 11, 32},
+  {"r12d", 12, 32}, {"r13d", 13, 32}, {"r14d", 14, 32}, {"r15d", 15, 32},
+  {"rax", 0, 64}, {"rcx", 1, 64}, {"rdx", 2, 64}, {"rbx", 3, 64},
+  {"rsp", 4, 64}, {"rbp", 5, 64}, {"rsi", 6, 64}, {"rdi", 7, 64},
+  {"r8", 8, 64}, {"r9", 9, 64}, {"r10", 10, 64}, {"r11", 11, 64},
+  {"r12", 12, 64}, {"r13", 13, 64}, {"r14", 14, 64}, {"r15", 15, 64},
+};
+
+// Two-operand arithmetic: the opcodes of each group are Ext * 8 + 1 (r/m, r),
+// Ext * 8 + 3 (r, r/m) and Ext * 8 + 5 (accumulator, imm32), and Ext is the
+// ModRM reg field of the 0x81/0x83 immediate forms.
+const struct {
+  const char *Name;
+  uint8_t Ext;
+} ArithOps[] = {
+  {"add", 0}, {"or", 1}, {"adc", 2}, {"sbb", 3},
+  {"and", 4}, {"sub", 5}, {"xor", 6}, {"cmp", 7},
+};
+
+struct FastOperand {
+  enum KindTy { Register, Immediate, Memory } Kind;
+  unsigned Size;    // in bits, 0 for immediates and unsized memory
+  unsigned Num;     // register
+  int64_t Imm;      // immediate, or displacement of memory
+  int Base;         // -1 if none
+  int Index;        // -1 if none
+  unsigned Scale;
+};
+
+class FastEncoder {
+  ArrayRef<AsmToken> Toks;
+  unsigned Pos;
+  bool Is64Bit;
+  SmallVectorImpl<char> &Code;
+
+public:
+  FastEncoder(ArrayRef<AsmToken> Toks, bool Is64Bit, SmallVectorImpl<char> &Code)
+      : Toks(Toks), Pos(0), Is64Bit(Is64Bit), Code(Code) {}
+
+  unsigned encode(StringRef Mnemonic);
+
+private:
+  bool is(AsmToken::TokenKind Kind, unsigned Ahead = 0) const {
+    return Pos + Ahead < Toks.size() && Toks[Pos + Ahead].is(Kind);
+  }
+  bool atEnd() const {
+    return is(AsmToken::EndOfStatement) || is(AsmToken::Eof);
+  }
+  unsigned pointerSize() const { return Is64Bit ? 64 : 32; }
+
+  const FastRegister *parseRegister();
+  bool parseInteger(int64_t &Val);
+  bool parseMemory(FastOperand &Op);
+  bool parseOperand(FastOperand &Op);
+
+  bool encodeOperation(StringRef Mnemonic, FastOperand *Ops, unsigned NumOps);
+  bool encodeArith(unsigned Ext, FastOperand &Dst, FastOperand &Src);
+  bool encodeMov(FastOperand &Dst, FastOperand &Src);
+  bool encodeTest(FastOperand &Dst, FastOperand &Src);
+
+  void emitByte(uint8_t Byte) { Code.push_back(Byte); }
+  void emitConstant(uint64_t Val, unsigned Bytes) {
+    for (unsigned i = 0; i != Bytes; ++i, Val >>= 8)
+      emitByte(Val & 0xff);
+  }
+  void emitRex(bool W, unsigned Reg, const FastOperand &RM);
+  void emitModRM(unsigned Reg, const FastOperand &RM);
+};
+
+} // end anonymous namespace
+
+/// Immediates an 8-bit field sign-extends to the value, for an operation of
+/// Size bits. Like the matcher, take 0xffffff80-0xffffffff as negative for
+/// 32-bit operations.
+static bool isImm8(int64_t Val, unsigned Size) {
+  return isInt<8>(Val) ||
+         (Size == 32 && (uint64_t)Val >= 0xffffff80ULL &&
+          (uint64_t)Val <= 0xffffffffULL);
+}
+
+/// Immediates a 32-bit field holds, sign-extended to 64-bit operations.
+static bool isImm32(int64_t Val, unsigned Size) {
+  return isInt<32>(Val) || (Size == 32 && isUInt<32>(Val));
+}
+
+static bool isMemorySized(const FastOperand &Mem, unsigned Size) {
+  return Mem.Size == 0 || Mem.Size == Size;
+}
+
+const FastRegister *FastEncoder::parseRegister() {
+  if (!is(AsmToken::Identifier))
+    return nullptr;
+
+  StringRef Name = Toks[Pos].getString();
+  for (const FastRegister &Reg : Registers) {
+    if (Name.equals_lower(Reg.Name)) {
+      if (!Is64Bit && (Reg.Size == 64 || Reg.Num >= 8))
+        return nullptr;
+      ++Pos;
+      return &Reg;
+    }
+  }
+
+  return nullptr;
+}
+
+bool FastEncoder::parseInteger(int64_t &Val) {
+  bool Negative = is(AsmToken::Minus);
+  if (Negative)
+    ++Pos;
+  if (!is(AsmToken::Integer))
+    return false;
+
+  bool Valid;
+  Val = Toks[Pos++].getIntVal(Valid);
+  if (Negative)
+    Val = -(uint64_t)Val;
+  return Valid;
+}
+
+// [base], [base + index], [base + index * scale], each with an optional
+// trailing + disp or - disp.
+bool FastEncoder::parseMemory(FastOperand &Op) {
+  ++Pos;  // '['
+  const FastRegister *Base = parseRegister();
+  if (!Base || Base->Size != pointerSize())
+    return false;
+  Op.Base = Base->Num;
+
+  bool HaveDisp = false;
+  while (!is(AsmToken::RBrac)) {
+    if (HaveDisp)
+      return false;
+
+    if (is(AsmToken::Plus) && is(AsmToken::Identifier, 1) && Op.Index < 0) {
+      ++Pos;
+      const FastRegister *Index = parseRegister();
+      // rsp/esp cannot be an index
+      if (!Index || Index->Size != pointerSize() || Index->Num == 4)
+        return false;
+      Op.Index = Index->Num;
+      if (is(AsmToken::Star)) {
+        ++Pos;
+        int64_t Scale;
+        if (is(AsmToken::Minus) || !parseInteger(Scale) ||
+            (Scale != 1 && Scale != 2 && Scale != 4 && Scale != 8))
+          return false;
+        Op.Scale = Scale;
+      }
+      continue;
+    }
+
+    if ((is(AsmToken::Plus) || is(AsmToken::Minus)) &&
+        is(AsmToken::Integer, 1)) {
+      bool Negative = is(AsmToken::Minus);
+      ++Pos;
+      if (!parseInteger(Op.Imm))
+        return false;
+      if (Negative)
+        Op.Imm = -(uint64_t)Op.Imm;
+      if (!isImm32(Op.Imm, pointerSize()))
+        return false;
+      HaveDisp = true;
+      continue;
+    }
+
+    return false;
+  }
+
+  ++Pos;  // ']'
+  return true;
+}
+
+bool FastEncoder::parseOperand(FastOperand &Op) {
+  Op.Size = 0;
+  Op.Imm = 0;
+  Op.Base = Op.Index = -1;
+  Op.Scale = 1;
+
+  // dword ptr [...], qword ptr [...]
+  if (is(AsmToken::Identifier) && is(AsmToken::Identifier, 1) &&
+      Toks[Pos + 1].getString().equals_lower("ptr")) {
+    StringRef Size = Toks[Pos].getString();
+    if (Size.equals_lower("dword"))
+      Op.Size = 32;
+    else if (Size.equals_lower("qword") && Is64Bit)
+      Op.Size = 64;
+    else
+      return false;
+    Pos += 2;
+    if (!is(AsmToken::LBrac))
+      return false;
+  }
+
+  if (is(AsmToken::LBrac)) {
+    Op.Kind = FastOperand::Memory;
+    return parseMemory(Op);
+  }
+
+  if (is(AsmToken::Identifier)) {
+    const FastRegister *Reg = parseRegister();
+    if (!Reg)
+      return false;
+    Op.Kind = FastOperand::Register;
+    Op.Num = Reg->Num;
+    Op.Size = Reg->Size;
+    return true;
+  }
+
+  Op.Kind = FastOperand::Immediate;
+  return parseInteger(Op.Imm);
+}
+
+void FastEncoder::emitRex(bool W, unsigned Reg, const FastOperand &RM) {
+  unsigned Rex = (W ? 8 : 0) | ((Reg >> 3) & 1) << 2;
+  if (RM.Kind == FastOperand::Register)
+    Rex |= (RM.Num >> 3) & 1;
+  else {
+    if (RM.Index >= 0)
+      Rex |= ((RM.Index >> 3) & 1) << 1;
+    Rex |= (RM.Base >> 3) & 1;
+  }
+  if (Rex)
+    emitByte(0x40 | Rex);
+}
+
+void FastEncoder::emitModRM(unsigned Reg, const FastOperand &RM) {
+  Reg &= 7;
+  if (RM.Kind == FastOperand::Register) {
+    emitByte(0xc0 | Reg << 3 | (RM.Num & 7));
+    return;
+  }
+
+  // rbp/r13 as base need a displacement, rsp/r12 a SIB byte
+  unsigned Base = RM.Base & 7;
+  bool NeedSIB = RM.Index >= 0 || Base == 4;
+  unsigned Mod = 2;
+  if (RM.Imm == 0 && Base != 5)
+    Mod = 0;
+  else if (isInt<8>(RM.Imm))
+    Mod = 1;
+
+  emitByte(Mod << 6 | Reg << 3 | (NeedSIB ? 4 : Base));
+  if (NeedSIB)
+    emitByte(Log2_32(RM.Scale) << 6 |
+             (RM.Index >= 0 ? RM.Index & 7 : 4) << 3 | Base);
+  if (Mod == 1)
+    emitConstant(RM.Imm, 1);
+  else if (Mod == 2)
+    emitConstant(RM.Imm, 4);
+}
+
+bool FastEncoder::encodeArith(unsigned Ext, FastOperand &Dst,
+                              FastOperand &Src) {
+  if (Dst.Kind == FastOperand::Immediate)
+    return false;
+
+  if (Src.Kind == FastOperand::Immediate) {
+    unsigned Size = Dst.Size;
+    if (!Size)
+      return false;
+    bool W = Size == 64;
+    if (isImm8(Src.Imm, Size)) {
+      emitRex(W, 0, Dst);
+      emitByte(0x83);
+      emitModRM(Ext, Dst);
+      emitConstant(Src.Imm, 1);
+      return true;
+    }
+    if (!isImm32(Src.Imm, Size))
+      return false;
+    if (Dst.Kind == FastOperand::Register && Dst.Num == 0) {
+      if (W)
+        emitByte(0x48);
+      emitByte(Ext * 8 + 5);
+    } else {
+      emitRex(W, 0, Dst);
+      emitByte(0x81);
+      emitModRM(Ext, Dst);
+    }
+    emitConstant(Src.Imm, 4);
+    return true;
+  }
+
+  if (Src.Kind == FastOperand::Register) {
+    if (!isMemorySized(Dst, Src.Size))
+      return false;
+    emitRex(Src.Size == 64, Src.Num, Dst);
+    emitByte(Ext * 8 + 1);
+    emitModRM(Src.Num, Dst);
+    return true;
+  }
+
+  // register, memory
+  if (Dst.Kind != FastOperand::Register || !isMemorySized(Src, Dst.Size))
+    return false;
+  emitRex(Dst.Size == 64, Dst.Num, Src);
+  emitByte(Ext * 8 + 3);
+  emitModRM(Dst.Num, Src);
+  return true;
+}
+
+bool FastEncoder::encodeMov(FastOperand &Dst, FastOperand &Src) {
+  if (Dst.Kind == FastOperand::Immediate)
+    return false;
+
+  if (Src.Kind == FastOperand::Immediate) {
+    unsigned Size = Dst.Size;
+    if (!Size)
+      return false;
+    if (Dst.Kind == FastOperand::Register &&
+        (Size == 32 || !isInt<32>(Src.Imm))) {
+      // B8+r: imm32, or imm64 (movabs) for a 64-bit register
+      if (Size == 32 && !isImm32(Src.Imm, 32))
+        return false;
+      unsigned Rex = (Size == 64 ? 8 : 0) | (Dst.Num >> 3);
+      if (Rex)
+        emitByte(0x40 | Rex);
+      emitByte(0xb8 + (Dst.Num & 7));
+      emitConstant(Src.Imm, Size / 8);
+      return true;
+    }
+    if (!isImm32(Src.Imm, Size))
+      return false;
+    emitRex(Size == 64, 0, Dst);
+    emitByte(0xc7);
+    emitModRM(0, Dst);
+    emitConstant(Src.Imm, 4);
+    return true;
+  }
+
+  if (Src.Kind == FastOperand::Register) {
+    if (!isMemorySized(Dst, Src.Size))
+      return false;
+    emitRex(Src.Size == 64, Src.Num, Dst);
+    emitByte(0x89);
+    emitModRM(Src.Num, Dst);
+    return true;
+  }
+
+  if (Dst.Kind != FastOperand::Register || !isMemorySized(Src, Dst.Size))
+    return false;
+  emitRex(Dst.Size == 64, Dst.Num, Src);
+  emitByte(0x8b);
+  emitModRM(Dst.Num, Src);
+  return true;
+}
+
+bool FastEncoder::encodeTest(FastOperand &Dst, FastOperand &Src) {
+  if (Dst.Kind == FastOperand::Immediate || Src.Kind == FastOperand::Memory)
+    return false;
+
+  if (Src.Kind == FastOperand::Immediate) {
+    unsigned Size = Dst.Size;
+    if (!Size || !isImm32(Src.Imm, Size))
+      return false;
+    if (Dst.Kind == FastOperand::Register && Dst.Num == 0) {
+      if (Size == 64)
+        emitByte(0x48);
+      emitByte(0xa9);
+    } else {
+      emitRex(Size == 64, 0, Dst);
+      emitByte(0xf7);
+      emitModRM(0, Dst);
+    }
+    emitConstant(Src.Imm, 4);
+    return true;
+  }
+
+  if (!isMemorySized(Dst, Src.Size))
+    return false;
+  emitRex(Src.Size == 64, Src.Num, Dst);
+  emitByte(0x85);
+  emitModRM(Src.Num, Dst);
+  return true;
+}
+
+bool FastEncoder::encodeOperation(StringRef Mnemonic, FastOperand *Ops,
+                                  unsigned NumOps) {
+  if (NumOps == 2) {
+    FastOperand &Dst = Ops[0], &Src = Ops[1];
+    if (Dst.Kind == FastOperand::Register && Src.Kind == FastOperand::Register &&
+        Dst.Size != Src.Size)
+      return false;
+
+    for (const auto &Op : ArithOps)
+      if (Mnemonic == Op.Name)
+        return encodeArith(Op.Ext, Dst, Src);
+
+    if (Mnemonic == "mov")
+      return encodeMov(Dst, Src);
+    if (Mnemonic == "test")
+      return encodeTest(Dst, Src);
+    if (Mnemonic == "lea") {
+      if (Dst.Kind != FastOperand::Register || Src.Kind != FastOperand::Memory ||
+          Src.Size)
+        return false;
+      emitRex(Dst.Size == 64, Dst.Num, Src);
+      emitByte(0x8d);
+      emitModRM(Dst.Num, Src);
+      return true;
+    }
+    return false;
+  }
+
+  if (NumOps == 1) {
+    FastOperand &Op = Ops[0];
+    if (Op.Kind == FastOperand::Register) {
+      // only the pointer-sized forms exist in 64-bit mode
+      if (Op.Size != pointerSize())
+        return false;
+      unsigned Rex = Op.Num >> 3;
+      if (Mnemonic == "push" || Mnemonic == "pop") {
+        if (Rex)
+          emitByte(0x41);
+        emitByte((Mnemonic == "push" ? 0x50 : 0x58) + (Op.Num & 7));
+        return true;
+      }
+      if (Mnemonic == "call" || Mnemonic == "jmp") {
+        if (Rex)
+          emitByte(0x41);
+        emitByte(0xff);
+        emitModRM(Mnemonic == "call" ? 2 : 4, Op);
+        return true;
+      }
+      return false;
+    }
+
+    if (Op.Kind == FastOperand::Immediate) {
+      if (Mnemonic == "push") {
+        if (isInt<8>(Op.Imm)) {
+          emitByte(0x6a);
+          emitConstant(Op.Imm, 1);
+          return true;
+        }
+        // the matcher also narrows 0xff80..0xffff, and values that only fit
+        // unsigned, to other push forms; leave those to it
+        if (!isInt<32>(Op.Imm) || (Op.Imm >= 0xff80 && Op.Imm <= 0xffff))
+          return false;
+        emitByte(0x68);
+        emitConstant(Op.Imm, 4);
+        return true;
+      }
+      if (Mnemonic == "ret" && isUInt<16>(Op.Imm)) {
+        emitByte(0xc2);
+        emitConstant(Op.Imm, 2);
+        return true;
+      }
+    }
+    return false;
+  }
+
+  if (NumOps == 0 && Mnemonic == "ret") {
+    emitByte(0xc3);
+    return true;
+  }
+
+  return false;
+}
+
+unsigned FastEncoder::encode(StringRef Mnemonic) {
+  FastOperand Ops[2];
+  unsigned NumOps = 0;
+
+  while (!atEnd()) {
+    if (NumOps == 2 || !parseOperand(Ops[NumOps++]))
+      return 0;
+    if (is(AsmToken::Comma)) {
+      ++Pos;
+      if (atEnd())
+        return 0;
+    } else if (!atEnd())
+      return 0;
+  }
+
+  if (!encodeOperation(Mnemonic, Ops, NumOps)) {
+    Code.clear();
+    return 0;
+  }
+
+  return is(AsmToken::EndOfStatement) ? Pos + 1 : Pos;
+}
+
+unsigned llvm_ks::encodeX86FastPath(StringRef Mnemonic,
+                                    ArrayRef<AsmToken> Toks, bool Is64Bit,
+                                    SmallVectorImpl<char> &Code) {
+  return FastEncoder(Toks, Is64Bit, Code).encode(Mnemonic);
+}
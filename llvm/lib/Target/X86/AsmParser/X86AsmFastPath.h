@@ -0,0 +1,35 @@
+//===- X86AsmFastPath.h - Direct encoding of common x86 forms ---*- C++ -*-===//
+//
+//                     The LLVM Compiler Infrastructure
+//
+// This file is distributed under the University of Illinois Open Source
+// License. See LICENSE.TXT for details.
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_LIB_TARGET_X86_ASMPARSER_X86ASMFASTPATH_H
+#define LLVM_LIB_TARGET_X86_ASMPARSER_X86ASMFASTPATH_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+
+namespace llvm_ks {
+
+class AsmToken;
+
+/// Encode the Intel syntax statement of instruction Mnemonic, whose operand
+/// tokens are Toks, straight to machine code if it is one of the most
+/// common forms: mov, lea, add, or, adc, sbb, and, sub, xor, cmp, test,
+/// push, pop, call, jmp and ret with 32/64-bit general purpose registers,
+/// constant immediates and [base + index * scale + disp] memory operands.
+/// The bytes are the same as the matcher and X86MCCodeEmitter produce.
+///
+/// Returns the number of tokens making up the statement, including its
+/// EndOfStatement, or 0 if this is not a form known here.
+unsigned encodeX86FastPath(StringRef Mnemonic, ArrayRef<AsmToken> Toks,
+                           bool Is64Bit, SmallVectorImpl<char> &Code);
+
+} // End llvm namespace
+
+#endif
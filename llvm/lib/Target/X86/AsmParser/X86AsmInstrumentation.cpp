@@ -22,6 +22,7 @@
 #include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/MC/MCTargetOptions.h"
+#include "llvm/Support/SourceMgr.h"
 #include <algorithm>
 #include <cassert>
 #include <vector>
@@ -91,6 +92,26 @@
 //   RSP is used as a frame register. So, we need to select some
 //   register as a frame register and temprorary override current CFA
 //   register.
+//
+// Keystone instead offers basic-block counters (MCBlockCounters): the
+// first instruction of the input, of each label and after each branch,
+// call or return starts a block, and gets a prologue adding 1 to the
+// 64-bit counter of the block in a table supplied by the caller. The
+// prologue preserves every register and flag. In 64-bit mode it steps
+// over the red zone and uses RAX to increment through movabs, so the
+// table can be anywhere:
+// LEA RSP, [RSP - 128]
+// PUSH RAX
+// MOVABS RAX, [Counter]
+// LEA RAX, [RAX + 1]
+// MOVABS [Counter], RAX
+// POP RAX
+// LEA RSP, [RSP + 128]
+// In 32-bit mode, the carry into the high half needs the flags:
+// PUSHFD
+// ADD DWORD PTR [Counter], 1
+// ADC DWORD PTR [Counter + 4], 0
+// POPFD
 
 namespace llvm_ks {
 
@@ -111,6 +132,84 @@ void X86AsmInstrumentation::EmitInstruction(MCStreamer &Out,
   Out.EmitInstruction(Inst, *STI, KsError);
 }
 
+namespace {
+
+class X86BlockCounters : public X86AsmInstrumentation {
+public:
+  X86BlockCounters(const MCSubtargetInfo *&STI, uint64_t Table)
+      : X86AsmInstrumentation(STI), Table(Table), BlockStart(true) {}
+
+  void InstrumentAndEmitInstruction(MCInst &Inst, OperandVector &Operands,
+                                    MCContext &Ctx, const MCInstrInfo &MII,
+                                    MCStreamer &Out,
+                                    unsigned int &KsError) override {
+    if (BlockStart) {
+      BlockStart = false;
+      const SourceMgr *SrcMgr = Ctx.getSourceManager();
+      SMLoc Loc = Operands.empty() ? SMLoc() : Operands[0]->getStartLoc();
+      Lines.push_back(SrcMgr && Loc.isValid()
+                          ? SrcMgr->getLineAndColumn(Loc).first : 0);
+      EmitCounterIncrement(Out, Table + 8 * (Lines.size() - 1), KsError);
+      if (KsError)
+        return;
+    }
+
+    const MCInstrDesc &Desc = MII.get(Inst.getOpcode());
+    EmitInstruction(Out, Inst, KsError);
+    if (Desc.isBranch() || Desc.isCall() || Desc.isReturn())
+      BlockStart = true;
+  }
+
+  void InstrumentLabel() override { BlockStart = true; }
+
+  ArrayRef<unsigned> getBlockLines() const override { return Lines; }
+
+private:
+  void EmitCounterIncrement(MCStreamer &Out, uint64_t Counter,
+                            unsigned int &KsError);
+
+  void EmitInst(MCStreamer &Out, MCInst Inst, unsigned int &KsError) {
+    if (!KsError)
+      EmitInstruction(Out, Inst, KsError);
+  }
+
+  uint64_t Table;
+  bool BlockStart;
+  SmallVector<unsigned, 16> Lines;
+};
+
+void X86BlockCounters::EmitCounterIncrement(MCStreamer &Out, uint64_t Counter,
+                                            unsigned int &KsError) {
+  if (STI->getFeatureBits()[X86::Mode64Bit]) {
+    // skip the red zone of a leaf function before pushing
+    EmitInst(Out, MCInstBuilder(X86::LEA64r).addReg(X86::RSP)
+                      .addReg(X86::RSP).addImm(1).addReg(0).addImm(-128)
+                      .addReg(0), KsError);
+    EmitInst(Out, MCInstBuilder(X86::PUSH64r).addReg(X86::RAX), KsError);
+    EmitInst(Out, MCInstBuilder(X86::MOV64ao64).addImm(Counter).addReg(0),
+             KsError);
+    EmitInst(Out, MCInstBuilder(X86::LEA64r).addReg(X86::RAX)
+                      .addReg(X86::RAX).addImm(1).addReg(0).addImm(1)
+                      .addReg(0), KsError);
+    EmitInst(Out, MCInstBuilder(X86::MOV64o64a).addImm(Counter).addReg(0),
+             KsError);
+    EmitInst(Out, MCInstBuilder(X86::POP64r).addReg(X86::RAX), KsError);
+    EmitInst(Out, MCInstBuilder(X86::LEA64r).addReg(X86::RSP)
+                      .addReg(X86::RSP).addImm(1).addReg(0).addImm(128)
+                      .addReg(0), KsError);
+    return;
+  }
+
+  EmitInst(Out, MCInstBuilder(X86::PUSHF32), KsError);
+  EmitInst(Out, MCInstBuilder(X86::ADD32mi8).addReg(0).addImm(1).addReg(0)
+                    .addImm(Counter).addReg(0).addImm(1), KsError);
+  EmitInst(Out, MCInstBuilder(X86::ADC32mi8).addReg(0).addImm(1).addReg(0)
+                    .addImm(Counter + 4).addReg(0).addImm(0), KsError);
+  EmitInst(Out, MCInstBuilder(X86::POPF32), KsError);
+}
+
+} // end anonymous namespace
+
 unsigned X86AsmInstrumentation::GetFrameRegGeneric(const MCContext &Ctx,
                                                    MCStreamer &Out) {
   if (!Out.getNumFrameInfos()) // No active dwarf frame
@@ -133,6 +232,8 @@ unsigned X86AsmInstrumentation::GetFrameRegGeneric(const MCContext &Ctx,
 X86AsmInstrumentation *
 CreateX86AsmInstrumentation(const MCTargetOptions &MCOptions,
                             const MCContext &Ctx, const MCSubtargetInfo *&STI) {
+  if (MCOptions.MCBlockCounters)
+    return new X86BlockCounters(STI, MCOptions.MCBlockCounters);
   return new X86AsmInstrumentation(STI);
 }
 
@@ -10,6 +10,7 @@
 #ifndef LLVM_LIB_TARGET_X86_ASMPARSER_X86ASMINSTRUMENTATION_H
 #define LLVM_LIB_TARGET_X86_ASMPARSER_X86ASMINSTRUMENTATION_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
 
 #include <memory>
@@ -47,6 +48,12 @@ public:
       MCContext &Ctx, const MCInstrInfo &MII, MCStreamer &Out,
       unsigned int &KsError);
 
+  // Called for each label, before the instruction it points to.
+  virtual void InstrumentLabel() {}
+
+  // Source line of the first instruction of each counted basic block.
+  virtual ArrayRef<unsigned> getBlockLines() const { return None; }
+
 protected:
   friend X86AsmInstrumentation *
   CreateX86AsmInstrumentation(const MCTargetOptions &MCOptions,
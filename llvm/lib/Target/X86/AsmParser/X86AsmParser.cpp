@@ -8,6 +8,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "MCTargetDesc/X86BaseInfo.h"
+#include "X86AsmFastPath.h"
 #include "X86AsmInstrumentation.h"
 #include "X86AsmParserCommon.h"
 #include "X86Operand.h"
@@ -17,8 +18,10 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/ADT/Twine.h"
+#include "llvm/MC/MCCodeEmitter.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCExpr.h"
+#include "llvm/MC/MCFixup.h"
 #include "llvm/MC/MCInst.h"
 #include "llvm/MC/MCInstrInfo.h"
 #include "llvm/MC/MCParser/MCAsmLexer.h"
@@ -30,6 +33,7 @@
 #include "llvm/MC/MCStreamer.h"
 #include "llvm/MC/MCSubtargetInfo.h"
 #include "llvm/MC/MCSymbol.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetRegistry.h"
 #include "llvm/Support/raw_ostream.h"
@@ -38,6 +42,7 @@
 
 //#include <iostream>
 
+#include "keystone/keystone.h"
 #include "keystone/x86.h"
 
 using namespace llvm_ks;
@@ -64,6 +69,9 @@ class X86AsmParser : public MCTargetAsmParser {
   const MCInstrInfo &MII;
   ParseInstructionInfo *InstInfo;
   std::unique_ptr<X86AsmInstrumentation> Instrumentation;
+  /// Encoder used to measure candidate encodings (MCOptimizeSize).
+  std::unique_ptr<MCCodeEmitter> SizeEmitter;
+  uint64_t BytesSaved = 0;
 
 private:
   // PUSH i8  --> PUSH32i8
@@ -817,6 +825,18 @@ private:
 
   bool processInstruction(MCInst &Inst, const OperandVector &Ops);
 
+  /// Rewrite Inst into a shorter equivalent form, one step at a time.
+  /// Returns true if Inst changed.
+  bool shrinkInstruction(MCInst &Inst);
+  /// Apply shrinkInstruction() as long as it helps and account for the
+  /// bytes saved.
+  void optimizeForSize(MCInst &Inst);
+  unsigned getEncodedSize(const MCInst &Inst);
+
+  /// Give Inst the encoding whose size does not depend on its immediate or
+  /// displacement values (MCFixedWidth).
+  void fixInstructionWidth(MCInst &Inst);
+
   /// Wrapper around MCStreamer::EmitInstruction(). Possibly adds
   /// instrumentation around Inst.
   void EmitInstruction(MCInst &Inst, OperandVector &Operands, MCStreamer &Out,
@@ -904,6 +924,23 @@ public:
         CreateX86AsmInstrumentation(Options, Parser.getContext(), STI));
   }
 
+  uint64_t getBytesSaved() const override { return BytesSaved; }
+
+  ArrayRef<unsigned> getBlockCounterLines() const override {
+    return Instrumentation->getBlockLines();
+  }
+
+  void onLabelParsed(MCSymbol *Symbol) override {
+    Instrumentation->InstrumentLabel();
+  }
+
+  bool createStructuredOperands(StringRef Mnemonic, ArrayRef<ks_operand> Ops,
+                                OperandVector &Operands,
+                                unsigned int &ErrorCode) override;
+
+  bool tryFastEncode(StringRef Name, MCStreamer &Out,
+                     uint64_t &Address) override;
+
   bool ParseRegister(unsigned &RegNo, SMLoc &StartLoc, SMLoc &EndLoc, unsigned int &ErrorCode) override;
 
   void SetFrameRegister(unsigned RegNo) override;
@@ -2878,10 +2915,425 @@ bool X86AsmParser::processInstruction(MCInst &Inst, const OperandVector &Ops)
   }
 }
 
+// Turn a 64-bit register-only or register-immediate instruction into its
+// 32-bit counterpart, which zero-extends into the full register.
+static void narrowTo32(MCInst &Inst, unsigned NewOpc) {
+  Inst.setOpcode(NewOpc);
+  for (unsigned i = 0, e = Inst.getNumOperands(); i != e; ++i) {
+    MCOperand &Op = Inst.getOperand(i);
+    if (Op.isReg())
+      Op.setReg(getX86SubSuperRegister(Op.getReg(), 32));
+  }
+}
+
+// The low byte register of EAX/EBX/ECX/EDX, which needs no REX prefix.
+static unsigned getLegacyLowByteReg(unsigned Reg) {
+  switch (Reg) {
+  default:       return 0;
+  case X86::EAX: return X86::AL;
+  case X86::EBX: return X86::BL;
+  case X86::ECX: return X86::CL;
+  case X86::EDX: return X86::DL;
+  }
+}
+
+bool X86AsmParser::shrinkInstruction(MCInst &Inst)
+{
+  switch (Inst.getOpcode()) {
+  default: {
+    // A commutable VEX instruction whose second source is r8-r15 (VEX.B)
+    // gets the 2-byte VEX prefix once the sources are swapped.
+    const MCInstrDesc &Desc = MII.get(Inst.getOpcode());
+    uint64_t TSFlags = Desc.TSFlags;
+    if (!Desc.isCommutable() ||
+        (TSFlags & X86II::EncodingMask) != X86II::VEX ||
+        (TSFlags & X86II::OpMapMask) != X86II::TB ||
+        (TSFlags & X86II::FormMask) != X86II::MRMSrcReg ||
+        (TSFlags & X86II::VEX_W) || !(TSFlags & X86II::VEX_4V) ||
+        Inst.getNumOperands() != 3)
+      return false;
+    // Scalar forms take the upper elements from the first source, so the
+    // sources are not interchangeable there.
+    if (Desc.OpInfo[1].RegClass == X86::FR32RegClassID ||
+        Desc.OpInfo[1].RegClass == X86::FR64RegClassID)
+      return false;
+    unsigned Src1 = Inst.getOperand(1).getReg();
+    unsigned Src2 = Inst.getOperand(2).getReg();
+    if (X86II::isX86_64ExtendedReg(Src1) || !X86II::isX86_64ExtendedReg(Src2))
+      return false;
+    Inst.getOperand(1).setReg(Src2);
+    Inst.getOperand(2).setReg(Src1);
+    return true;
+  }
+  case X86::MOV64ri: {
+    // movabs of a value that fits in 32 bits
+    if (!Inst.getOperand(1).isImm())
+      return false;
+    int64_t Imm = Inst.getOperand(1).getImm();
+    if (isUInt<32>(Imm)) {
+      narrowTo32(Inst, X86::MOV32ri);
+      return true;
+    }
+    if (isInt<32>(Imm)) {
+      Inst.setOpcode(X86::MOV64ri32);
+      return true;
+    }
+    return false;
+  }
+  case X86::MOV64ri32:
+  case X86::AND64ri8:
+  case X86::AND64ri32:
+  case X86::AND64i32:
+  case X86::TEST64ri32:
+  case X86::TEST64i32: {
+    // With a non-negative immediate the upper half of the result is zero
+    // either way, and so is the sign flag.
+    const MCOperand &ImmOp = Inst.getOperand(Inst.getNumOperands() - 1);
+    if (!ImmOp.isImm() || ImmOp.getImm() < 0)
+      return false;
+    if (Inst.getOpcode() == X86::AND64ri8 ? !isInt<8>(ImmOp.getImm())
+                                          : !isInt<32>(ImmOp.getImm()))
+      return false;
+    unsigned NewOpc;
+    switch (Inst.getOpcode()) {
+    default: llvm_unreachable("Invalid opcode");
+    case X86::MOV64ri32:  NewOpc = X86::MOV32ri;   break;
+    case X86::AND64ri8:   NewOpc = X86::AND32ri8;  break;
+    case X86::AND64ri32:  NewOpc = X86::AND32ri;   break;
+    case X86::AND64i32:   NewOpc = X86::AND32i32;  break;
+    case X86::TEST64ri32: NewOpc = X86::TEST32ri;  break;
+    case X86::TEST64i32:  NewOpc = X86::TEST32i32; break;
+    }
+    narrowTo32(Inst, NewOpc);
+    return true;
+  }
+  case X86::TEST32ri:
+  case X86::TEST32i32: {
+    // test against a 7-bit mask only looks at the low byte
+    const MCOperand &ImmOp = Inst.getOperand(Inst.getNumOperands() - 1);
+    if (!ImmOp.isImm() || !isUInt<7>(ImmOp.getImm()))
+      return false;
+    if (Inst.getOpcode() == X86::TEST32i32) {
+      Inst.setOpcode(X86::TEST8i8);
+      return true;
+    }
+    unsigned Reg8 = getLegacyLowByteReg(Inst.getOperand(0).getReg());
+    if (!Reg8)
+      return false;
+    Inst.setOpcode(X86::TEST8ri);
+    Inst.getOperand(0).setReg(Reg8);
+    return true;
+  }
+  case X86::XOR64rr:
+  case X86::SUB64rr: {
+    // zeroing idiom: the 32-bit form clears the whole register and sets
+    // the same flags
+    unsigned Reg = Inst.getOperand(0).getReg();
+    if (Inst.getOperand(1).getReg() != Reg || Inst.getOperand(2).getReg() != Reg)
+      return false;
+    narrowTo32(Inst, Inst.getOpcode() == X86::XOR64rr ? X86::XOR32rr
+                                                     : X86::SUB32rr);
+    return true;
+  }
+  }
+}
+
+unsigned X86AsmParser::getEncodedSize(const MCInst &Inst)
+{
+  if (!SizeEmitter)
+    SizeEmitter.reset(createX86MCCodeEmitter(MII, *getContext().getRegisterInfo(),
+                                             getContext()));
+
+  raw_inline_ostream OS;
+  SmallVector<MCFixup, 4> Fixups;
+  MCInst Copy(Inst);
+  unsigned int KsError = 0;
+  SizeEmitter->encodeInstruction(Copy, OS, Fixups, getSTI(), KsError);
+
+  return OS.tell();
+}
+
+bool X86AsmParser::tryFastEncode(StringRef Name, MCStreamer &Out,
+                                 uint64_t &Address)
+{
+  // the options below rework or watch every MCInst
+  if (is16BitMode() || !isParsingIntelSyntax() ||
+      (KsSyntax & KS_OPT_SYNTAX_NASM) || MCOptions.MCOptimizeSize ||
+      MCOptions.MCFixedWidth || MCOptions.MCBlockCounters)
+    return false;
+
+  // enough for the longest form: dword ptr [rax + rbx * 8 - 1], -1
+  AsmToken Toks[20];
+  Toks[0] = getParser().getTok();
+  size_t Count = 1;
+  if (!Toks[0].is(AsmToken::EndOfStatement) && !Toks[0].is(AsmToken::Eof))
+    Count += getLexer().peekTokens(MutableArrayRef<AsmToken>(Toks + 1, 19));
+
+  SmallString<16> Code;
+  unsigned Used = encodeX86FastPath(Name, makeArrayRef(Toks, Count),
+                                    is64BitMode(), Code);
+  if (!Used || !Out.EmitEncodedInstruction(Code))
+    return false;
+
+  for (unsigned i = 0; i < Used; ++i)
+    getParser().Lex();
+  // as MatchAndEmitInstruction() does for the instructions it emits
+  Address += Code.size();
+  return true;
+}
+
+bool X86AsmParser::createStructuredOperands(StringRef Mnemonic,
+                                            ArrayRef<ks_operand> Ops,
+                                            OperandVector &Operands,
+                                            unsigned int &ErrorCode)
+{
+  MCContext &Ctx = getContext();
+  const MCRegisterInfo *MRI = Ctx.getRegisterInfo();
+  SMLoc Loc;
+
+  push32 = false;
+  Operands.push_back(X86Operand::CreateToken(Mnemonic, Loc));
+  for (const ks_operand &Op : Ops) {
+    switch (Op.type) {
+    default:
+      ErrorCode = KS_ERR_ASM_X86_INVALIDOPERAND;
+      return true;
+    case KS_OP_REG:
+      if (!Op.reg || Op.reg >= MRI->getNumRegs()) {
+        ErrorCode = KS_ERR_ASM_X86_INVALIDOPERAND;
+        return true;
+      }
+      Operands.push_back(X86Operand::CreateReg(Op.reg, Loc, Loc));
+      break;
+    case KS_OP_IMM:
+      // same special cases as ParseIntelOperand()
+      if (Mnemonic == "call" || Mnemonic == "loop" || Mnemonic == "loope" ||
+          Mnemonic == "loopne" || Mnemonic.startswith("j")) {
+        Operands.push_back(X86Operand::CreateMem(
+            0, 0, MCConstantExpr::create(Op.imm, Ctx), 0, 0, 1, Loc, Loc, 0));
+        break;
+      }
+      if (Mnemonic == "push")
+        push32 = true;
+      Operands.push_back(X86Operand::CreateImm(
+          MCConstantExpr::create(Op.imm, Ctx), Loc, Loc));
+      break;
+    case KS_OP_MEM: {
+      const ks_op_mem &Mem = Op.mem;
+      unsigned Scale = Mem.scale ? Mem.scale : 1;
+      if ((Scale != 1 && Scale != 2 && Scale != 4 && Scale != 8) ||
+          Mem.segment >= MRI->getNumRegs() || Mem.base >= MRI->getNumRegs() ||
+          Mem.index >= MRI->getNumRegs()) {
+        ErrorCode = KS_ERR_ASM_X86_INVALIDOPERAND;
+        return true;
+      }
+      const MCExpr *Disp = MCConstantExpr::create(Mem.disp, Ctx);
+      // same forms as ParseIntelBracExpression()
+      if (!Mem.base && !Mem.index && !Mem.segment) {
+        Operands.push_back(X86Operand::CreateMem(getPointerWidth(), Disp, Loc,
+                                                 Loc, Mem.size * 8));
+        break;
+      }
+      StringRef ErrMsg;
+      if ((Mem.base || Mem.index) &&
+          CheckBaseRegAndIndexReg(Mem.base, Mem.index, ErrMsg)) {
+        ErrorCode = KS_ERR_ASM_X86_INVALIDOPERAND;
+        return true;
+      }
+      Operands.push_back(X86Operand::CreateMem(
+          getPointerWidth(), Mem.segment, Disp, Mem.base, Mem.index, Scale,
+          Loc, Loc, Mem.size * 8));
+      break;
+    }
+    }
+  }
+
+  return false;
+}
+
+void X86AsmParser::optimizeForSize(MCInst &Inst)
+{
+  MCInst Orig(Inst);
+  if (!shrinkInstruction(Inst))
+    return;
+  while (shrinkInstruction(Inst))
+    ;
+
+  // keep the rewrite only if it actually got shorter (e.g. r8-r15 still
+  // need a REX prefix after narrowing)
+  unsigned OldSize = getEncodedSize(Orig);
+  unsigned NewSize = getEncodedSize(Inst);
+  if (NewSize < OldSize)
+    BytesSaved += OldSize - NewSize;
+  else
+    Inst = Orig;
+}
+
+// One step towards the widest immediate form: imm8 -> imm16/imm32, then
+// the accumulator short form where there is one.
+static bool widenInstruction(MCInst &Inst)
+{
+#define WIDEN_ALU(OP) \
+  case X86::OP##16ri8: NewOpc = X86::OP##16ri;   break; \
+  case X86::OP##32ri8: NewOpc = X86::OP##32ri;   break; \
+  case X86::OP##64ri8: NewOpc = X86::OP##64ri32; break; \
+  case X86::OP##16mi8: NewOpc = X86::OP##16mi;   break; \
+  case X86::OP##32mi8: NewOpc = X86::OP##32mi;   break; \
+  case X86::OP##64mi8: NewOpc = X86::OP##64mi32; break;
+#define WIDEN_SHIFT(OP) \
+  case X86::OP##8r1:  NewOpc = X86::OP##8ri;  AddImm = 1; break; \
+  case X86::OP##16r1: NewOpc = X86::OP##16ri; AddImm = 1; break; \
+  case X86::OP##32r1: NewOpc = X86::OP##32ri; AddImm = 1; break; \
+  case X86::OP##64r1: NewOpc = X86::OP##64ri; AddImm = 1; break; \
+  case X86::OP##8m1:  NewOpc = X86::OP##8mi;  AddImm = 1; break; \
+  case X86::OP##16m1: NewOpc = X86::OP##16mi; AddImm = 1; break; \
+  case X86::OP##32m1: NewOpc = X86::OP##32mi; AddImm = 1; break; \
+  case X86::OP##64m1: NewOpc = X86::OP##64mi; AddImm = 1; break;
+#define ACC_ALU(OP) \
+  case X86::OP##16ri:   NewOpc = X86::OP##16i16; AccReg = X86::AX;  break; \
+  case X86::OP##32ri:   NewOpc = X86::OP##32i32; AccReg = X86::EAX; break; \
+  case X86::OP##64ri32: NewOpc = X86::OP##64i32; AccReg = X86::RAX; break;
+
+  unsigned NewOpc = 0, AccReg = 0;
+  int64_t AddImm = 0;
+
+  switch (Inst.getOpcode()) {
+  default: return false;
+  WIDEN_ALU(ADD) WIDEN_ALU(ADC) WIDEN_ALU(SUB) WIDEN_ALU(SBB)
+  WIDEN_ALU(AND) WIDEN_ALU(OR)  WIDEN_ALU(XOR) WIDEN_ALU(CMP)
+  WIDEN_SHIFT(SHL) WIDEN_SHIFT(SHR) WIDEN_SHIFT(SAR)
+  WIDEN_SHIFT(ROL) WIDEN_SHIFT(ROR) WIDEN_SHIFT(RCL) WIDEN_SHIFT(RCR)
+  ACC_ALU(ADD) ACC_ALU(ADC) ACC_ALU(SUB) ACC_ALU(SBB)
+  ACC_ALU(AND) ACC_ALU(OR)  ACC_ALU(XOR) ACC_ALU(CMP)
+  case X86::IMUL16rri8: NewOpc = X86::IMUL16rri;   break;
+  case X86::IMUL32rri8: NewOpc = X86::IMUL32rri;   break;
+  case X86::IMUL64rri8: NewOpc = X86::IMUL64rri32; break;
+  case X86::IMUL16rmi8: NewOpc = X86::IMUL16rmi;   break;
+  case X86::IMUL32rmi8: NewOpc = X86::IMUL32rmi;   break;
+  case X86::IMUL64rmi8: NewOpc = X86::IMUL64rmi32; break;
+  case X86::PUSH16i8:   NewOpc = X86::PUSHi16;     break;
+  case X86::PUSH32i8:   NewOpc = X86::PUSHi32;     break;
+  case X86::PUSH64i8:   NewOpc = X86::PUSH64i32;   break;
+  case X86::MOV64ri32:  NewOpc = X86::MOV64ri;     break;
+  case X86::INT3:       NewOpc = X86::INT; AddImm = 3; break;
+  }
+
+#undef WIDEN_ALU
+#undef WIDEN_SHIFT
+#undef ACC_ALU
+
+  if (AccReg) {
+    // only when the accumulator is the register operand
+    if (!Inst.getOperand(0).isReg() || Inst.getOperand(0).getReg() != AccReg)
+      return false;
+    MCOperand Imm = Inst.getOperand(Inst.getNumOperands() - 1);
+    Inst.clear();
+    Inst.addOperand(Imm);
+  }
+
+  Inst.setOpcode(NewOpc);
+  if (AddImm)
+    Inst.addOperand(MCOperand::createImm(AddImm));
+
+  return true;
+}
+
+void X86AsmParser::fixInstructionWidth(MCInst &Inst)
+{
+  while (widenInstruction(Inst))
+    ;
+
+  Inst.setFlags(Inst.getFlags() | X86::IP_USE_DISP32);
+}
+
 static const char *getSubtargetFeatureName(uint64_t Val);
 
+/// Return true if Inst is a relative call or (conditional) jump that has a
+/// rel32 form.
+static bool isRelBranch(const MCInst &Inst) {
+  switch (Inst.getOpcode()) {
+  default:
+    return false;
+  case X86::CALL64pcrel32:
+  case X86::JMP_1: case X86::JMP_4:
+  case X86::JA_1:  case X86::JA_4:  case X86::JAE_1: case X86::JAE_4:
+  case X86::JB_1:  case X86::JB_4:  case X86::JBE_1: case X86::JBE_4:
+  case X86::JE_1:  case X86::JE_4:  case X86::JNE_1: case X86::JNE_4:
+  case X86::JG_1:  case X86::JG_4:  case X86::JGE_1: case X86::JGE_4:
+  case X86::JL_1:  case X86::JL_4:  case X86::JLE_1: case X86::JLE_4:
+  case X86::JO_1:  case X86::JO_4:  case X86::JNO_1: case X86::JNO_4:
+  case X86::JP_1:  case X86::JP_4:  case X86::JNP_1: case X86::JNP_4:
+  case X86::JS_1:  case X86::JS_4:  case X86::JNS_1: case X86::JNS_4:
+    return true;
+  }
+}
+
+/// Mark a memory operand that is just a symbolic address (no base, index or
+/// segment) to be encoded RIP-relative. mov between the accumulator and a
+/// 64-bit address (picked by the matcher unless spelled movabs) becomes a
+/// plain mov first; the backend turns it back if the symbol is out of reach.
+static void selectRIPRelative(MCInst &Inst, const MCInstrInfo &MII,
+                              StringRef Mnemonic) {
+  unsigned AccReg = 0, NewOp = 0;
+  bool IsLoad = false;
+  switch (Inst.getOpcode()) {
+  case X86::MOV8ao64:  AccReg = X86::AL;  NewOp = X86::MOV8rm;  IsLoad = true; break;
+  case X86::MOV16ao64: AccReg = X86::AX;  NewOp = X86::MOV16rm; IsLoad = true; break;
+  case X86::MOV32ao64: AccReg = X86::EAX; NewOp = X86::MOV32rm; IsLoad = true; break;
+  case X86::MOV64ao64: AccReg = X86::RAX; NewOp = X86::MOV64rm; IsLoad = true; break;
+  case X86::MOV8o64a:  AccReg = X86::AL;  NewOp = X86::MOV8mr;  break;
+  case X86::MOV16o64a: AccReg = X86::AX;  NewOp = X86::MOV16mr; break;
+  case X86::MOV32o64a: AccReg = X86::EAX; NewOp = X86::MOV32mr; break;
+  case X86::MOV64o64a: AccReg = X86::RAX; NewOp = X86::MOV64mr; break;
+  }
+
+  if (AccReg) {
+    MCOperand Disp = Inst.getOperand(0);
+    if (!Disp.isExpr() || Inst.getOperand(1).getReg() ||
+        Mnemonic.startswith("movabs"))
+      return;
+    Inst.clear();
+    Inst.setOpcode(NewOp);
+    if (IsLoad)
+      Inst.addOperand(MCOperand::createReg(AccReg));
+    Inst.addOperand(MCOperand::createReg(0));  // base
+    Inst.addOperand(MCOperand::createImm(1));  // scale
+    Inst.addOperand(MCOperand::createReg(0));  // index
+    Inst.addOperand(Disp);
+    Inst.addOperand(MCOperand::createReg(0));  // segment
+    if (!IsLoad)
+      Inst.addOperand(MCOperand::createReg(AccReg));
+    Inst.setFlags(Inst.getFlags() | X86::IP_AUTO_RIPREL);
+    return;
+  }
+
+  const MCInstrDesc &Desc = MII.get(Inst.getOpcode());
+  int MemOp = X86II::getMemoryOperandNo(Desc.TSFlags, Inst.getOpcode());
+  if (MemOp < 0)
+    return;
+  MemOp += X86II::getOperandBias(Desc);
+
+  if (Inst.getOperand(MemOp + X86::AddrBaseReg).getReg() ||
+      Inst.getOperand(MemOp + X86::AddrIndexReg).getReg() ||
+      Inst.getOperand(MemOp + X86::AddrSegmentReg).getReg() ||
+      !Inst.getOperand(MemOp + X86::AddrDisp).isExpr())
+    return;
+
+  Inst.setFlags(Inst.getFlags() | X86::IP_AUTO_RIPREL);
+}
+
 void X86AsmParser::EmitInstruction(MCInst &Inst, OperandVector &Operands,
                                    MCStreamer &Out, unsigned int &KsError) {
+  // Let the backend route branches to targets beyond +/-2GB through an
+  // absolute address. Fixed-width code keeps its rel32 form.
+  if (is64BitMode() && !MCOptions.MCFixedWidth && isRelBranch(Inst))
+    Inst.setFlags(Inst.getFlags() | X86::IP_ALLOW_FAR_BRANCH);
+
+  // Likewise, let it pick RIP-relative or absolute addressing of symbols.
+  if (is64BitMode() && MCOptions.MCRIPRelative && !MCOptions.MCFixedWidth)
+    selectRIPRelative(Inst, MII,
+                      static_cast<X86Operand &>(*Operands[0]).getToken());
+
   Instrumentation->InstrumentAndEmitInstruction(Inst, Operands, getContext(),
                                                 MII, Out, KsError);
 }
@@ -2970,6 +3422,10 @@ bool X86AsmParser::MatchAndEmitATTInstruction(SMLoc IDLoc, unsigned &Opcode,
     if (!MatchingInlineAsm)
       while (processInstruction(Inst, Operands))
         ;
+    if (!MatchingInlineAsm && MCOptions.MCFixedWidth)
+      fixInstructionWidth(Inst);
+    else if (!MatchingInlineAsm && MCOptions.MCOptimizeSize)
+      optimizeForSize(Inst);
 
     Inst.setLoc(IDLoc);
     if (!MatchingInlineAsm) {
@@ -3245,6 +3701,10 @@ bool X86AsmParser::MatchAndEmitIntelInstruction(SMLoc IDLoc, unsigned &Opcode,
     if (!MatchingInlineAsm)
       while (processInstruction(Inst, Operands))
         ;
+    if (!MatchingInlineAsm && MCOptions.MCFixedWidth)
+      fixInstructionWidth(Inst);
+    else if (!MatchingInlineAsm && MCOptions.MCOptimizeSize)
+      optimizeForSize(Inst);
     Inst.setLoc(IDLoc);
     if (!MatchingInlineAsm) {
       EmitInstruction(Inst, Operands, Out, ErrorCode);
@@ -11,10 +11,13 @@
 #include "MCTargetDesc/X86FixupKinds.h"
 #include "llvm/ADT/StringSwitch.h"
 #include "llvm/MC/MCAsmBackend.h"
+#include "llvm/MC/MCAssembler.h"
 #include "llvm/MC/MCELFObjectWriter.h"
 #include "llvm/MC/MCExpr.h"
 #include "llvm/MC/MCFixupKindInfo.h"
 #include "llvm/MC/MCInst.h"
+#include "llvm/MC/MCInstrInfo.h"
+#include "llvm/MC/MCObjectStreamer.h"
 #include "llvm/MC/MCObjectWriter.h"
 #include "llvm/MC/MCRegisterInfo.h"
 #include "llvm/MC/MCSectionCOFF.h"
@@ -71,8 +74,26 @@ class X86AsmBackend : public MCAsmBackend {
   const StringRef CPU;
   bool HasNopl;
   uint64_t MaxNopLength;
+  std::unique_ptr<const MCInstrInfo> MCII;
+
+  // Branch alignment: the boundary (0 if off), the KS_OPT_ALIGN_BRANCH_*
+  // classes to align, the last instruction emitted and whether the one
+  // being emitted is a branch that gets aligned.
+  unsigned AlignBoundary;
+  unsigned AlignBranchType;
+  MCInst PrevInst;
+  bool AligningBranch;
+
+  bool needAlign(MCObjectStreamer &OS) const;
+  bool needAlignInst(const MCInst &Inst) const;
+  bool isFirstMacroFusibleInst(const MCInst &Inst) const;
+  MCBoundaryAlignFragment *
+  getOrCreateBoundaryAlignFragment(MCObjectStreamer &OS) const;
+
 public:
-  X86AsmBackend(const Target &T, StringRef CPU) : MCAsmBackend(), CPU(CPU) {
+  X86AsmBackend(const Target &T, StringRef CPU)
+      : MCAsmBackend(), CPU(CPU), MCII(T.createMCInstrInfo()),
+        AlignBoundary(0), AlignBranchType(0), AligningBranch(false) {
     HasNopl = CPU != "generic" && CPU != "i386" && CPU != "i486" &&
               CPU != "i586" && CPU != "pentium" && CPU != "pentium-mmx" &&
               CPU != "i686" && CPU != "k6" && CPU != "k6-2" && CPU != "k6-3" &&
@@ -132,6 +153,11 @@ public:
 
   bool mayNeedRelaxation(const MCInst &Inst) const override;
 
+  bool fixupNeedsRelaxationAdvanced(const MCFixup &Fixup, bool Resolved,
+                                    uint64_t Value,
+                                    const MCRelaxableFragment *DF,
+                                    const MCAsmLayout &Layout) const override;
+
   bool fixupNeedsRelaxation(const MCFixup &Fixup, uint64_t Value,
                             const MCRelaxableFragment *DF,
                             const MCAsmLayout &Layout, unsigned &KsError) const override;
@@ -139,6 +165,17 @@ public:
   void relaxInstruction(const MCInst &Inst, MCInst &Res) const override;
 
   bool writeNopData(uint64_t Count, MCObjectWriter *OW) const override;
+
+  void alignBranchesBegin(MCObjectStreamer &OS, const MCInst &Inst) override;
+  void alignBranchesEnd(MCObjectStreamer &OS, const MCInst &Inst) override;
+
+  bool isAligningBranches() const override { return AlignBoundary != 0; }
+
+  bool setAlignBranch(unsigned Boundary, unsigned Kinds) override {
+    AlignBoundary = Boundary;
+    AlignBranchType = Kinds;
+    return true;
+  }
 };
 } // end anonymous namespace
 
@@ -258,11 +295,26 @@ static unsigned getRelaxedOpcode(unsigned Op) {
   return getRelaxedOpcodeBranch(Op);
 }
 
+/// Return true if Inst is a rel32 branch which may still be relaxed to its
+/// far form (see X86::IP_ALLOW_FAR_BRANCH).
+static bool mayBecomeFarBranch(const MCInst &Inst) {
+  return (Inst.getFlags() & X86::IP_ALLOW_FAR_BRANCH) &&
+         !(Inst.getFlags() & X86::IP_FAR_BRANCH);
+}
+
 bool X86AsmBackend::mayNeedRelaxation(const MCInst &Inst) const {
   // Branches can always be relaxed.
   if (getRelaxedOpcodeBranch(Inst.getOpcode()) != Inst.getOpcode())
     return true;
 
+  // So can 64-bit rel32 branches, to their far form.
+  if (mayBecomeFarBranch(Inst))
+    return true;
+
+  // And RIP-relative symbol references, to an absolute address.
+  if (Inst.getFlags() & X86::IP_AUTO_RIPREL)
+    return true;
+
   // Check if this instruction is ever relaxable.
   if (getRelaxedOpcodeArith(Inst.getOpcode()) == Inst.getOpcode())
     return false;
@@ -281,16 +333,76 @@ bool X86AsmBackend::fixupNeedsRelaxation(const MCFixup &Fixup,
                                          uint64_t Value,
                                          const MCRelaxableFragment *DF,
                                          const MCAsmLayout &Layout, unsigned &KsError) const {
+  // A rel32 branch goes far if its target is more than 2GB away.
+  if (getFixupKindLog2Size(Fixup.getKind()) == 2)
+    return !isInt<32>(Value);
+
   // Relax if the value is too big for a (signed) i8.
   return int64_t(Value) != int64_t(int8_t(Value));
 }
 
+bool X86AsmBackend::fixupNeedsRelaxationAdvanced(
+    const MCFixup &Fixup, bool Resolved, uint64_t Value,
+    const MCRelaxableFragment *DF, const MCAsmLayout &Layout) const {
+  // Only a target known to be out of reach makes a rel32 branch go far.
+  if (!Resolved)
+    return getFixupKindLog2Size(Fixup.getKind()) == 0;
+
+  unsigned KsError;
+  return fixupNeedsRelaxation(Fixup, Value, DF, Layout, KsError);
+}
+
+/// Rewrite a RIP-relative symbol reference (see X86::IP_AUTO_RIPREL) whose
+/// symbol is out of reach to address the symbol absolutely: mov to/from the
+/// accumulator takes a 64-bit address (movabs), anything else a disp32.
+static void relaxRIPRelative(const MCInst &Inst, MCInst &Res) {
+  unsigned AccReg = 0, NewOp = 0, MemOp = 0;
+  switch (Inst.getOpcode()) {
+  case X86::MOV8rm:  AccReg = X86::AL;  NewOp = X86::MOV8ao64;  MemOp = 1; break;
+  case X86::MOV16rm: AccReg = X86::AX;  NewOp = X86::MOV16ao64; MemOp = 1; break;
+  case X86::MOV32rm: AccReg = X86::EAX; NewOp = X86::MOV32ao64; MemOp = 1; break;
+  case X86::MOV64rm: AccReg = X86::RAX; NewOp = X86::MOV64ao64; MemOp = 1; break;
+  case X86::MOV8mr:  AccReg = X86::AL;  NewOp = X86::MOV8o64a;  break;
+  case X86::MOV16mr: AccReg = X86::AX;  NewOp = X86::MOV16o64a; break;
+  case X86::MOV32mr: AccReg = X86::EAX; NewOp = X86::MOV32o64a; break;
+  case X86::MOV64mr: AccReg = X86::RAX; NewOp = X86::MOV64o64a; break;
+  }
+
+  Res = Inst;
+  Res.setFlags(Inst.getFlags() & ~X86::IP_AUTO_RIPREL);
+
+  unsigned RegOp = MemOp ? 0 : X86::AddrNumOperands;
+  if (!AccReg || Inst.getOperand(RegOp).getReg() != AccReg)
+    return;
+
+  Res.clear();
+  Res.setOpcode(NewOp);
+  Res.addOperand(Inst.getOperand(MemOp + X86::AddrDisp));
+  Res.addOperand(Inst.getOperand(MemOp + X86::AddrSegmentReg));
+}
+
 // FIXME: Can tblgen help at all here to verify there aren't other instructions
 // we can relax?
 void X86AsmBackend::relaxInstruction(const MCInst &Inst, MCInst &Res) const {
-  // The only relaxations X86 does is from a 1byte pcrel to a 4byte pcrel.
+  // X86 relaxes a 1byte pcrel to a 4byte pcrel, a 4byte pcrel branch to its
+  // far form, and a RIP-relative symbol reference to an absolute one.
   unsigned RelaxedOp = getRelaxedOpcode(Inst.getOpcode());
 
+  // Widening a symbolic immediate is harmless, so do that first: if the
+  // symbol reference was what needed relaxing, the next pass still sees it.
+  if ((Inst.getFlags() & X86::IP_AUTO_RIPREL) &&
+      (RelaxedOp == Inst.getOpcode() ||
+       !Inst.getOperand(Inst.getNumOperands() - 1).isExpr())) {
+    relaxRIPRelative(Inst, Res);
+    return;
+  }
+
+  if (RelaxedOp == Inst.getOpcode() && mayBecomeFarBranch(Inst)) {
+    Res = Inst;
+    Res.setFlags(Res.getFlags() | X86::IP_FAR_BRANCH);
+    return;
+  }
+
   if (RelaxedOp == Inst.getOpcode()) {
     SmallString<256> Tmp;
     raw_svector_ostream OS(Tmp);
@@ -302,6 +414,209 @@ void X86AsmBackend::relaxInstruction(const MCInst &Inst, MCInst &Res) const {
   Res.setOpcode(RelaxedOp);
 }
 
+namespace {
+/// Instructions that can be the first of a macro-fused pair, by the
+/// conditional jumps they fuse with.
+enum class FirstMacroFusionKind { Invalid, Test, Cmp, And, AddSub, IncDec };
+
+/// Conditional jumps by the flags they test.
+enum class SecondMacroFusionKind { Invalid, ELG, AB, SPO };
+} // end anonymous namespace
+
+static FirstMacroFusionKind classifyFirstOpcodeInMacroFusion(unsigned Op) {
+  switch (Op) {
+  default:
+    return FirstMacroFusionKind::Invalid;
+  // TEST, except with memory and immediate operands.
+  case X86::TEST8rr:   case X86::TEST16rr:  case X86::TEST32rr:
+  case X86::TEST64rr:  case X86::TEST8ri:   case X86::TEST16ri:
+  case X86::TEST32ri:  case X86::TEST64ri32:
+  case X86::TEST8i8:   case X86::TEST16i16: case X86::TEST32i32:
+  case X86::TEST64i32: case X86::TEST8rm:   case X86::TEST16rm:
+  case X86::TEST32rm:  case X86::TEST64rm:
+    return FirstMacroFusionKind::Test;
+  // AND with a register destination.
+  case X86::AND8rr:    case X86::AND16rr:   case X86::AND32rr:
+  case X86::AND64rr:   case X86::AND8ri:    case X86::AND16ri:
+  case X86::AND32ri:   case X86::AND64ri32: case X86::AND16ri8:
+  case X86::AND32ri8:  case X86::AND64ri8:  case X86::AND8i8:
+  case X86::AND16i16:  case X86::AND32i32:  case X86::AND64i32:
+  case X86::AND8rm:    case X86::AND16rm:   case X86::AND32rm:
+  case X86::AND64rm:
+    return FirstMacroFusionKind::And;
+  // CMP, except with memory and immediate operands.
+  case X86::CMP8rr:    case X86::CMP16rr:   case X86::CMP32rr:
+  case X86::CMP64rr:   case X86::CMP8ri:    case X86::CMP16ri:
+  case X86::CMP32ri:   case X86::CMP64ri32: case X86::CMP16ri8:
+  case X86::CMP32ri8:  case X86::CMP64ri8:  case X86::CMP8i8:
+  case X86::CMP16i16:  case X86::CMP32i32:  case X86::CMP64i32:
+  case X86::CMP8rm:    case X86::CMP16rm:   case X86::CMP32rm:
+  case X86::CMP64rm:   case X86::CMP8mr:    case X86::CMP16mr:
+  case X86::CMP32mr:   case X86::CMP64mr:
+    return FirstMacroFusionKind::Cmp;
+  // ADD and SUB with a register destination.
+  case X86::ADD8rr:    case X86::ADD16rr:   case X86::ADD32rr:
+  case X86::ADD64rr:   case X86::ADD8ri:    case X86::ADD16ri:
+  case X86::ADD32ri:   case X86::ADD64ri32: case X86::ADD16ri8:
+  case X86::ADD32ri8:  case X86::ADD64ri8:  case X86::ADD8i8:
+  case X86::ADD16i16:  case X86::ADD32i32:  case X86::ADD64i32:
+  case X86::ADD8rm:    case X86::ADD16rm:   case X86::ADD32rm:
+  case X86::ADD64rm:
+  case X86::SUB8rr:    case X86::SUB16rr:   case X86::SUB32rr:
+  case X86::SUB64rr:   case X86::SUB8ri:    case X86::SUB16ri:
+  case X86::SUB32ri:   case X86::SUB64ri32: case X86::SUB16ri8:
+  case X86::SUB32ri8:  case X86::SUB64ri8:  case X86::SUB8i8:
+  case X86::SUB16i16:  case X86::SUB32i32:  case X86::SUB64i32:
+  case X86::SUB8rm:    case X86::SUB16rm:   case X86::SUB32rm:
+  case X86::SUB64rm:
+    return FirstMacroFusionKind::AddSub;
+  // INC and DEC with a register operand.
+  case X86::INC8r:     case X86::INC16r:    case X86::INC32r:
+  case X86::INC64r:    case X86::INC16r_alt: case X86::INC32r_alt:
+  case X86::DEC8r:     case X86::DEC16r:    case X86::DEC32r:
+  case X86::DEC64r:    case X86::DEC16r_alt: case X86::DEC32r_alt:
+    return FirstMacroFusionKind::IncDec;
+  }
+}
+
+static SecondMacroFusionKind classifySecondOpcodeInMacroFusion(unsigned Op) {
+  switch (Op) {
+  default:
+    return SecondMacroFusionKind::Invalid;
+  case X86::JE_1:  case X86::JE_2:  case X86::JE_4:
+  case X86::JNE_1: case X86::JNE_2: case X86::JNE_4:
+  case X86::JL_1:  case X86::JL_2:  case X86::JL_4:
+  case X86::JGE_1: case X86::JGE_2: case X86::JGE_4:
+  case X86::JLE_1: case X86::JLE_2: case X86::JLE_4:
+  case X86::JG_1:  case X86::JG_2:  case X86::JG_4:
+    return SecondMacroFusionKind::ELG;
+  case X86::JB_1:  case X86::JB_2:  case X86::JB_4:
+  case X86::JAE_1: case X86::JAE_2: case X86::JAE_4:
+  case X86::JBE_1: case X86::JBE_2: case X86::JBE_4:
+  case X86::JA_1:  case X86::JA_2:  case X86::JA_4:
+    return SecondMacroFusionKind::AB;
+  case X86::JS_1:  case X86::JS_2:  case X86::JS_4:
+  case X86::JNS_1: case X86::JNS_2: case X86::JNS_4:
+  case X86::JP_1:  case X86::JP_2:  case X86::JP_4:
+  case X86::JNP_1: case X86::JNP_2: case X86::JNP_4:
+  case X86::JO_1:  case X86::JO_2:  case X86::JO_4:
+  case X86::JNO_1: case X86::JNO_2: case X86::JNO_4:
+    return SecondMacroFusionKind::SPO;
+  }
+}
+
+/// Check if \p Cmp and \p Jcc, emitted back to back, are macro-fused.
+static bool isMacroFused(const MCInst &Cmp, const MCInst &Jcc) {
+  SecondMacroFusionKind SK = classifySecondOpcodeInMacroFusion(Jcc.getOpcode());
+  if (SK == SecondMacroFusionKind::Invalid)
+    return false;
+
+  switch (classifyFirstOpcodeInMacroFusion(Cmp.getOpcode())) {
+  case FirstMacroFusionKind::Invalid:
+    return false;
+  case FirstMacroFusionKind::Test:
+  case FirstMacroFusionKind::And:
+    return true;
+  case FirstMacroFusionKind::Cmp:
+  case FirstMacroFusionKind::AddSub:
+    return SK != SecondMacroFusionKind::SPO;
+  case FirstMacroFusionKind::IncDec:
+    return SK == SecondMacroFusionKind::ELG;
+  }
+  llvm_unreachable("unknown macro fusion kind");
+}
+
+bool X86AsmBackend::needAlign(MCObjectStreamer &OS) const {
+  return AlignBoundary != 0 && !OS.getAssembler().isBundlingEnabled() &&
+         OS.getCurrentSectionOnly()->getKind().isText();
+}
+
+/// Check if \p Inst is a branch of a class that has to be aligned.
+bool X86AsmBackend::needAlignInst(const MCInst &Inst) const {
+  const MCInstrDesc &Desc = MCII->get(Inst.getOpcode());
+  return ((AlignBranchType & KS_OPT_ALIGN_BRANCH_JCC) &&
+          Desc.isConditionalBranch()) ||
+         ((AlignBranchType & KS_OPT_ALIGN_BRANCH_JMP) &&
+          Desc.isUnconditionalBranch()) ||
+         ((AlignBranchType & KS_OPT_ALIGN_BRANCH_CALL) && Desc.isCall()) ||
+         ((AlignBranchType & KS_OPT_ALIGN_BRANCH_RET) && Desc.isReturn()) ||
+         ((AlignBranchType & KS_OPT_ALIGN_BRANCH_INDIRECT) &&
+          Desc.isIndirectBranch());
+}
+
+/// Check if \p Inst may be macro-fused with a following conditional jump.
+/// RIP-relative instructions never are.
+bool X86AsmBackend::isFirstMacroFusibleInst(const MCInst &Inst) const {
+  unsigned Opcode = Inst.getOpcode();
+  if (classifyFirstOpcodeInMacroFusion(Opcode) == FirstMacroFusionKind::Invalid)
+    return false;
+
+  const MCInstrDesc &Desc = MCII->get(Opcode);
+  int MemoryOperand = X86II::getMemoryOperandNo(Desc.TSFlags, Opcode);
+  if (MemoryOperand < 0)
+    return true;
+  MemoryOperand += X86II::getOperandBias(Desc);
+  return Inst.getOperand(MemoryOperand + X86::AddrBaseReg).getReg() != X86::RIP;
+}
+
+/// Return the boundary-align fragment at the insertion point, creating one
+/// if there is none or the one there already pads another branch.
+MCBoundaryAlignFragment *
+X86AsmBackend::getOrCreateBoundaryAlignFragment(MCObjectStreamer &OS) const {
+  auto *F = dyn_cast_or_null<MCBoundaryAlignFragment>(OS.getCurrentFragment());
+  if (!F || F->canEmitNops()) {
+    F = new MCBoundaryAlignFragment(AlignBoundary);
+    OS.insert(F);
+  }
+  return F;
+}
+
+/// Put a boundary-align fragment in front of a branch that has to be
+/// aligned. A macro-fusible instruction gets one too, which only pads if a
+/// conditional jump it fuses with follows it directly.
+void X86AsmBackend::alignBranchesBegin(MCObjectStreamer &OS,
+                                       const MCInst &Inst) {
+  AligningBranch = false;
+  if (!needAlign(OS))
+    return;
+
+  MCFragment *CF = OS.getCurrentFragment();
+  MCBoundaryAlignFragment *PF =
+      CF ? dyn_cast_or_null<MCBoundaryAlignFragment>(CF->getPrevNode())
+         : nullptr;
+  bool NeedAlignFused = AlignBranchType & KS_OPT_ALIGN_BRANCH_FUSED;
+  if (NeedAlignFused && PF && isMacroFused(PrevInst, Inst)) {
+    // Only the fusible instruction was emitted since its fragment, so
+    // padding there keeps the fused pair together.
+    PF->setEmitNops(true);
+    PF->setFused(true);
+    AligningBranch = true;
+  } else if (needAlignInst(Inst)) {
+    MCBoundaryAlignFragment *F = getOrCreateBoundaryAlignFragment(OS);
+    F->setEmitNops(true);
+    F->setFused(false);
+    AligningBranch = true;
+  } else if (NeedAlignFused && isFirstMacroFusibleInst(Inst)) {
+    // Whether it fuses is only known at the next instruction.
+    getOrCreateBoundaryAlignFragment(OS);
+  }
+
+  PrevInst = Inst;
+}
+
+/// End the fragments of an aligned branch right after it, so that the
+/// instructions following it are not counted as part of it.
+void X86AsmBackend::alignBranchesEnd(MCObjectStreamer &OS,
+                                     const MCInst &Inst) {
+  if (!AligningBranch)
+    return;
+
+  AligningBranch = false;
+  // A relaxable fragment only ever holds the branch.
+  if (!isa<MCRelaxableFragment>(OS.getCurrentFragment()))
+    OS.insert(new MCBoundaryAlignFragment(AlignBoundary));
+}
+
 /// \brief Write a sequence of optimal nops to the output, covering \p Count
 /// bytes.
 /// \return - true on success, false on failure
@@ -51,6 +51,24 @@ namespace X86 {
     TO_ZERO = 3,
     CUR_DIRECTION = 4
   };
+
+  /// Flags the asm parser sets on an MCInst for the code emitter.
+  enum IPREFIXES {
+    IP_NO_PREFIX = 0,
+    /// Encode the displacement of a memory operand with 32 bits (16 bits for
+    /// 16-bit addressing), even if it is 0 or fits in 8 bits.
+    IP_USE_DISP32 = 1U << 0,
+    /// A 64-bit mode rel32 call/jmp/jcc may be relaxed to its far form if
+    /// its target turns out to be more than 2GB away.
+    IP_ALLOW_FAR_BRANCH = 1U << 1,
+    /// Encode the branch in its far form: an indirect call/jmp through an
+    /// 8-byte absolute address stored right after it.
+    IP_FAR_BRANCH = 1U << 2,
+    /// Encode the absolute symbolic address of the memory operand (no base,
+    /// index or segment) RIP-relative. The backend falls back to an absolute
+    /// address if the symbol turns out to be more than 2GB away.
+    IP_AUTO_RIPREL = 1U << 3
+  };
 } // end namespace X86;
 
 /// X86II - This namespace holds all of the target specific flags that
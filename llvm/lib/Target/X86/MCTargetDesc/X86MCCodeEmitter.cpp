@@ -129,6 +129,10 @@ public:
                      bool is64bit,
                      int ImmOffset = 0, bool RIP_rel = false) const;
 
+  void EmitFarBranch(MCInst &MI, uint64_t TSFlags, raw_ostream &OS,
+                     SmallVectorImpl<MCFixup> &Fixups,
+                     unsigned int &KsError) const;
+
   inline static unsigned char ModRMByte(unsigned Mod, unsigned RegOpcode,
                                         unsigned RM) {
     assert(Mod < 4 && RegOpcode < 8 && RM < 8 && "ModRM Fields out of range!");
@@ -321,7 +325,9 @@ EmitImmediate(const MCInst &MI, const MCOperand &DispOp, SMLoc Loc, unsigned Siz
         FixupKind != FK_PCRel_2 &&
         FixupKind != FK_PCRel_4 &&
         FixupKind != FK_PCRel_4 &&
-        (FixupKind != MCFixupKind(X86::reloc_riprel_4byte) || !RIP_rel)) {
+        ((FixupKind != MCFixupKind(X86::reloc_riprel_4byte) &&
+          FixupKind != MCFixupKind(X86::reloc_riprel_4byte_movq_load)) ||
+         !RIP_rel)) {
       EmitConstant(DispOp.getImm(), Size, CurByte, OS);
       return;
     }
@@ -380,6 +386,44 @@ EmitImmediate(const MCInst &MI, const MCOperand &DispOp, SMLoc Loc, unsigned Siz
   EmitConstant(0, Size, CurByte, OS);
 }
 
+/// Encode a rel32 call/jmp/jcc whose target is out of reach as an indirect
+/// branch through an 8-byte absolute address that follows it:
+///
+///   call: call [rip+2]; jmp .+10; .quad target
+///   jmp:  jmp [rip]; .quad target
+///   jcc:  j!cc .+16; jmp [rip]; .quad target
+void X86MCCodeEmitter::EmitFarBranch(MCInst &MI, uint64_t TSFlags,
+                                     raw_ostream &OS,
+                                     SmallVectorImpl<MCFixup> &Fixups,
+                                     unsigned int &KsError) const
+{
+  unsigned CurByte = 0;
+  unsigned BaseOpcode = X86II::getBaseOpcodeFor(TSFlags);
+
+  if (MI.getOpcode() == X86::CALL64pcrel32) {
+    EmitByte(0xFF, CurByte, OS);
+    EmitByte(ModRMByte(0, 2, 5), CurByte, OS);
+    EmitConstant(2, 4, CurByte, OS);
+    EmitByte(0xEB, CurByte, OS);
+    EmitByte(8, CurByte, OS);
+  } else {
+    // A conditional jump skips the indirect jump with the opposite condition.
+    if (BaseOpcode != 0xE9) {
+      EmitByte(0x70 | ((BaseOpcode & 0xF) ^ 1), CurByte, OS);
+      EmitByte(14, CurByte, OS);
+    }
+    EmitByte(0xFF, CurByte, OS);
+    EmitByte(ModRMByte(0, 4, 5), CurByte, OS);
+    EmitConstant(0, 4, CurByte, OS);
+  }
+
+  EmitImmediate(MI, MI.getOperand(0), MI.getLoc(), 8, FK_Data_8, CurByte, OS,
+                Fixups, KsError, true);
+
+  // Keystone: update Inst.Address to point to the next instruction
+  MI.setAddress(MI.getAddress() + CurByte);
+}
+
 #define ABS_SUB(a, b) (a < b? b - a: a - b)
 void X86MCCodeEmitter::EmitMemModRMByte(const MCInst &MI, unsigned Op,
                                         unsigned RegOpcodeField,
@@ -394,15 +438,22 @@ void X86MCCodeEmitter::EmitMemModRMByte(const MCInst &MI, unsigned Op,
   const MCOperand &IndexReg = MI.getOperand(Op+X86::AddrIndexReg);
   unsigned BaseReg = Base.getReg();
   bool HasEVEX = (TSFlags & X86II::EncodingMask) == X86II::EVEX;
+  bool UseDisp32 = MI.getFlags() & X86::IP_USE_DISP32;
   unsigned int KsError;
   bool RIP_rel = false;
 
-  // do we need x64 RIP relative encoding?
-  if (BaseReg == 0 && is64BitMode(STI) && IndexReg.getReg() == 0 && Disp.isImm()) {
+  // do we need x64 RIP relative encoding? (not with a segment override,
+  // which would make the address relative to the segment base)
+  if (BaseReg == 0 && is64BitMode(STI) && IndexReg.getReg() == 0 && Disp.isImm() &&
+      MI.getOperand(Op+X86::AddrSegmentReg).getReg() == 0) {
       if (ABS_SUB(MI.getAddress(), (uint64_t)Disp.getImm()) < 2 * (1UL << 30))
           RIP_rel = true;
   }
 
+  // the parser asked for RIP relative encoding of a symbol (KS_OPT_RIP_RELATIVE)
+  if (MI.getFlags() & X86::IP_AUTO_RIPREL)
+      RIP_rel = true;
+
   // Handle %rip relative addressing.
   if (RIP_rel || BaseReg == X86::RIP) {    // [disp32+RIP] in X86-64 mode
     assert(is64BitMode(STI) && "Rip-relative addressing requires 64-bit mode");
@@ -471,7 +522,7 @@ void X86MCCodeEmitter::EmitMemModRMByte(const MCInst &MI, unsigned Op,
           RMfield = (IndexReg16 & 1) | ((7 - RMfield) << 1);
       }
 
-      if (Disp.isImm() && isDisp8(Disp.getImm())) {
+      if (!UseDisp32 && Disp.isImm() && isDisp8(Disp.getImm())) {
         if (Disp.getImm() == 0 && BaseRegNo != N86::EBP) {
           // There is no displacement; just the register.
           EmitByte(ModRMByte(0, RegOpcodeField, RMfield), CurByte, OS);
@@ -522,13 +573,14 @@ void X86MCCodeEmitter::EmitMemModRMByte(const MCInst &MI, unsigned Op,
     // indirect register encoding, this handles addresses like [EAX].  The
     // encoding for [EBP] with no displacement means [disp32] so we handle it
     // by emitting a displacement of 0 below.
-    if (Disp.isImm() && Disp.getImm() == 0 && BaseRegNo != N86::EBP) {
+    if (!UseDisp32 && Disp.isImm() && Disp.getImm() == 0 &&
+        BaseRegNo != N86::EBP) {
       EmitByte(ModRMByte(0, RegOpcodeField, BaseRegNo), CurByte, OS);
       return;
     }
 
     // Otherwise, if the displacement fits in a byte, encode as [REG+disp8].
-    if (Disp.isImm()) {
+    if (!UseDisp32 && Disp.isImm()) {
       if (!HasEVEX && isDisp8(Disp.getImm())) {
         EmitByte(ModRMByte(1, RegOpcodeField, BaseRegNo), CurByte, OS);
         EmitImmediate(MI, Disp, MI.getLoc(), 1, FK_Data_1, CurByte, OS, Fixups, KsError,
@@ -568,7 +620,7 @@ void X86MCCodeEmitter::EmitMemModRMByte(const MCInst &MI, unsigned Op,
     // MOD=0, BASE=5, to JUST get the index, scale, and displacement.
     EmitByte(ModRMByte(0, RegOpcodeField, 4), CurByte, OS);
     ForceDisp32 = true;
-  } else if (!Disp.isImm()) {
+  } else if (!Disp.isImm() || UseDisp32) {
     // Emit the normal disp32 encoding.
     EmitByte(ModRMByte(2, RegOpcodeField, 4), CurByte, OS);
     ForceDisp32 = true;
@@ -1282,6 +1334,11 @@ encodeInstruction(MCInst &MI, raw_ostream &OS,
   if ((TSFlags & X86II::FormMask) == X86II::Pseudo)
     return;
 
+  if (MI.getFlags() & X86::IP_FAR_BRANCH) {
+    EmitFarBranch(MI, TSFlags, OS, Fixups, KsError);
+    return;
+  }
+
   unsigned NumOps = Desc.getNumOperands();
   unsigned CurOp = X86II::getOperandBias(Desc);
 
@@ -0,0 +1,34 @@
+#!/usr/bin/python
+
+# Test that AArch64 adrp + add/ldr pairs within +/-1MB of their target are
+# relaxed to adr/ldr (literal) + nop.
+
+from keystone import *
+
+import regress
+
+
+class TestArm64AdrpRelax(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_ARM64, KS_MODE_LITTLE_ENDIAN)
+
+        # adr x0, d; nop
+        encoding, count = ks.asm(b"adrp x0, d; add x0, x0, :lo12:d; d: nop", 0x1ff8)
+        self.assertEqual(encoding, [ 0x40, 0x00, 0x00, 0x10, 0x1f, 0x20, 0x03, 0xd5, 0x1f, 0x20, 0x03, 0xd5 ])
+
+        # ldr x1, d; nop
+        encoding, count = ks.asm(b"adrp x1, d; ldr x1, [x1, :lo12:d]; d: .quad 0", 0x1ff8)
+        self.assertEqual(encoding[:8], [ 0x41, 0x00, 0x00, 0x58, 0x1f, 0x20, 0x03, 0xd5 ])
+
+        # out of range: adrp with the page delta + add of the page offset
+        encoding, count = ks.asm(b"adrp x0, d; add x0, x0, :lo12:d; .space 0x100000; d: nop", 0x1ff8)
+        self.assertEqual(encoding[:8], [ 0x00, 0x08, 0x00, 0xb0, 0x00, 0x00, 0x00, 0x91 ])
+
+        # the page address in x1 is still needed afterwards
+        encoding, count = ks.asm(b"adrp x1, d; ldr x2, [x1, :lo12:d]; d: .quad 0", 0x1ff8)
+        self.assertEqual(encoding[:8], [ 0x01, 0x00, 0x00, 0xb0, 0x22, 0x00, 0x40, 0xf9 ])
+
+
+if __name__ == '__main__':
+    regress.main()
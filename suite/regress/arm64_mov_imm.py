@@ -0,0 +1,34 @@
+#!/usr/bin/python
+
+# Test the AArch64 "mov Rd, #imm" expansion for arbitrary constants.
+
+from keystone import *
+
+import regress
+
+
+class TestArm64MovImm(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_ARM64, KS_MODE_LITTLE_ENDIAN)
+
+        # a single movz/movn/orr is still matched as before
+        encoding, count = ks.asm(b"mov x0, #0xffff0000ffff0000")
+        self.assertEqual(encoding, [ 0xe0, 0x3f, 0x10, 0xb2 ])
+
+        # movz + movk
+        encoding, count = ks.asm(b"mov w2, #0x12345678")
+        self.assertEqual(encoding, [ 0x02, 0xcf, 0x8a, 0x52, 0x82, 0x46, 0xa2, 0x72 ])
+
+        # orr with a bitmask immediate + movk
+        encoding, count = ks.asm(b"mov x0, #0x00ff00ff00ff1234")
+        self.assertEqual(encoding, [ 0xe0, 0x9f, 0x00, 0xb2, 0x80, 0x46, 0x82, 0xf2 ])
+
+        # any 64-bit constant takes at most 4 instructions
+        encoding, count = ks.asm(b"mov x1, #0x1234123412345678")
+        self.assertEqual(encoding, [ 0x01, 0xcf, 0x8a, 0xd2, 0x81, 0x46, 0xa2, 0xf2,
+                                     0x81, 0x46, 0xc2, 0xf2, 0x81, 0x46, 0xe2, 0xf2 ])
+
+
+if __name__ == '__main__':
+    regress.main()
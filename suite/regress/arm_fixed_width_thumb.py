@@ -0,0 +1,52 @@
+#!/usr/bin/python
+
+# Test KS_OPT_FIXED_WIDTH in Thumb2: the size of an instruction must not
+# depend on its immediate, so two-operand forms take their wide
+# three-operand encodings.
+
+from keystone import *
+
+import regress
+
+
+class TestArmFixedWidthThumb(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_ARM, KS_MODE_THUMB)
+        ks.fixed_width = True
+
+        # adds.w r0, r0, #1
+        small, count = ks.asm(b"adds r0, #1")
+        large, count = ks.asm(b"adds r0, #0x3e8")
+        self.assertEqual(small, [ 0x10, 0xf1, 0x01, 0x00 ])
+        self.assertEqual(len(small), len(large))
+
+        # subs.w r0, r0, #1
+        small, count = ks.asm(b"subs r0, #1")
+        large, count = ks.asm(b"subs r0, #0x3e8")
+        self.assertEqual(small, [ 0xb0, 0xf1, 0x01, 0x00 ])
+        self.assertEqual(len(small), len(large))
+
+        # movs.w r0, #1
+        small, count = ks.asm(b"movs r0, #1")
+        large, count = ks.asm(b"movs r0, #0x3e8")
+        self.assertEqual(small, [ 0x5f, 0xf0, 0x01, 0x00 ])
+        self.assertEqual(len(small), len(large))
+
+        # add.w sp, sp, #8
+        encoding, count = ks.asm(b"add sp, #8")
+        self.assertEqual(encoding, [ 0x0d, 0xf1, 0x08, 0x0d ])
+
+        # negs r0, r1 is rsbs.w r0, r1, #0
+        encoding, count = ks.asm(b"negs r0, r1")
+        self.assertEqual(encoding, [ 0xd1, 0xf1, 0x00, 0x00 ])
+
+        # no wide encoding: muls and svc stay narrow
+        encoding, count = ks.asm(b"muls r0, r1")
+        self.assertEqual(encoding, [ 0x48, 0x43 ])
+        encoding, count = ks.asm(b"svc #1")
+        self.assertEqual(encoding, [ 0x01, 0xdf ])
+
+
+if __name__ == '__main__':
+    regress.main()
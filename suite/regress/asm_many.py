@@ -0,0 +1,37 @@
+#!/usr/bin/python
+
+# Test Ks.asm_many(): a batch gives the same results as asm() on each
+# (string, addr) pair, as lists or bytes, and stops at the first error.
+
+from keystone import *
+
+import regress
+
+
+class TestAsmMany(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+
+        pairs = [(b"push rbp; mov rbp, rsp", 0),
+                 ("call 0x2000", 0x1000),
+                 (b"jmp 0x1010", 0x1000),
+                 (b"", 0)]
+        results = ks.asm_many(pairs)
+        self.assertEqual(results, [ks.asm(s, a) for s, a in pairs])
+        self.assertEqual(results[0], ([ 0x55, 0x48, 0x89, 0xe5 ], 2))
+        self.assertEqual(results[3], (None, 0))
+
+        results = ks.asm_many(pairs, as_bytes=True)
+        self.assertEqual(results[0], (b"\x55\x48\x89\xe5", 2))
+        self.assertEqual(results[2], (b"\xeb\x0e", 1))
+
+        try:
+            ks.asm_many([(b"nop", 0), (b"nop; foo", 0)])
+            self.fail("asm_many() should fail on foo")
+        except KsError as e:
+            self.assertEqual(e.errno, KS_ERR_ASM_MNEMONICFAIL)
+
+
+if __name__ == '__main__':
+    regress.main()
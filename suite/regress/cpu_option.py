@@ -0,0 +1,55 @@
+#!/usr/bin/python
+
+# Test selecting the CPU and its features per handle.
+
+from keystone import *
+
+import regress
+
+
+class TestCpuOption(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+
+        # default CPU has long NOPs for padding
+        encoding, count = ks.asm(b"ret; .align 0x10")
+        self.assertEqual(encoding, [ 0xc3, 0x66, 0x66, 0x66, 0x66, 0x66, 0x66, 0x2e, 0x0f, 0x1f, 0x84, 0x00, 0x00, 0x00, 0x00, 0x00 ])
+
+        # i686 lacks NOPL, so padding uses lea
+        ks.cpu = "i686"
+        encoding, count = ks.asm(b"ret; .align 0x10")
+        self.assertEqual(encoding, [ 0xc3, 0x8d, 0xb4, 0x26, 0x00, 0x00, 0x00, 0x00, 0x8d, 0xb4, 0x26, 0x00, 0x00, 0x00, 0x00, 0x90 ])
+
+        ks.cpu = None
+        encoding, count = ks.asm(b"ret; .align 0x10")
+        self.assertEqual(encoding[1:3], [ 0x66, 0x66 ])
+
+        # unknown CPUs are rejected
+        try:
+            ks.cpu = "bogus"
+            self.assertFalse(1, "ERROR: unknown CPU accepted")
+        except KsError as e:
+            self.assertEqual(e.errno, KS_ERR_OPT_INVALID)
+
+        # features decide which instructions are accepted
+        ks = Ks(KS_ARCH_ARM64, KS_MODE_LITTLE_ENDIAN)
+        encoding, count = ks.asm(b"crc32b w0, w1, w2")
+        self.assertEqual(encoding, [ 0x20, 0x40, 0xc2, 0x1a ])
+
+        ks.features = "-crc"
+        try:
+            encoding, count = ks.asm(b"crc32b w0, w1, w2")
+            self.assertFalse(1, "ERROR: crc32b accepted without crc")
+        except KsError as e:
+            pass
+
+        try:
+            ks.features = "+bogus"
+            self.assertFalse(1, "ERROR: unknown feature accepted")
+        except KsError as e:
+            self.assertEqual(e.errno, KS_ERR_OPT_INVALID)
+
+
+if __name__ == '__main__':
+    regress.main()
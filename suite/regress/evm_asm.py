@@ -0,0 +1,74 @@
+#!/usr/bin/python
+
+# Test the EVM assembler: multiple statements, PUSHn immediates, and labels
+# pushed with the narrowest PUSHn that fits their final address.
+
+from keystone import *
+from keystone.evm_const import *
+
+import regress
+
+
+class TestEvmAsm(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_EVM, 0)
+
+        # single opcodes, in any case
+        self.assertEqual(ks.asm(b"STOP")[0], [ 0x00 ])
+        self.assertEqual(ks.asm(b"mstore")[0], [ 0x52 ])
+
+        encoding, count = ks.asm(b"push1 0x80; push1 0x40\nmstore // free pointer")
+        self.assertEqual(encoding, [ 0x60, 0x80, 0x60, 0x40, 0x52 ])
+        self.assertEqual(count, 3)
+
+        # a comment runs to the end of the line, ';' included
+        encoding, count = ks.asm(b"push1 1 // a; b\nstop")
+        self.assertEqual(encoding, [ 0x60, 0x01, 0x00 ])
+        self.assertEqual(count, 2)
+
+        # immediates are zero-extended to n bytes, up to 256 bits
+        self.assertEqual(ks.asm(b"push4 0x1234")[0], [ 0x63, 0, 0, 0x12, 0x34 ])
+        self.assertEqual(ks.asm(b"push32 0x" + b"ff" * 32)[0], [ 0x7f ] + [ 0xff ] * 32)
+        self.assertEqual(ks.asm(b"push 4660")[0], [ 0x61, 0x12, 0x34 ])
+        self.assertEqual(ks.asm(b"push 0")[0], [ 0x60, 0x00 ])
+
+        # forward and backward jumps to labels
+        encoding, count = ks.asm(b"loop: jumpdest; push loop; push end; jumpi\nend: jumpdest")
+        self.assertEqual(encoding, [ 0x5b, 0x60, 0x00, 0x60, 0x06, 0x57, 0x5b ])
+        self.assertEqual(count, 5)
+
+        # the label moves past 0xff once its own push grows to PUSH2
+        self.assertEqual(ks.asm(b"push end; end: jumpdest", 0xfd)[0], [ 0x60, 0xff, 0x5b ])
+        self.assertEqual(ks.asm(b"push end; end: jumpdest", 0xfe)[0], [ 0x61, 0x01, 0x01, 0x5b ])
+        encoding, count = ks.asm(b"push top; jump\n" + b"jumpdest\n" * 300 + b"top: jumpdest")
+        self.assertEqual(encoding[:4], [ 0x61, 0x01, 0x30, 0x56 ])
+
+        # labels defined elsewhere come from the symbol resolver
+        def sym_resolver(symbol, value):
+            if symbol == b"foo":
+                value[0] = 0x1234
+                return True
+            return False
+
+        ks_resolved = Ks(KS_ARCH_EVM, 0)
+        ks_resolved.sym_resolver = sym_resolver
+        self.assertEqual(ks_resolved.asm(b"push foo; jump")[0], [ 0x61, 0x12, 0x34, 0x56 ])
+
+        # errors
+        for code, error in [(b"foo", KS_ERR_ASM_EVM_MNEMONICFAIL),
+                            (b"add 1", KS_ERR_ASM_EVM_INVALIDOPERAND),
+                            (b"push1", KS_ERR_ASM_EVM_INVALIDOPERAND),
+                            (b"push2 0x123456", KS_ERR_ASM_EVM_INVALIDOPERAND),
+                            (b"push 0x1" + b"00" * 32, KS_ERR_ASM_EVM_INVALIDOPERAND),
+                            (b"a: a: stop", KS_ERR_ASM_SYMBOL_REDEFINED),
+                            (b"push nowhere", KS_ERR_ASM_SYMBOL_MISSING)]:
+            try:
+                ks.asm(code)
+                self.fail("%s should not assemble" % code)
+            except KsError as e:
+                self.assertEqual(e.errno, error)
+
+
+if __name__ == '__main__':
+    regress.main()
@@ -0,0 +1,47 @@
+#!/usr/bin/python
+
+# Test ks_evm_gas(): static gas of each instruction and straight-line block
+# of assembled EVM code, with dynamic costs flagged.
+
+from keystone import *
+
+import regress
+
+
+class TestEvmGas(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_EVM, 0)
+
+        code = (b"push1 0x80; push1 0x40; mstore\n"
+                b"callvalue; iszero; push ok; jumpi; push 0; dup1; revert\n"
+                b"ok: jumpdest; push 1; sload; push 2; exp; stop")
+        cost = ks.evm_gas(code)
+        self.assertEqual(cost["size"], len(ks.asm(code)[0]))
+        self.assertEqual([i["gas"] for i in cost["insns"]],
+                         [3, 3, 3, 2, 3, 3, 10, 3, 3, 0, 1, 3, 200, 3, 10, 0])
+        self.assertEqual([i["offset"] for i in cost["insns"]][:4], [0, 2, 4, 5])
+        self.assertTrue(cost["insns"][2]["dynamic"])     # mstore
+        self.assertFalse(cost["insns"][12]["dynamic"])   # sload
+        self.assertTrue(cost["insns"][14]["dynamic"])    # exp
+
+        # blocks end after jumpi & revert, and start at jumpdest
+        self.assertEqual([(b["offset"], b["count"], b["gas"], b["dynamic"]) for b in cost["blocks"]],
+                         [(0, 7, 27, True), (10, 3, 6, True), (14, 6, 217, True)])
+        self.assertEqual(cost["gas"], 27 + 6 + 217)
+        self.assertTrue(cost["dynamic"])
+
+        cost = ks.evm_gas(b"push 1; push 2; add; pop")
+        self.assertEqual((cost["gas"], cost["dynamic"], cost["size"]), (11, False, 6))
+
+        # EVM only
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+        try:
+            ks.evm_gas(b"nop")
+            self.fail("ks_evm_gas() should fail on X86")
+        except KsError as e:
+            self.assertEqual(e.errno, KS_ERR_ARCH)
+
+
+if __name__ == '__main__':
+    regress.main()
@@ -0,0 +1,35 @@
+#!/usr/bin/python
+
+# Test automatic packetization of unbundled Hexagon instructions.
+
+from keystone import *
+
+import regress
+
+
+class TestHexagonPacketize(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_HEXAGON, KS_MODE_BIG_ENDIAN)
+
+        # without packetization every instruction is its own packet
+        encoding, count = ks.asm(b"r0 = add(r1, r2)\nr3 = add(r4, r5)")
+        self.assertEqual(encoding, [ 0x00, 0xc2, 0x01, 0xf3, 0x03, 0xc5, 0x04, 0xf3 ])
+
+        ks.packetize = True
+
+        # independent instructions share a packet
+        encoding, count = ks.asm(b"r0 = add(r1, r2)\nr3 = add(r4, r5)")
+        self.assertEqual(encoding, [ 0x00, 0x42, 0x01, 0xf3, 0x03, 0xc5, 0x04, 0xf3 ])
+
+        # a read of r0 must wait for the next packet
+        encoding, count = ks.asm(b"r0 = add(r1, r2)\nr3 = add(r0, r5)")
+        self.assertEqual(encoding, [ 0x00, 0xc2, 0x01, 0xf3, 0x03, 0xc5, 0x00, 0xf3 ])
+
+        # labels start a new packet
+        encoding, count = ks.asm(b"r0 = add(r1, r2)\nl1:\nr3 = add(r4, r5)")
+        self.assertEqual(encoding, [ 0x00, 0xc2, 0x01, 0xf3, 0x03, 0xc5, 0x04, 0xf3 ])
+
+
+if __name__ == '__main__':
+    regress.main()
@@ -0,0 +1,49 @@
+#!/usr/bin/python
+
+# Test KS_OPT_FILL_DELAY_SLOTS: in .set reorder mode, an independent
+# instruction before a branch goes to its delay slot instead of a nop.
+
+from keystone import *
+
+import regress
+
+
+class TestMipsFillDelaySlots(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_MIPS, KS_MODE_MIPS32)
+        ks.fill_delay_slots = True
+
+        # jr $ra; move $v0, $a0
+        encoding, count = ks.asm(b"move $v0, $a0; jr $ra")
+        self.assertEqual(encoding, [ 0x08, 0x00, 0xe0, 0x03, 0x25, 0x10, 0x80, 0x00 ])
+        self.assertEqual(ks.bytes_saved, 4)
+
+        # the branch moves up: beq $t3, $zero, 0x100; addu $t0, $t1, $t2
+        encoding, count = ks.asm(b"addu $t0, $t1, $t2; beq $t3, $zero, 0x100")
+        self.assertEqual(encoding, [ 0x3f, 0x00, 0x60, 0x11, 0x21, 0x40, 0x2a, 0x01 ])
+
+        # the branch reads $t0
+        encoding, count = ks.asm(b"addu $t0, $t1, $t2; beq $t0, $zero, 0x100")
+        self.assertEqual(encoding, [ 0x21, 0x40, 0x2a, 0x01, 0x3e, 0x00, 0x00, 0x11,
+                                     0x00, 0x00, 0x00, 0x00 ])
+        self.assertEqual(ks.bytes_saved, 0)
+
+        # jal writes $ra
+        encoding, count = ks.asm(b"addiu $ra, $ra, 8; jal 0x1000")
+        self.assertEqual(encoding, [ 0x08, 0x00, 0xff, 0x27, 0x00, 0x04, 0x00, 0x0c,
+                                     0x00, 0x00, 0x00, 0x00 ])
+
+        # nothing moves across a label
+        encoding, count = ks.asm(b"addu $t0, $t1, $t2; l: beq $t3, $zero, l")
+        self.assertEqual(encoding, [ 0x21, 0x40, 0x2a, 0x01, 0xff, 0xff, 0x60, 0x11,
+                                     0x00, 0x00, 0x00, 0x00 ])
+
+        # nor in .set noreorder mode
+        encoding, count = ks.asm(b".set noreorder; addu $t0, $t1, $t2; jr $ra; nop")
+        self.assertEqual(encoding, [ 0x21, 0x40, 0x2a, 0x01, 0x08, 0x00, 0xe0, 0x03,
+                                     0x00, 0x00, 0x00, 0x00 ])
+
+
+if __name__ == '__main__':
+    regress.main()
@@ -0,0 +1,60 @@
+#!/usr/bin/python
+
+# Test the PPC64 li64 pseudo: load any 64-bit constant with the shortest
+# li/lis/ori/oris/rldicr/rldicl sequence, or a symbol's address with the
+# five instruction @highest/@higher/@h/@l form.
+
+from keystone import *
+
+import regress
+
+
+class TestPPCLi64(regress.RegressTest):
+    def runTest(self):
+        def sym_resolver(symbol, value):
+            if symbol == b"foo":
+                value[0] = 0x123456789abcdef0
+                return True
+            return False
+
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_PPC, KS_MODE_PPC64)
+        ks.sym_resolver = sym_resolver
+
+        # li 3, -1
+        encoding, count = ks.asm(b"li64 3, -1")
+        self.assertEqual(encoding, [ 0xff, 0xff, 0x60, 0x38 ])
+
+        # lis 3, 0x1234; ori 3, 3, 0x5678
+        encoding, count = ks.asm(b"li64 3, 0x12345678")
+        self.assertEqual(encoding, [ 0x34, 0x12, 0x60, 0x3c, 0x78, 0x56, 0x63, 0x60 ])
+
+        # li 3, -1; clrldi 3, 3, 32
+        encoding, count = ks.asm(b"li64 3, 0xffffffff")
+        self.assertEqual(encoding, [ 0xff, 0xff, 0x60, 0x38, 0x20, 0x00, 0x63, 0x78 ])
+
+        # li 3, 0x48d; rotldi 3, 3, 50
+        encoding, count = ks.asm(b"li64 3, 0x1234000000000000")
+        self.assertEqual(encoding, [ 0x8d, 0x04, 0x60, 0x38, 0x46, 0x93, 0x63, 0x78 ])
+
+        # lis 3, 0x1234; ori 3, 3, 0x5678; sldi 3, 3, 32;
+        # oris 3, 3, 0x9abc; ori 3, 3, 0xdef0
+        encoding, count = ks.asm(b"li64 3, 0x123456789abcdef0")
+        self.assertEqual(encoding, [ 0x34, 0x12, 0x60, 0x3c, 0x78, 0x56, 0x63, 0x60,
+                                     0xc6, 0x07, 0x63, 0x78, 0xbc, 0x9a, 0x63, 0x64,
+                                     0xf0, 0xde, 0x63, 0x60 ])
+
+        # a symbol resolved at layout time takes the same five instructions
+        encoding, count = ks.asm(b"li64 5, foo")
+        self.assertEqual(encoding, [ 0x34, 0x12, 0xa0, 0x3c, 0x78, 0x56, 0xa5, 0x60,
+                                     0xc6, 0x07, 0xa5, 0x78, 0xbc, 0x9a, 0xa5, 0x64,
+                                     0xf0, 0xde, 0xa5, 0x60 ])
+
+        # lis 3, l@ha; addi 3, 3, l@l with l at 0x18008
+        encoding, count = ks.asm(b"lis 3, l@ha; addi 3, 3, l@l; l: nop", 0x18000)
+        self.assertEqual(encoding, [ 0x02, 0x00, 0x60, 0x3c, 0x08, 0x80, 0x63, 0x38,
+                                     0x00, 0x00, 0x00, 0x60 ])
+
+
+if __name__ == '__main__':
+    regress.main()
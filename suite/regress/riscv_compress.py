@@ -0,0 +1,35 @@
+#!/usr/bin/python
+
+# Test automatic RVC compression with KS_MODE_RISCVC.
+
+from keystone import *
+
+import regress
+
+
+class TestRiscvCompress(regress.RegressTest):
+    def runTest(self):
+        code = b"addi sp, sp, -16; sd ra, 8(sp); mv a0, a1; lw a0, 4(a0); beqz a0, l; add a0, a0, a1; l: ld ra, 8(sp); ret"
+
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_RISCV, KS_MODE_RISCV64)
+        encoding, count = ks.asm(code)
+        self.assertEqual(len(encoding), 32)
+
+        ks = Ks(KS_ARCH_RISCV, KS_MODE_RISCV64 + KS_MODE_RISCVC)
+        encoding, count = ks.asm(code)
+        self.assertEqual(encoding, [ 0x41, 0x11, 0x06, 0xe4, 0x2e, 0x85,
+                                     0x48, 0x41, 0x11, 0xc1, 0x2e, 0x95,
+                                     0xa2, 0x60, 0x82, 0x80 ])
+
+        # registers outside x8-x15 have no compressed form
+        encoding, count = ks.asm(b"lw a0, 4(a6)")
+        self.assertEqual(encoding, [ 0x03, 0x25, 0x48, 0x00 ])
+
+        # an out of range branch is relaxed back to its 32-bit form
+        encoding, count = ks.asm(b"beqz a0, l; .space 300; l:")
+        self.assertEqual(encoding[:4], [ 0x63, 0x08, 0x05, 0x12 ])
+
+
+if __name__ == '__main__':
+    regress.main()
@@ -0,0 +1,48 @@
+#!/usr/bin/python
+
+# Test the RISC-V li, la, call and tail pseudo-instructions.
+
+from keystone import *
+
+import regress
+
+
+class TestRiscvPseudo(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_RISCV, KS_MODE_RISCV64)
+
+        encoding, count = ks.asm(b"li a0, 0x12345678")
+        self.assertEqual(encoding, [ 0x37, 0x55, 0x34, 0x12, 0x1b, 0x05, 0x85, 0x67 ])
+
+        # addi -1; srli 32 rather than a lui/addiw/slli/addi chain
+        encoding, count = ks.asm(b"li a0, 0xffffffff")
+        self.assertEqual(encoding, [ 0x13, 0x05, 0xf0, 0xff, 0x13, 0x55, 0x05, 0x02 ])
+
+        # lui 0x247; addiw -1875; slli 14; addi -947; slli 12; addi 1511;
+        # slli 13; addi -272
+        encoding, count = ks.asm(b"li a0, 0x123456789abcdef0")
+        self.assertEqual(encoding, [ 0x37, 0x75, 0x24, 0x00, 0x1b, 0x05, 0xd5, 0x8a,
+                                     0x13, 0x15, 0xe5, 0x00, 0x13, 0x05, 0xd5, 0xc4,
+                                     0x13, 0x15, 0xc5, 0x00, 0x13, 0x05, 0x75, 0x5e,
+                                     0x13, 0x15, 0xd5, 0x00, 0x13, 0x05, 0x05, 0xef ])
+
+        encoding, count = ks.asm(b"la a0, d; nop; d: nop")
+        self.assertEqual(encoding[:8], [ 0x17, 0x05, 0x00, 0x00, 0x13, 0x05, 0xc5, 0x00 ])
+
+        encoding, count = ks.asm(b"tail f; .space 5000; f: ret")
+        self.assertEqual(encoding[:8], [ 0x17, 0x13, 0x00, 0x00, 0x67, 0x00, 0x03, 0x39 ])
+
+        # RV32 takes unsigned 32-bit constants too
+        ks = Ks(KS_ARCH_RISCV, KS_MODE_RISCV32)
+        encoding, count = ks.asm(b"li a0, 0xffffffff")
+        self.assertEqual(encoding, [ 0x13, 0x05, 0xf0, 0xff ])
+
+        # with RVC the expansion is compressed as well
+        ks = Ks(KS_ARCH_RISCV, KS_MODE_RISCV64 + KS_MODE_RISCVC)
+        encoding, count = ks.asm(b"li a0, 0x80000000")
+        self.assertEqual(encoding, [ 0x05, 0x45, 0x7e, 0x05 ])
+
+
+if __name__ == '__main__':
+    regress.main()
@@ -0,0 +1,54 @@
+#!/usr/bin/python
+
+# Test that SystemZ memory instructions take the short (12-bit unsigned)
+# or long (20-bit signed) displacement form the displacement needs, for
+# either mnemonic, with symbolic displacements settled at layout time.
+
+from keystone import *
+
+import regress
+
+
+class TestSystemZDispForm(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_SYSTEMZ, KS_MODE_BIG_ENDIAN)
+
+        # l %r1, 100(%r2)
+        encoding, count = ks.asm(b"l %r1, 100(%r2)")
+        self.assertEqual(encoding, [ 0x58, 0x10, 0x20, 0x64 ])
+
+        # ly %r1, 5000(%r2)
+        encoding, count = ks.asm(b"l %r1, 5000(%r2)")
+        self.assertEqual(encoding, [ 0xe3, 0x10, 0x23, 0x88, 0x01, 0x58 ])
+
+        # sty %r1, -8(%r2,%r3)
+        encoding, count = ks.asm(b"st %r1, -8(%r2,%r3)")
+        self.assertEqual(encoding, [ 0xe3, 0x12, 0x3f, 0xf8, 0xff, 0x50 ])
+
+        # symbolic displacements: l %r1, 20(%r2) and ly %r1, 20000(%r2)
+        encoding, count = ks.asm(b"l %r1, d(%r2); .equ d, 20")
+        self.assertEqual(encoding, [ 0x58, 0x10, 0x20, 0x14 ])
+        encoding, count = ks.asm(b"l %r1, d(%r2); .equ d, 20000")
+        self.assertEqual(encoding, [ 0xe3, 0x10, 0x2e, 0x20, 0x04, 0x58 ])
+
+        # SS format: either of the two displacements may be symbolic
+        encoding, count = ks.asm(b"mvc 0(8,%r1), foo(%r2); .equ foo, 6")
+        self.assertEqual(encoding, [ 0xd2, 0x07, 0x10, 0x00, 0x20, 0x06 ])
+        encoding, count = ks.asm(b"mvc foo(8,%r1), 0(%r2); .equ foo, 6")
+        self.assertEqual(encoding, [ 0xd2, 0x07, 0x10, 0x06, 0x20, 0x00 ])
+
+        # an explicit long form is kept by default
+        encoding, count = ks.asm(b"ly %r1, 100(%r2)")
+        self.assertEqual(encoding, [ 0xe3, 0x10, 0x20, 0x64, 0x00, 0x58 ])
+
+        # and shortened with optimize_size (setting an option makes
+        # numbers hexadecimal by default)
+        ks.optimize_size = True
+        encoding, count = ks.asm(b"ly %r1, 0x64(%r2)")
+        self.assertEqual(encoding, [ 0x58, 0x10, 0x20, 0x64 ])
+        self.assertEqual(ks.bytes_saved, 2)
+
+
+if __name__ == '__main__':
+    regress.main()
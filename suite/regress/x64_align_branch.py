@@ -0,0 +1,38 @@
+#!/usr/bin/python
+
+# Test keeping X86 branches off 32-byte boundaries (JCC erratum).
+
+from keystone import *
+
+import regress
+
+
+class TestX64AlignBranch(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+
+        nops = b"nop; " * 30
+
+        # without alignment the cmp/je pair crosses offset 32
+        encoding, count = ks.asm(nops + b"cmp rax, rbx; je 0x100")
+        self.assertEqual(encoding[30:], [ 0x48, 0x39, 0xd8, 0x0f, 0x84, 0xd9, 0x00, 0x00, 0x00 ])
+
+        ks.align_branch_boundary = 32
+
+        # the fused pair is moved past the boundary as a whole
+        encoding, count = ks.asm(nops + b"cmp rax, rbx; je 0x100")
+        self.assertEqual(encoding[30:], [ 0x66, 0x90, 0x48, 0x39, 0xd8, 0x0f, 0x84, 0xd7, 0x00, 0x00, 0x00 ])
+
+        # returns are left alone by default
+        encoding, count = ks.asm(b"nop; " + nops + b"ret")
+        self.assertEqual(encoding[31:], [ 0xc3 ])
+
+        # a return ending at the boundary is padded once selected
+        ks.align_branch_type = KS_OPT_ALIGN_BRANCH_RET
+        encoding, count = ks.asm(b"nop; " + nops + b"ret")
+        self.assertEqual(encoding[31:], [ 0x90, 0xc3 ])
+
+
+if __name__ == '__main__':
+    regress.main()
@@ -0,0 +1,52 @@
+#!/usr/bin/python
+
+# Test ks_analyze(): static throughput & latency of a block on the
+# scheduling model of the CPU chosen with KS_OPT_CPU.
+
+from keystone import *
+
+import regress
+
+
+class TestX64Analyze(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+
+        # the default CPU has no scheduling model
+        try:
+            ks.analyze(b"add rax, rbx")
+            self.assertTrue(False)
+        except KsError as e:
+            self.assertEqual(e.errno, KS_ERR_NO_SCHED_MODEL)
+
+        ks.cpu = "skylake"
+
+        # imul waits for add, the store waits for imul
+        a = ks.analyze(b"add rax, rbx; imul rax, rcx; add rdx, [rsi]; mov [rdi], rax")
+        self.assertEqual(a["latency"], 6)
+        self.assertEqual(a["uops"], 5)
+        self.assertEqual(a["throughput"], 1.25)
+        self.assertEqual([i["ready"] for i in a["insns"]], [ 0, 1, 0, 4 ])
+        self.assertEqual([i["latency"] for i in a["insns"]], [ 1, 3, 6, 1 ])
+        self.assertEqual(a["insns"][1]["pressure"], { "SKLPort1": 1.0 })
+        self.assertEqual(a["pressure"]["SKLPort1"], 1.0)
+
+        # a dependency chain through the flags
+        a = ks.analyze(b"add rax, rbx; adc rcx, rdx")
+        self.assertEqual(a["insns"][1]["ready"], 1)
+
+        # independent adds are only bound by the 4 ALU ports
+        a = ks.analyze(b"add rax, 1; add rbx, 1; add rcx, 1; add rdx, 1; add rsi, 1")
+        self.assertEqual(a["throughput"], 1.25)
+        self.assertEqual(a["latency"], 1)
+
+        # a different CPU, a different model
+        ks.cpu = "btver2"
+        a = ks.analyze(b"add rax, rbx; imul rax, rcx")
+        self.assertEqual(a["latency"], 4)
+        self.assertEqual(a["throughput"], 1.0)
+
+
+if __name__ == '__main__':
+    regress.main()
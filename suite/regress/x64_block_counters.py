@@ -0,0 +1,53 @@
+#!/usr/bin/python
+
+# Test KS_OPT_BLOCK_COUNTERS: each X86 basic block starts by incrementing
+# its own 64-bit counter, and ks_block_counters() maps counters to lines.
+
+from keystone import *
+
+import regress
+
+
+class TestX64BlockCounters(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+        ks.block_counters = 0x601000
+
+        # lea rsp, [rsp-0x80]; push rax; movabs rax, [0x601000];
+        # lea rax, [rax+1]; movabs [0x601000], rax; pop rax;
+        # lea rsp, [rsp+0x80]; ret
+        encoding, count = ks.asm(b"ret")
+        self.assertEqual(encoding, [ 0x48, 0x8d, 0x64, 0x24, 0x80, 0x50,
+                                     0x48, 0xa1, 0x00, 0x10, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                     0x48, 0x8d, 0x40, 0x01,
+                                     0x48, 0xa3, 0x00, 0x10, 0x60, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                     0x58, 0x48, 0x8d, 0xa4, 0x24, 0x80, 0x00, 0x00, 0x00,
+                                     0xc3 ])
+        self.assertEqual(ks.block_lines, [1])
+
+        # a label and the instruction after a branch start new blocks,
+        # and the loop jumps back to the counter of its block
+        encoding, count = ks.asm(b"mov eax, 1\nl: dec eax\njnz l\nret")
+        self.assertEqual(ks.block_lines, [1, 2, 4])
+        self.assertEqual(len(encoding), 3 * 39 + 5 + 2 + 2 + 1)
+        self.assertEqual(encoding[83:87], [ 0xff, 0xc8, 0x75, 0xd5 ])
+
+        # pushfd; add dword ptr [0x601000], 1; adc dword ptr [0x601004], 0;
+        # popfd; nop
+        ks = Ks(KS_ARCH_X86, KS_MODE_32)
+        ks.block_counters = 0x601000
+        encoding, count = ks.asm(b"nop")
+        self.assertEqual(encoding, [ 0x9c, 0x83, 0x05, 0x00, 0x10, 0x60, 0x00, 0x01,
+                                     0x83, 0x15, 0x04, 0x10, 0x60, 0x00, 0x00,
+                                     0x9d, 0x90 ])
+
+        # turned off
+        ks.block_counters = 0
+        encoding, count = ks.asm(b"nop")
+        self.assertEqual(encoding, [ 0x90 ])
+        self.assertEqual(ks.block_lines, [])
+
+
+if __name__ == '__main__':
+    regress.main()
@@ -0,0 +1,60 @@
+#!/usr/bin/python
+
+# Test ks_encode(): an instruction given as a mnemonic and structured
+# operands encodes exactly like the same instruction given as text.
+
+from keystone import *
+
+import regress
+
+
+class TestX64Encode(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+
+        self.assertNotEqual(ks.reg_id("rax"), 0)
+        self.assertEqual(ks.reg_id("RAX"), ks.reg_id("rax"))
+        self.assertEqual(ks.reg_id("foo"), 0)
+
+        forms = [
+            ("add", ["rax", 0x12345678], b"add rax, 0x12345678"),
+            ("vpaddd", ["ymm1", "ymm2", {"base": "rax", "index": "rbx", "scale": 4, "disp": 0x100}],
+                b"vpaddd ymm1, ymm2, [rax+rbx*4+0x100]"),
+            ("mov", [{"base": "rsp", "disp": 8, "size": 4}, 5], b"mov dword ptr [rsp+8], 5"),
+            ("mov", ["ecx", {"segment": "fs", "disp": 0x30}], b"mov ecx, fs:[0x30]"),
+            ("lea", ["rax", {"base": "rip", "disp": 0x30}], b"lea rax, [rip+0x30]"),
+            ("jne", [0x900], b"jne 0x900"),
+            ("call", [0x5000], b"call 0x5000"),
+            ("push", [0x10], b"push 0x10"),
+            ("ret", [], b"ret"),
+        ]
+        for mnemonic, operands, text in forms:
+            encoding, count = ks.asm(text, 0x1000)
+            self.assertEqual(ks.encode(mnemonic, operands, 0x1000), encoding)
+
+        # jmp 0x1010 from 0x1000: jmp short +0xe
+        self.assertEqual(ks.encode("jmp", [0x1010], 0x1000), [ 0xeb, 0x0e ])
+
+        # missing operand, bad scale, bad mnemonic
+        for mnemonic, operands in [("add", ["rax"]),
+                                   ("add", ["rax", {"base": "rax", "scale": 3}]),
+                                   ("foo", [])]:
+            self.assertRaises(KsError, ks.encode, mnemonic, operands)
+
+        # AT&T syntax takes the operands in AT&T order: addl $0x10, %eax
+        ks = Ks(KS_ARCH_X86, KS_MODE_32)
+        ks.syntax = KS_OPT_SYNTAX_ATT
+        self.assertEqual(ks.encode("addl", [0x10, "eax"]), [ 0x83, 0xc0, 0x10 ])
+
+        # only X86 for now
+        ks = Ks(KS_ARCH_ARM, KS_MODE_ARM)
+        try:
+            ks.encode("nop")
+            self.fail("ks_encode() should fail on ARM")
+        except KsError as e:
+            self.assertEqual(e.errno, KS_ERR_ARCH)
+
+
+if __name__ == '__main__':
+    regress.main()
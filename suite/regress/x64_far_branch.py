@@ -0,0 +1,37 @@
+#!/usr/bin/python
+
+# Test that x86-64 call/jmp/jcc to a target beyond +/-2GB go through an
+# 8-byte absolute address instead of failing on the rel32 fixup.
+
+from keystone import *
+
+import regress
+
+
+class TestX64FarBranch(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+
+        # call [rip+2]; jmp .+10; .quad target
+        encoding, count = ks.asm(b"call 0x1000; ret", 0x7fff00000000)
+        self.assertEqual(encoding, [ 0xff, 0x15, 0x02, 0x00, 0x00, 0x00, 0xeb, 0x08,
+                                     0x00, 0x10, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc3 ])
+
+        # jmp [rip]; .quad target
+        encoding, count = ks.asm(b"jmp 0x123456789000")
+        self.assertEqual(encoding, [ 0xff, 0x25, 0x00, 0x00, 0x00, 0x00,
+                                     0x00, 0x90, 0x78, 0x56, 0x34, 0x12, 0x00, 0x00 ])
+
+        # jne .+16; jmp [rip]; .quad target
+        encoding, count = ks.asm(b"je 0x123456789000")
+        self.assertEqual(encoding, [ 0x75, 0x0e, 0xff, 0x25, 0x00, 0x00, 0x00, 0x00,
+                                     0x00, 0x90, 0x78, 0x56, 0x34, 0x12, 0x00, 0x00 ])
+
+        # targets in reach keep their rel32 form
+        encoding, count = ks.asm(b"call 0x7fff00001000", 0x7fff00000000)
+        self.assertEqual(encoding, [ 0xe8, 0xfb, 0x0f, 0x00, 0x00 ])
+
+
+if __name__ == '__main__':
+    regress.main()
@@ -0,0 +1,59 @@
+#!/usr/bin/python
+
+# Test the direct encoder for common x86 forms: whatever it emits must be
+# byte-identical to what the full matcher produces for the same instruction
+# (ks_encode() always goes through the matcher).
+
+from keystone import *
+
+import regress
+
+
+class TestX64FastPath(regress.RegressTest):
+    def runTest(self):
+        forms = [
+            (KS_MODE_64, b"mov rax, rbx", ("mov", ["rax", "rbx"])),
+            (KS_MODE_64, b"mov r12d, 0x12345678", ("mov", ["r12d", 0x12345678])),
+            (KS_MODE_64, b"mov rax, -1", ("mov", ["rax", -1])),
+            (KS_MODE_64, b"mov qword ptr [rsp+8], r13", ("mov", [{"base": "rsp", "disp": 8, "size": 8}, "r13"])),
+            (KS_MODE_64, b"mov eax, dword ptr [rbp]", ("mov", ["eax", {"base": "rbp", "size": 4}])),
+            (KS_MODE_64, b"lea rcx, [r12+r13*8-0x80]", ("lea", ["rcx", {"base": "r12", "index": "r13", "scale": 8, "disp": -0x80}])),
+            (KS_MODE_64, b"add rsp, 0x28", ("add", ["rsp", 0x28])),
+            (KS_MODE_64, b"sub eax, 0x1000", ("sub", ["eax", 0x1000])),
+            (KS_MODE_64, b"xor r9d, r9d", ("xor", ["r9d", "r9d"])),
+            (KS_MODE_64, b"cmp qword ptr [rdi+0x10], 0", ("cmp", [{"base": "rdi", "disp": 0x10, "size": 8}, 0])),
+            (KS_MODE_64, b"test rax, rax", ("test", ["rax", "rax"])),
+            (KS_MODE_64, b"test eax, 0x100", ("test", ["eax", 0x100])),
+            (KS_MODE_64, b"push r15", ("push", ["r15"])),
+            (KS_MODE_64, b"pop rbx", ("pop", ["rbx"])),
+            (KS_MODE_64, b"push 0x7f", ("push", [0x7f])),
+            (KS_MODE_64, b"push 0xffff", ("push", [0xffff])),
+            (KS_MODE_64, b"call rax", ("call", ["rax"])),
+            (KS_MODE_64, b"jmp r11", ("jmp", ["r11"])),
+            (KS_MODE_64, b"ret 8", ("ret", [8])),
+            (KS_MODE_64, b"ret", ("ret", [])),
+            (KS_MODE_32, b"mov ecx, dword ptr [esp+4]", ("mov", ["ecx", {"base": "esp", "disp": 4, "size": 4}])),
+            (KS_MODE_32, b"add dword ptr [eax+ebx*2], 0x80", ("add", [{"base": "eax", "index": "ebx", "scale": 2, "size": 4}, 0x80])),
+            (KS_MODE_32, b"push 0xffffffff", ("push", [0xffffffff])),
+        ]
+        for mode, text, (mnemonic, operands) in forms:
+            ks = Ks(KS_ARCH_X86, mode)
+            encoding, count = ks.asm(text, 0x1000)
+            self.assertEqual(count, 1)
+            self.assertEqual(ks.encode(mnemonic, operands, 0x1000), encoding)
+
+        # forms left to the matcher still assemble in the same block:
+        # label references, relaxable branches, 16-bit registers
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+        encoding, count = ks.asm(b"top: mov ax, bx; add rax, 1; jne top; call top", 0)
+        self.assertEqual(encoding, [ 0x66, 0x89, 0xd8, 0x48, 0x83, 0xc0, 0x01,
+                                     0x75, 0xf7, 0xe8, 0xf2, 0xff, 0xff, 0xff ])
+
+        # a fast-encoded instruction moves the address of the next one:
+        # 0x80000000 is within 2GB of 1 only, so this is RIP-relative
+        encoding, count = ks.asm(b"push rbx; mov ecx, dword ptr [0x80000000]", 0)
+        self.assertEqual(encoding, [ 0x53, 0x8b, 0x0d, 0xf9, 0xff, 0xff, 0x7f ])
+
+
+if __name__ == '__main__':
+    regress.main()
@@ -0,0 +1,38 @@
+#!/usr/bin/python
+
+# Test KS_OPT_FIXED_WIDTH: the size of an instruction must not depend on
+# its immediate, displacement or branch distance.
+
+from keystone import *
+
+import regress
+
+
+class TestX64FixedWidth(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+        ks.fixed_width = True
+
+        small, count = ks.asm(b"add ebx, 1")
+        large, count = ks.asm(b"add ebx, 0x1000")
+        self.assertEqual(small, [ 0x81, 0xc3, 0x01, 0x00, 0x00, 0x00 ])
+        self.assertEqual(len(small), len(large))
+
+        # zero displacement still gets a disp32 field
+        encoding, count = ks.asm(b"mov eax, [rbx]")
+        self.assertEqual(encoding, [ 0x8b, 0x83, 0x00, 0x00, 0x00, 0x00 ])
+
+        # short branches get their rel32 form
+        encoding, count = ks.asm(b"jmp l; l:")
+        self.assertEqual(encoding, [ 0xe9, 0x00, 0x00, 0x00, 0x00 ])
+
+        # Thumb2: narrow instructions are widened where possible
+        ks = Ks(KS_ARCH_ARM, KS_MODE_THUMB)
+        ks.fixed_width = True
+        encoding, count = ks.asm(b"movs r0, #1")
+        self.assertEqual(encoding, [ 0x5f, 0xf0, 0x01, 0x00 ])
+
+
+if __name__ == '__main__':
+    regress.main()
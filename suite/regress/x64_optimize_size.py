@@ -0,0 +1,40 @@
+#!/usr/bin/python
+
+# Test picking the shortest X86 encoding with KS_OPT_OPTIMIZE_SIZE.
+
+from keystone import *
+
+import regress
+
+
+class TestX64OptimizeSize(regress.RegressTest):
+    def runTest(self):
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+
+        code = b"mov rax, 0x80000000; test rbx, 0x40; xor rcx, rcx; vaddps ymm0, ymm1, ymm8"
+
+        encoding, count = ks.asm(code)
+        self.assertEqual(len(encoding), 25)
+        self.assertEqual(ks.bytes_saved, 0)
+
+        ks.optimize_size = True
+        encoding, count = ks.asm(code)
+        self.assertEqual(encoding, [ 0xb8, 0x00, 0x00, 0x00, 0x80,
+                                     0xf6, 0xc3, 0x40,
+                                     0x31, 0xc9,
+                                     0xc5, 0xbc, 0x58, 0xc1 ])
+        self.assertEqual(ks.bytes_saved, 11)
+
+        # r8-r15 still need REX, so the original form is kept
+        encoding, count = ks.asm(b"xor r8, r8")
+        self.assertEqual(encoding, [ 0x4d, 0x31, 0xc0 ])
+        self.assertEqual(ks.bytes_saved, 0)
+
+        # scalar ops take upper elements from the first source: no swap
+        encoding, count = ks.asm(b"vaddss xmm0, xmm1, xmm8")
+        self.assertEqual(encoding, [ 0xc4, 0xc1, 0x72, 0x58, 0xc0 ])
+
+
+if __name__ == '__main__':
+    regress.main()
@@ -0,0 +1,57 @@
+#!/usr/bin/python
+
+# Test KS_OPT_RIP_RELATIVE: x86-64 memory operands naming a symbol are
+# encoded RIP-relative when the symbol is within +/-2GB of the instruction,
+# and with an absolute address (movabs for the accumulator) otherwise.
+
+from keystone import *
+
+import regress
+
+
+class TestX64RipRelativeOpt(regress.RegressTest):
+    def runTest(self):
+        def sym_resolver(symbol, value):
+            if symbol == b"near":
+                value[0] = 0x7fff00002000
+                return True
+            if symbol == b"low":
+                value[0] = 0x2000
+                return True
+            return False
+
+        # Initialize Keystone engine
+        ks = Ks(KS_ARCH_X86, KS_MODE_64)
+        ks.sym_resolver = sym_resolver
+        ks.rip_relative = True
+
+        # mov ecx, [rip+0xffa]
+        encoding, count = ks.asm(b"mov ecx, [near]", 0x7fff00001000)
+        self.assertEqual(encoding, [ 0x8b, 0x0d, 0xfa, 0x0f, 0x00, 0x00 ])
+
+        # the displacement is relative to the end of the instruction,
+        # after the immediate: mov dword ptr [rip+0xff6], 5
+        encoding, count = ks.asm(b"mov dword ptr [near], 5", 0x7fff00001000)
+        self.assertEqual(encoding, [ 0xc7, 0x05, 0xf6, 0x0f, 0x00, 0x00,
+                                     0x05, 0x00, 0x00, 0x00 ])
+
+        # mov eax, [rip+0xffa] rather than movabs eax, [near]
+        encoding, count = ks.asm(b"mov eax, [near]", 0x7fff00001000)
+        self.assertEqual(encoding, [ 0x8b, 0x05, 0xfa, 0x0f, 0x00, 0x00 ])
+
+        # out of reach: movabs eax, [low]
+        encoding, count = ks.asm(b"mov eax, [low]", 0x7fff00001000)
+        self.assertEqual(encoding, [ 0xa1, 0x00, 0x20, 0x00, 0x00,
+                                     0x00, 0x00, 0x00, 0x00 ])
+
+        # out of reach: mov ecx, [0x2000] with a SIB byte
+        encoding, count = ks.asm(b"mov ecx, [low]", 0x7fff00001000)
+        self.assertEqual(encoding, [ 0x8b, 0x0c, 0x25, 0x00, 0x20, 0x00, 0x00 ])
+
+        # a segment override keeps the absolute address
+        encoding, count = ks.asm(b"mov ecx, fs:[low]")
+        self.assertEqual(encoding, [ 0x64, 0x8b, 0x0c, 0x25, 0x00, 0x20, 0x00, 0x00 ])
+
+
+if __name__ == '__main__':
+    regress.main()